@@ -23,6 +23,7 @@
 void    COMM_Init(uint32_t baud);
 void    COMM_Putc(uint8_t c);
 uint8_t COMM_Getc(void);
-uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len);
+uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len, uint8_t size);
+uint16_t COMM_TxFree(void);
 
 #endif /* COMM_H_ */
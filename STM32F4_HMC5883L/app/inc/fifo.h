@@ -45,6 +45,7 @@ uint8_t FIFO_Add      (FIFO_TypeDef* fifo);
 uint8_t FIFO_Push     (FIFO_TypeDef* fifo, uint8_t c);
 uint8_t FIFO_Pop      (FIFO_TypeDef* fifo, uint8_t* c);
 uint8_t FIFO_IsEmpty  (FIFO_TypeDef* fifo);
+void    FIFO_Drop     (FIFO_TypeDef* fifo, uint16_t n);
 
 /**
  * @}
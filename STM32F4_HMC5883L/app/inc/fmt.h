@@ -0,0 +1,59 @@
+/**
+ * @file:   fmt.h
+ * @brief:  Number formatting without printf.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Functions write into a buffer given by the
+ * caller and return the number of characters written
+ * (without the terminating '\0'), so calls can be chained:
+ *
+ * @code
+ * char buf[16];
+ * uint8_t len = FMT_Fixed(buf, sizeof(buf), heading, 2, 0, ' ');
+ * len += FMT_Hex(buf + len, sizeof(buf) - len, status, 2);
+ * @endcode
+ *
+ * If the result doesn't fit or the arguments are out of
+ * range, nothing is written (the buffer holds an empty
+ * string) and 0 is returned.
+ * No static data and no heap is used, so the functions
+ * can be called from interrupts.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  FMT FMT
+ * @brief     Number formatting without printf.
+ */
+
+/**
+ * @addtogroup FMT
+ * @{
+ */
+
+uint8_t FMT_Uint  (char* buf, uint8_t size, uint32_t value, uint8_t width, char pad);
+uint8_t FMT_Int   (char* buf, uint8_t size, int32_t value, uint8_t width, char pad);
+uint8_t FMT_Fixed (char* buf, uint8_t size, int32_t value, uint8_t decimals,
+    uint8_t width, char pad);
+uint8_t FMT_Hex   (char* buf, uint8_t size, uint32_t value, uint8_t digits);
+
+/**
+ * @}
+ */
+
+#endif /* FMT_H_ */
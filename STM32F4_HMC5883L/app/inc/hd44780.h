@@ -4,6 +4,23 @@
  * @date: 	9 kwi 2014
  * @author: Michal Ksiezopolski
  *
+ * @details Text written with LCD_Putc and LCD_Puts goes
+ * to a RAM framebuffer. The display engine, run from a
+ * timer interrupt, compares it with what the display shows
+ * and sends only the changed characters, so a screen can
+ * be redrawn as a whole (LCD_Clear and LCD_Puts) without
+ * flicker and without resending it. No LCD work is done
+ * in the main loop. A redraw between LCD_BeginFrame and
+ * LCD_CommitFrame is sent only when finished, so cells
+ * cleared and written again are never shown blank.
+ *
+ * Custom glyphs are registered with LCD_RegisterGlyph and
+ * printed with LCD_PutGlyph or embedded in strings passed
+ * to LCD_Puts as LCD_GLYPH_ESC followed by the glyph ID
+ * (ID 0 can't be embedded, as it ends the string).
+ * The eight CGRAM slots work as a cache - a glyph is
+ * uploaded only if it isn't already in CGRAM.
+ * Characters beyond the last column are dropped.
  *
  * @verbatim
  * Copyright (c) 2014 Michal Ksiezopolski.
@@ -21,13 +38,24 @@
 
 #include <inttypes.h>
 
+#define LCD_ROWS    2   ///< Number of rows of the display
+#define LCD_COLUMNS 16  ///< Number of visible columns of the display
+
+#define LCD_MAX_GLYPHS  32    ///< Number of custom glyph IDs
+#define LCD_GLYPH_ESC   0x1b  ///< Escape in strings - next byte is glyph ID
+
 void LCD_Init(void);
-void LCD_Update(void);
 void LCD_Home(void);
 void LCD_Position(uint8_t positionX, uint8_t positionY);
 void LCD_Clear(void);
 void LCD_Putc(uint8_t c);
 void LCD_Puts(char* s);
+void LCD_BeginFrame(void);
+void LCD_CommitFrame(void);
 void LCD_ShifDisplay(uint8_t shift, uint8_t dir);
+uint8_t LCD_RegisterGlyph(uint8_t id, const uint8_t* bitmap);
+void LCD_PutGlyph(uint8_t id);
+void LCD_GetGlyphStats(uint32_t* hits, uint32_t* misses);
+void LCD_Benchmark(void);
 
 #endif
@@ -0,0 +1,74 @@
+/**
+ * @file:   histogram.h
+ * @brief:  Histograms with running statistics.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  HIST HIST
+ * @brief     Histograms with running statistics
+ */
+
+/**
+ * @addtogroup HIST
+ * @{
+ */
+
+/**
+ * @brief Bin scales.
+ */
+typedef enum {
+  HIST_SCALE_LINEAR,  ///< Bins of equal width
+  HIST_SCALE_LOG2,    ///< Bin widths doubling
+} HIST_Scale_TypeDef;
+
+/**
+ * @brief Histogram structure typedef.
+ *
+ * @details With linear scale bin i holds values from
+ * low + i*width to low + (i+1)*width - 1. With log2 scale
+ * bin 0 holds values below low + width and bin i > 0
+ * values from low + 2^(i-1)*width to low + 2^i*width - 1.
+ * Values outside the range are counted in the first or
+ * last bin.
+ */
+typedef struct {
+  uint32_t* bins;   ///< Pointer to bin counters
+  uint8_t   len;    ///< Number of bins
+  int32_t   low;    ///< Lower bound of first bin
+  uint32_t  width;  ///< Width of a bin (first bin with log2 scale)
+  HIST_Scale_TypeDef scale; ///< Bin scale (linear if not set)
+  uint32_t  count;  ///< Number of values
+  int32_t   min;    ///< Minimum value
+  int32_t   max;    ///< Maximum value
+  int64_t   sum;    ///< Sum of values
+  uint64_t  sumSq;  ///< Sum of squared values
+} HIST_TypeDef;
+
+uint8_t   HIST_Init     (HIST_TypeDef* hist);
+void      HIST_Insert   (HIST_TypeDef* hist, int32_t value);
+int32_t   HIST_Mean     (HIST_TypeDef* hist);
+uint32_t  HIST_StdDev   (HIST_TypeDef* hist);
+void      HIST_Print    (HIST_TypeDef* hist);
+
+/**
+ * @}
+ */
+
+#endif /* HISTOGRAM_H_ */
@@ -20,8 +20,24 @@
 
 
 #include <inttypes.h>
+#include <pt.h>
+
+#define HMC5883L_CONFIG_LEN 3 ///< Number of configuration registers (A, B, mode)
+
+/**
+ * @brief Register read function (same as HMC5883L_HAL_Read).
+ */
+typedef uint8_t (*HMC5883L_ReadFunc_TypeDef)(uint8_t address);
 
 void HMC5883L_Init(void);
+void HMC5883L_Update(void);
+uint8_t HMC5883L_IsReady(void);
 double HMC5883L_ReadAngle(void);
+double HMC5883L_CalcAngle(int16_t x_s, int16_t y_s);
+void HMC5883L_ReadXYZ(int16_t* x_s, int16_t* y_s, int16_t* z_s);
+PT_THREAD(HMC5883L_ReadXYZThread(PT_TypeDef* pt, int16_t* x_s, int16_t* y_s, int16_t* z_s));
+void HMC5883L_SetSource(HMC5883L_ReadFunc_TypeDef read);
+void HMC5883L_SetSampleCallback(void (*cb)(int16_t x, int16_t y, int16_t z));
+void HMC5883L_GetConfig(uint8_t* buf);
 
 #endif /* HMC5883L_H_ */
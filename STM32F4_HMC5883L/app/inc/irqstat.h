@@ -0,0 +1,134 @@
+/**
+ * @file:   irqstat.h
+ * @brief:  Interrupt duration and latency statistics.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Interrupt handlers are measured with the cycle
+ * counter by an IRQSTAT_ENTER/IRQSTAT_EXIT pair around the
+ * whole handler body:
+ *
+ * @code
+ * void SysTick_Handler(void) {
+ *   IRQSTAT_ENTER(IRQSTAT_SYSTICK);
+ *   IRQSTAT_LATENCY(IRQSTAT_SYSTICK, SysTick->LOAD - SysTick->VAL);
+ *   ...
+ *   IRQSTAT_EXIT(IRQSTAT_SYSTICK);
+ * }
+ * @endcode
+ *
+ * Durations include higher priority interrupts which
+ * preempted the handler, but not the exception entry and
+ * exit (12 cycles each without the FPU context).
+ *
+ * irqStatCycles sums the exclusive time of all measured
+ * handlers, so code which reads it before and after can
+ * leave out the interrupts which preempted it (see prof.h).
+ * A handler which preempts the last instructions of
+ * IRQSTAT_Add is rarely lost from the sum.
+ *
+ * Entry latency - cycles from the hardware event to the
+ * first instruction of the handler body - is reported by
+ * handlers which can tell when the event happened (e.g. from
+ * a timer counter). Handlers which can't, report late events
+ * (e.g. a USART overrun - a byte waited longer than the
+ * receiver can hold it) with IRQSTAT_LATE.
+ *
+ * Build with IRQSTAT_ENABLED defined to 0 to remove all
+ * instrumentation.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef IRQSTAT_H_
+#define IRQSTAT_H_
+
+#include <inttypes.h>
+#include <dwt.h>
+
+/**
+ * @defgroup  IRQSTAT IRQSTAT
+ * @brief     Interrupt duration and latency statistics
+ */
+
+/**
+ * @addtogroup IRQSTAT
+ * @{
+ */
+
+#ifndef IRQSTAT_ENABLED
+  #define IRQSTAT_ENABLED 1 ///< Nonzero - instrumentation compiled in
+#endif
+
+/**
+ * @brief Measured interrupts (names in irqstat.c).
+ */
+typedef enum {
+  IRQSTAT_SYSTICK,  ///< SysTick (latency from the counter)
+  IRQSTAT_USART2,   ///< USART2 (late - receiver overruns)
+  IRQSTAT_TIM2,     ///< Sampler timer (latency from the counter)
+  IRQSTAT_TIM3,     ///< LCD timer
+  IRQSTAT_TIM5,     ///< PC sampling timer (latency from the counter)
+  IRQSTAT_EXTI,     ///< Key press
+  IRQSTAT_TIM7,     ///< Keyboard scan timer (latency from the counter)
+  IRQSTAT_IDS,      ///< Number of interrupts
+} IRQSTAT_Id_TypeDef;
+
+extern volatile uint32_t irqStatCycles; ///< Exclusive cycles of all handlers
+
+#if IRQSTAT_ENABLED
+  /**
+   * @brief Start measuring a handler.
+   * @param id Interrupt (IRQSTAT_Id_TypeDef)
+   */
+  #define IRQSTAT_ENTER(id) \
+    uint32_t irqStatStart = DWT_GetCycles(), irqStatBase = irqStatCycles
+  /**
+   * @brief Stop measuring a handler.
+   * @param id Interrupt (IRQSTAT_Id_TypeDef)
+   */
+  #define IRQSTAT_EXIT(id) \
+    IRQSTAT_Add((id), DWT_GetCycles() - irqStatStart, irqStatBase)
+  /**
+   * @brief Report the entry latency.
+   * @param id Interrupt (IRQSTAT_Id_TypeDef)
+   * @param cycles Cycles from the event to IRQSTAT_ENTER
+   */
+  #define IRQSTAT_LATENCY(id, cycles) IRQSTAT_Latency((id), (cycles))
+  /**
+   * @brief Report an event handled too late.
+   * @param id Interrupt (IRQSTAT_Id_TypeDef)
+   */
+  #define IRQSTAT_LATE(id) IRQSTAT_Late(id)
+  /**
+   * @brief Exclusive cycles of all handlers so far (wraps).
+   */
+  #define IRQSTAT_CYCLES() irqStatCycles
+#else
+  #define IRQSTAT_ENTER(id) (void)0
+  #define IRQSTAT_EXIT(id) (void)0
+  #define IRQSTAT_LATENCY(id, cycles) (void)0
+  #define IRQSTAT_LATE(id) (void)0
+  #define IRQSTAT_CYCLES() 0
+#endif
+
+void    IRQSTAT_Init    (void);
+void    IRQSTAT_Add     (IRQSTAT_Id_TypeDef id, uint32_t cycles, uint32_t base);
+void    IRQSTAT_Latency (IRQSTAT_Id_TypeDef id, uint32_t cycles);
+void    IRQSTAT_Late    (IRQSTAT_Id_TypeDef id);
+void    IRQSTAT_Print   (void);
+void    IRQSTAT_Reset   (void);
+
+/**
+ * @}
+ */
+
+#endif /* IRQSTAT_H_ */
@@ -36,7 +36,54 @@ typedef enum {
   KEY_NONE = 0xff
 } KEY_Id_Typedef;
 
-void KEYS_Init(void);
-uint8_t KEYS_Update(void);
+#define KEYS_ROWS     4   ///< Number of keyboard rows
+#define KEYS_COLUMNS  4   ///< Number of keyboard columns
+#define KEYS_COUNT    (KEYS_ROWS * KEYS_COLUMNS) ///< Number of keys
+
+/**
+ * @brief Bit number of a key in the keyboard state bitmap.
+ */
+#define KEYS_INDEX(column, row) ((column) * KEYS_ROWS + (row))
+
+/**
+ * @brief Keyboard scanning mode.
+ */
+typedef enum {
+  KEYS_MODE_POLL, //!< KEYS_MODE_POLL Scan columns from KEYS_Update
+  KEYS_MODE_IRQ,  //!< KEYS_MODE_IRQ  Wait for key press interrupt, scan with a timer while keys are pressed
+} KEYS_Mode_TypeDef;
+
+/**
+ * @brief Type of key event.
+ */
+typedef enum {
+  KEYS_EVENT_PRESS,       //!< KEYS_EVENT_PRESS      Key was pressed
+  KEYS_EVENT_RELEASE,     //!< KEYS_EVENT_RELEASE    Key was released
+  KEYS_EVENT_REPEAT,      //!< KEYS_EVENT_REPEAT     Key is held (generated periodically)
+  KEYS_EVENT_LONG_PRESS,  //!< KEYS_EVENT_LONG_PRESS Key is held long (generated once per press)
+  KEYS_EVENT_COUNT,       //!< KEYS_EVENT_COUNT      Number of event types
+} KEYS_EventType_TypeDef;
+
+/**
+ * @brief Key event.
+ */
+typedef struct {
+  uint32_t time;                ///< System time of event
+  uint8_t key;                  ///< Key number (KEYS_INDEX)
+  KEYS_EventType_TypeDef type;  ///< Type of event
+} KEYS_Event_TypeDef;
+
+/**
+ * @brief Key event handler.
+ */
+typedef void (*KEYS_Handler_TypeDef)(KEYS_Event_TypeDef* event);
+
+void      KEYS_Init       (KEYS_Mode_TypeDef mode);
+void      KEYS_Update     (void);
+uint16_t  KEYS_GetState   (void);
+uint8_t   KEYS_GetChanges (uint16_t* pressed, uint16_t* released);
+void      KEYS_RegisterHandler  (uint8_t key, KEYS_EventType_TypeDef type,
+                                 KEYS_Handler_TypeDef handler);
+uint16_t  KEYS_GetLostEvents    (void);
 
 #endif /* KEYS_H_ */
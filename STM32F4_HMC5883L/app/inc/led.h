@@ -11,6 +11,21 @@
  * LED number.
  * The various LED ports and pins are defined in
  * led_hal.c and led_hal.h.
+ *
+ * LEDs added with LED_InitPWM are driven by hardware PWM.
+ * Their duty cycle sets brightness (short period) or the
+ * on-time of blinking done by hardware without CPU
+ * (long period). The period is common for all PWM LEDs.
+ *
+ * LED_PlayPattern plays a sequence of brightness steps
+ * on an LED. The pattern is compiled into a buffer of
+ * output values which are copied to the LED by DMA,
+ * so a playing pattern costs no CPU time. Only one
+ * pattern can be played at a time.
+ *
+ * LED_SetMask and LED_ApplyFrame change a group of
+ * LEDs at once - all on/off LEDs are updated with one
+ * atomic write to the port.
  * 
  * @verbatim
  * Copyright (c) 2014 Michal Ksiezopolski.
@@ -26,6 +41,8 @@
 #ifndef LED_H_
 #define LED_H_
 
+#include <inttypes.h>
+
 /**
  * @defgroup  LED LED
  * @brief     Light Emitting Diode control functions.
@@ -53,6 +70,8 @@ typedef enum {
 
 } LED_Number_TypeDef;
 
+#define LED_MASK(led) (1 << (led)) ///< Bit of an LED in LED masks and frames
+
 /**
  * @brief State of an LED.
  */
@@ -60,11 +79,40 @@ typedef enum {
   LED_UNUSED, //!< LED_UNUSED LED not initialized
   LED_OFF,    //!< LED_OFF    Turn off LED
   LED_ON,     //!< LED_ON     Turn on LED
+  LED_PATTERN,//!< LED_PATTERN LED is playing a pattern
 } LED_State_TypeDef;
 
+/**
+ * @brief One step of an LED pattern.
+ */
+typedef struct {
+  uint8_t level;      ///< Brightness in percent (GPIO LEDs are on for level >= 50)
+  uint16_t duration;  ///< Duration of step in pattern ticks
+} LED_Step_TypeDef;
+
+/**
+ * @brief LED pattern - a sequence of steps.
+ */
+typedef struct {
+  const LED_Step_TypeDef* steps;  ///< Steps of the pattern
+  uint8_t len;                    ///< Number of steps
+  uint8_t loop;                   ///< Nonzero - repeat pattern, zero - play once
+  uint16_t tickMs;                ///< Duration of one tick in milliseconds
+} LED_Pattern_TypeDef;
+
 void LED_Init         (LED_Number_TypeDef led);
 void LED_Toggle       (LED_Number_TypeDef led);
 void LED_ChangeState  (LED_Number_TypeDef led, LED_State_TypeDef state);
+LED_State_TypeDef LED_GetState (LED_Number_TypeDef led);
+void LED_InitPWM      (LED_Number_TypeDef led);
+void LED_SetPeriod    (uint32_t periodUs);
+void LED_SetDuty      (LED_Number_TypeDef led, uint8_t duty);
+void LED_SetMask      (uint8_t on, uint8_t off);
+void LED_ApplyFrame   (uint8_t frame);
+void LED_PlayPattern  (LED_Number_TypeDef led, const LED_Pattern_TypeDef* pattern);
+void LED_StopPattern  (void);
+uint16_t LED_CompilePattern(const LED_Pattern_TypeDef* pattern, uint32_t* buf,
+    uint16_t size, uint32_t fullValue, uint32_t onValue, uint32_t offValue);
 
 /**
  * @}
@@ -0,0 +1,156 @@
+/**
+ * @file:   log.h
+ * @brief:  Deferred binary logging.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details A log site only queues the ID of its format
+ * string, a timestamp and the raw argument words - no
+ * text is formatted on the target. LOG_Update (main loop)
+ * sends queued records to COMM as binary frames, which
+ * are turned back into text on the PC by tools/logdecode.py
+ * using the format strings from the ELF file.
+ *
+ * Format strings are placed in the .logstr section, which
+ * is not loaded to flash - the ID of a string is its
+ * address in that section.
+ *
+ * LOG can be used in interrupts. If the queue is full the
+ * record is dropped and counted as lost.
+ *
+ * Modules log with LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG
+ * and LOG_TRACE. Sites above the level of the module set in
+ * log_config.h compile to nothing. A module defines its name
+ * and level before including log.h:
+ *
+ * @code
+ * #define LOG_MODULE        "LED"
+ * #define LOG_MODULE_LEVEL  LOG_LEVEL_LED
+ * #include <log.h>
+ * @endcode
+ *
+ * log.h is included only in source files.
+ *
+ * @warning Arguments are sent as 32-bit words - only
+ * integers, characters and pointers can be printed
+ * (no floating point, no %s).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <inttypes.h>
+#include <log_config.h>
+
+/**
+ * @defgroup  LOG LOG
+ * @brief     Deferred binary logging.
+ */
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+#define LOG_MAX_ARGS  4     ///< Maximum number of arguments of a log site
+#define LOG_ID_REC    1     ///< ID of sample recorder frames (see recorder.h)
+#define LOG_ID_TRACE  2     ///< ID of event trace frames (see trace.h)
+#define LOG_ID_PCPROF 3     ///< ID of PC sample count frames (see pcprof.h)
+
+/*
+ * Define LOG_MODULE before including log.h to
+ * prefix messages with module name.
+ */
+#ifndef LOG_MODULE
+  #define LOG_MODULE "LOG"
+#endif
+
+#ifndef LOG_MODULE_LEVEL
+  #define LOG_MODULE_LEVEL LOG_LEVEL_DEFAULT
+#endif
+
+/**
+ * @brief Count arguments (0 - LOG_MAX_ARGS).
+ * @details 5 to 8 arguments give LOG_TOO_MANY_ARGS, which
+ * isn't defined anywhere - the site doesn't compile.
+ */
+#define LOG_NARGS(args...)  LOG_NARGS_(0, ##args,                     \
+    LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS, LOG_TOO_MANY_ARGS,           \
+    LOG_TOO_MANY_ARGS, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+/**
+ * @brief Queue a log message.
+ * @param fmt Format string (printf style, integer conversions only)
+ * @param args Up to LOG_MAX_ARGS integer arguments
+ */
+#define LOG(fmt, args...)                                           \
+  do {                                                              \
+    static const char logFmt[]                                      \
+      __attribute__((section(".logstr"), used)) =                   \
+      LOG_MODULE "--> " fmt;                                        \
+    LOG_Write((uint32_t)(uintptr_t)logFmt, LOG_NARGS(args), ##args); \
+  } while (0)
+
+/**
+ * @brief Queue a log message of given level if the level is enabled at runtime.
+ */
+#define LOG_AT(level, tag, fmt, args...)                            \
+  do {                                                              \
+    if (logMask & (1 << (level))) {                                 \
+      LOG(tag " " fmt, ##args);                                     \
+    }                                                               \
+  } while (0)
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_ERROR(fmt, args...) LOG_AT(LOG_LEVEL_ERROR, "E", fmt, ##args)
+#else
+  #define LOG_ERROR(fmt, args...) (void)0
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_WARN(fmt, args...) LOG_AT(LOG_LEVEL_WARN, "W", fmt, ##args)
+#else
+  #define LOG_WARN(fmt, args...) (void)0
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_INFO(fmt, args...) LOG_AT(LOG_LEVEL_INFO, "I", fmt, ##args)
+#else
+  #define LOG_INFO(fmt, args...) (void)0
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_DEBUG(fmt, args...) LOG_AT(LOG_LEVEL_DEBUG, "D", fmt, ##args)
+#else
+  #define LOG_DEBUG(fmt, args...) (void)0
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_TRACE
+  #define LOG_TRACE(fmt, args...) LOG_AT(LOG_LEVEL_TRACE, "T", fmt, ##args)
+#else
+  #define LOG_TRACE(fmt, args...) (void)0
+#endif
+
+extern volatile uint8_t logMask; ///< Levels enabled at runtime (bit n - level n)
+
+void    LOG_Write     (uint32_t id, uint8_t nargs, ...);
+void    LOG_Update    (void);
+void    LOG_SetLevel  (uint8_t level);
+uint32_t LOG_Free     (void);
+
+/**
+ * @}
+ */
+
+#endif /* LOG_H_ */
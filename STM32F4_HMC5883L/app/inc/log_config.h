@@ -0,0 +1,67 @@
+/**
+ * @file:   log_config.h
+ * @brief:  Compile-time log levels of the modules.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Log sites above the level of their module
+ * are removed by the preprocessor. Levels of the sites
+ * left in the build can be switched off at runtime
+ * (LOG_SetLevel, ":LOG n" command).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOG_CONFIG_H_
+#define LOG_CONFIG_H_
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+/*
+ * Log levels
+ */
+#define LOG_LEVEL_NONE    0 ///< No logging
+#define LOG_LEVEL_ERROR   1 ///< Errors
+#define LOG_LEVEL_WARN    2 ///< Warnings
+#define LOG_LEVEL_INFO    3 ///< Information
+#define LOG_LEVEL_DEBUG   4 ///< Debugging
+#define LOG_LEVEL_TRACE   5 ///< Tracing
+
+#ifndef LOG_LEVEL_DEFAULT
+  #define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO ///< Level of modules not listed below
+#endif
+
+/*
+ * Levels of modules
+ */
+#define LOG_LEVEL_MAIN      LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_COMM      LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_FIFO      LOG_LEVEL_WARN    ///< Used in interrupts
+#define LOG_LEVEL_HIST      LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_HMC5883L  LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_KEYS      LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_LCD       LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_LED       LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_LOOP      LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_PCPROF    LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_REC       LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_SAMPLER   LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_TIMER     LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_TRACE_BUF LOG_LEVEL_DEFAULT ///< Event trace (TRACE module)
+
+/**
+ * @}
+ */
+
+#endif /* LOG_CONFIG_H_ */
@@ -0,0 +1,67 @@
+/**
+ * @file:   loop.h
+ * @brief:  Main loop latency monitor.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details LOOP_Tick is called at the start of every main
+ * loop iteration. The duration of each iteration goes to a
+ * log2 scaled histogram and iterations longer than the
+ * deadline are counted. The longest iteration is kept with
+ * the longest profiled region (see prof.h) in it, which is
+ * the subsystem that caused it - regions are reported by
+ * PROF_Add, so with PROF_ENABLED 0 the cause is unknown.
+ *
+ * An iteration with nothing left to do ends with LOOP_Idle,
+ * which sleeps until the next interrupt. The sleep is not
+ * counted in the iteration.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOOP_H_
+#define LOOP_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  LOOP LOOP
+ * @brief     Main loop latency monitor
+ */
+
+/**
+ * @addtogroup LOOP
+ * @{
+ */
+
+/*
+ * Nothing blocks the loop - compass transfers are protothreads
+ * stepped by the loop, the LCD and keypad run from timers - so
+ * an iteration takes up to about 2ms. The default deadline
+ * catches anything holding the loop longer.
+ */
+#ifndef LOOP_DEADLINE_US
+  #define LOOP_DEADLINE_US 5000 ///< Default deadline of an iteration in us
+#endif
+
+void    LOOP_Init         (void);
+void    LOOP_Tick         (void);
+void    LOOP_Idle         (void);
+void    LOOP_Blame        (uint8_t region, uint32_t cycles);
+void    LOOP_SetDeadline  (uint32_t us);
+void    LOOP_Print        (void);
+void    LOOP_Reset        (void);
+
+/**
+ * @}
+ */
+
+#endif /* LOOP_H_ */
@@ -0,0 +1,58 @@
+/**
+ * @file:   pcprof.h
+ * @brief:  Statistical profiling by sampling the program counter.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details A high priority timer interrupt samples the
+ * program counter of the interrupted code and the samples
+ * are counted per address. Unlike PROF regions this needs
+ * no instrumentation, so time spent in library code
+ * (StdPeriph, newlib) is found too.
+ *
+ * The counts are sent over COMM by PCPROF_Dump in log frames
+ * with ID LOG_ID_PCPROF: a header (address 0, sampling
+ * frequency, samples, dropped samples), then an address and
+ * its count per frame. tools/pcprof.py maps the addresses
+ * to functions of the firmware ELF file and prints a flat
+ * profile.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef PCPROF_H_
+#define PCPROF_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  PCPROF PCPROF
+ * @brief     Statistical profiling by sampling the program counter
+ */
+
+/**
+ * @addtogroup PCPROF
+ * @{
+ */
+
+#define PCPROF_FREQ   4000  ///< Sampling frequency in Hz
+
+void    PCPROF_Init   (void);
+void    PCPROF_Start  (void);
+void    PCPROF_Stop   (void);
+void    PCPROF_Dump   (void);
+void    PCPROF_Update (void);
+
+/**
+ * @}
+ */
+
+#endif /* PCPROF_H_ */
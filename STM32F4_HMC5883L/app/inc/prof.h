@@ -0,0 +1,107 @@
+/**
+ * @file:   prof.h
+ * @brief:  Cycle count profiling of code regions.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details A region is measured by a PROF_BEGIN/PROF_END pair
+ * in one block:
+ *
+ * @code
+ * PROF_BEGIN(PROF_KEYS);
+ * KEYS_Update();
+ * PROF_END(PROF_KEYS);
+ * @endcode
+ *
+ * The exclusive time of a pass leaves out measured
+ * interrupts which preempted the region (see irqstat.h), the
+ * inclusive time counts them. Both include nested regions.
+ * Exclusive times of regions in the main loop add up to at
+ * most 100%, inclusive times overlap with the interrupts.
+ * Without IRQSTAT_ENABLED both times are inclusive. A region
+ * must not be entered from two contexts (main loop and
+ * interrupt) at the same time.
+ *
+ * Build with PROF_ENABLED defined to 0 to remove all
+ * instrumentation.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <inttypes.h>
+#include <dwt.h>
+#include <irqstat.h>
+
+/**
+ * @defgroup  PROF PROF
+ * @brief     Cycle count profiling of code regions
+ */
+
+/**
+ * @addtogroup PROF
+ * @{
+ */
+
+#ifndef PROF_ENABLED
+  #define PROF_ENABLED 1  ///< Nonzero - instrumentation compiled in
+#endif
+
+/**
+ * @brief Profiled regions (names in prof.c and loop.c).
+ */
+typedef enum {
+  PROF_TIMERS,    ///< Soft timers and their callbacks (TIMER_SoftTimersUpdate)
+  PROF_KEYS,      ///< Keyboard (KEYS_Update)
+  PROF_COMPASS,   ///< Compass initialization (HMC5883L_Update)
+  PROF_COMM,      ///< Frame reception (COMM_GetFrame)
+  PROF_UTILS,     ///< Hexdumps (UTILS_Update)
+  PROF_LOG,       ///< Log transmission (LOG_Update)
+  PROF_REC,       ///< Recorder dump (REC_Update)
+  PROF_LCD,       ///< Heading display
+  PROF_I2C,       ///< Compass reads requested by the sampler (SAMPLER_Update)
+  PROF_USART2,    ///< USART2 interrupt callbacks
+  PROF_REGIONS,   ///< Number of regions
+} PROF_Region_TypeDef;
+
+#if PROF_ENABLED
+  /**
+   * @brief Start measuring a region.
+   * @param region Region (PROF_Region_TypeDef)
+   */
+  #define PROF_BEGIN(region) \
+    uint32_t profStart_##region = DWT_GetCycles(), \
+        profIrq_##region = IRQSTAT_CYCLES()
+  /**
+   * @brief Stop measuring a region.
+   * @param region Region (PROF_Region_TypeDef)
+   */
+  #define PROF_END(region) \
+    PROF_Add((region), DWT_GetCycles() - profStart_##region, \
+        IRQSTAT_CYCLES() - profIrq_##region)
+#else
+  #define PROF_BEGIN(region) (void)0
+  #define PROF_END(region) (void)0
+#endif
+
+void    PROF_Init   (void);
+void    PROF_Add    (PROF_Region_TypeDef region, uint32_t cycles, uint32_t irqCycles);
+void    PROF_Print  (void);
+void    PROF_Reset  (void);
+const char* PROF_Name (uint8_t region);
+
+/**
+ * @}
+ */
+
+#endif /* PROF_H_ */
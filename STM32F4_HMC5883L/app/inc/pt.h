@@ -0,0 +1,163 @@
+/**
+ * @file:   pt.h
+ * @brief:  Lightweight stackless coroutines (protothreads).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Protothreads let a driver write a multi-step
+ * sequence linearly, while every wait returns control
+ * to the main loop instead of blocking the CPU. A thread
+ * is a function declared with PT_THREAD, whose body is
+ * enclosed between PT_BEGIN and PT_END. The function is
+ * called repeatedly (usually from a module's *_Update
+ * function) and continues from the last wait point.
+ *
+ * Based on the local continuations idea by Adam Dunkels.
+ *
+ * @warning Local variables are NOT preserved across waits -
+ * use static variables or fields of a context structure.
+ * Switch statements can't be used inside the thread body.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef PT_H_
+#define PT_H_
+
+#include <inttypes.h>
+#include <timers.h>
+
+/**
+ * @defgroup  PT PT
+ * @brief     Stackless coroutines (protothreads)
+ */
+
+/**
+ * @addtogroup PT
+ * @{
+ */
+
+/**
+ * @brief Protothread control structure.
+ */
+typedef struct {
+  uint16_t lc;    ///< Local continuation (line of last wait point)
+  uint32_t timer; ///< Start time of current PT_WAIT_TIME
+} PT_TypeDef;
+
+/*
+ * Values returned by a protothread function
+ */
+#define PT_WAITING  0 ///< Thread is blocked waiting for a condition
+#define PT_YIELDED  1 ///< Thread yielded voluntarily
+#define PT_EXITED   2 ///< Thread exited with PT_EXIT
+#define PT_ENDED    3 ///< Thread reached PT_END
+
+/**
+ * @brief Declare a protothread function.
+ */
+#define PT_THREAD(declaration) uint8_t declaration
+
+/**
+ * @brief Initialize (or restart) a protothread.
+ */
+#define PT_INIT(pt) ((pt)->lc = 0)
+
+/**
+ * @brief Start of the protothread body.
+ */
+#define PT_BEGIN(pt) { uint8_t ptYieldFlag = 1; (void)ptYieldFlag; \
+  switch ((pt)->lc) { case 0:
+
+/**
+ * @brief End of the protothread body.
+ */
+#define PT_END(pt) } ptYieldFlag = 0; PT_INIT(pt); return PT_ENDED; }
+
+/**
+ * @brief Wait until condition is true (yield until event).
+ */
+#define PT_WAIT_UNTIL(pt, cond)   \
+  do {                            \
+    (pt)->lc = __LINE__;          \
+    case __LINE__:                \
+    if (!(cond)) {                \
+      return PT_WAITING;          \
+    }                             \
+  } while (0)
+
+/**
+ * @brief Wait while condition is true.
+ */
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+/**
+ * @brief Wait until given number of milliseconds has passed (yield until time).
+ */
+#define PT_WAIT_TIME(pt, ms)                                      \
+  do {                                                            \
+    (pt)->timer = TIMER_GetTime();                                \
+    PT_WAIT_UNTIL((pt), TIMER_DelayTimer((ms), (pt)->timer));     \
+  } while (0)
+
+/**
+ * @brief Wait until an event flag is set and consume it.
+ * @details The flag is an lvalue (usually volatile) set by another
+ * thread or an interrupt.
+ */
+#define PT_WAIT_EVENT(pt, ev)     \
+  do {                            \
+    PT_WAIT_UNTIL((pt), (ev));    \
+    (ev) = 0;                     \
+  } while (0)
+
+/**
+ * @brief Give control back to the caller once.
+ */
+#define PT_YIELD(pt)              \
+  do {                            \
+    ptYieldFlag = 0;              \
+    (pt)->lc = __LINE__;          \
+    case __LINE__:                \
+    if (ptYieldFlag == 0) {       \
+      return PT_YIELDED;          \
+    }                             \
+  } while (0)
+
+/**
+ * @brief Exit the protothread (it will start from the beginning on next call).
+ */
+#define PT_EXIT(pt)               \
+  do {                            \
+    PT_INIT(pt);                  \
+    return PT_EXITED;             \
+  } while (0)
+
+/**
+ * @brief Check whether a thread is still running.
+ * @details Evaluates to nonzero while thread is waiting or yielded.
+ */
+#define PT_SCHEDULE(f) ((f) < PT_EXITED)
+
+/**
+ * @brief Run a child protothread and wait until it finishes.
+ */
+#define PT_SPAWN(pt, child, thread)               \
+  do {                                            \
+    PT_INIT(child);                               \
+    PT_WAIT_WHILE((pt), PT_SCHEDULE(thread));     \
+  } while (0)
+
+/**
+ * @}
+ */
+
+#endif /* PT_H_ */
@@ -0,0 +1,73 @@
+/**
+ * @file:   recorder.h
+ * @brief:  Recording and replay of raw compass samples.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details A recording is a stream of 8 byte records (little
+ * endian). The first one describes the compass configuration,
+ * every next one is a sample read from the data registers:
+ * @verbatim
+ * header: 'R' 'C' version confA confB mode 0 0
+ * sample: dt[2] x[2] y[2] z[2]
+ * @endverbatim
+ * dt is the time since the previous sample in ms (since
+ * the start of recording for the first one, 0xffff if longer).
+ *
+ * Recordings go to the on-chip buffer or to COMM, where every
+ * record is sent in a log frame with ID LOG_ID_REC (2 argument
+ * words). tools/logdecode.py --rec saves them to a file.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  REC REC
+ * @brief     Recording and replay of raw compass samples
+ */
+
+/**
+ * @addtogroup REC
+ * @{
+ */
+
+#define REC_RECORD_LEN  8       ///< Size of a record in bytes
+#define REC_BUF_LEN     4096    ///< Size of the on-chip buffer (511 samples)
+#define REC_MAGIC1      'R'     ///< First byte of the header
+#define REC_MAGIC2      'C'     ///< Second byte of the header
+#define REC_VERSION     1       ///< Format version
+
+/**
+ * @brief Destination of recorded samples.
+ */
+typedef enum {
+  REC_SINK_BUFFER,  ///< On-chip buffer
+  REC_SINK_COMM,    ///< Log frames over COMM
+} REC_Sink_TypeDef;
+
+void      REC_Start   (REC_Sink_TypeDef sink);
+void      REC_Stop    (void);
+uint8_t   REC_Play    (void);
+void      REC_Dump    (void);
+void      REC_Update  (void);
+uint32_t  REC_Load    (const uint8_t* data, uint32_t len);
+void      REC_PrintStatus(void);
+
+/**
+ * @}
+ */
+
+#endif /* RECORDER_H_ */
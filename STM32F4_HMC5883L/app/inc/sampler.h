@@ -0,0 +1,46 @@
+/**
+ * @file:   sampler.h
+ * @brief:  Periodic sampling of the compass.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  SAMPLER SAMPLER
+ * @brief     Periodic sampling of the compass
+ */
+
+/**
+ * @addtogroup SAMPLER
+ * @{
+ */
+
+void    SAMPLER_Init          (uint32_t freq);
+void    SAMPLER_Start         (void);
+void    SAMPLER_Stop          (void);
+void    SAMPLER_Update        (void);
+uint8_t SAMPLER_IsBusy        (void);
+uint8_t SAMPLER_GetSample     (int16_t* x, int16_t* y, int16_t* z);
+void    SAMPLER_PrintJitter   (void);
+void    SAMPLER_ResetJitter   (void);
+
+/**
+ * @}
+ */
+
+#endif /* SAMPLER_H_ */
@@ -33,11 +33,30 @@
  * @{
  */
 
+/**
+ * @brief Soft timer mode.
+ */
+typedef enum {
+  TIMER_PERIODIC, //!< TIMER_PERIODIC Timer restarts after overflow
+  TIMER_ONE_SHOT, //!< TIMER_ONE_SHOT Timer stops after overflow
+} TIMER_Mode_TypeDef;
+
+/**
+ * @brief Soft timer callback - gets timer ID and user context.
+ */
+typedef void (*TIMER_Callback_TypeDef)(int8_t id, void* context);
+
 void    TIMER_Init              (uint32_t freq);
 void    TIMER_Delay             (uint32_t ms);
 uint8_t TIMER_DelayTimer        (uint32_t ms, uint32_t startTime);
 int8_t  TIMER_AddSoftTimer      (uint32_t maxVal, void (*fun)(void));
+int8_t  TIMER_CreateSoftTimer   (uint32_t maxVal, TIMER_Mode_TypeDef mode,
+                                 TIMER_Callback_TypeDef fun, void* context);
+void    TIMER_RemoveSoftTimer   (uint8_t id);
 void    TIMER_StartSoftTimer    (uint8_t id);
+void    TIMER_RestartSoftTimer  (uint8_t id, uint32_t maxVal);
+void    TIMER_PauseSoftTimer    (uint8_t id);
+void    TIMER_ResumeSoftTimer   (uint8_t id);
 void    TIMER_SoftTimersUpdate  (void);
 uint32_t TIMER_GetTime          (void);
 /**
@@ -0,0 +1,111 @@
+/**
+ * @file:   trace.h
+ * @brief:  Event trace ring buffer.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Events are stored with the cycle counter in a ring
+ * in RAM, the oldest ones are overwritten. Use TRACE_BEGIN and
+ * TRACE_END around an operation (also in interrupts) and
+ * TRACE_INSTANT for single events:
+ *
+ * @code
+ * TRACE_BEGIN(TRACE_I2C, address);
+ * ...
+ * TRACE_END(TRACE_I2C, address);
+ * @endcode
+ *
+ * The ring is sent over COMM by TRACE_Dump, every event in
+ * a log frame with ID LOG_ID_TRACE (time and info words).
+ * tools/trace2chrome.py converts a capture to Chrome trace JSON
+ * (names are taken from TRACE_Id_TypeDef below).
+ *
+ * Build with TRACE_ENABLED defined to 0 to remove all
+ * instrumentation.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  TRACE TRACE
+ * @brief     Event trace ring buffer
+ */
+
+/**
+ * @addtogroup TRACE
+ * @{
+ */
+
+#ifndef TRACE_ENABLED
+  #define TRACE_ENABLED 1   ///< Nonzero - instrumentation compiled in
+#endif
+
+/**
+ * @brief Event types (bits 24-31 of the info word).
+ */
+typedef enum {
+  TRACE_TYPE_BEGIN,   ///< Start of an operation
+  TRACE_TYPE_END,     ///< End of an operation
+  TRACE_TYPE_INSTANT, ///< Single event
+  TRACE_TYPE_HEADER,  ///< Start of a dump (time - core clock, argument - overhead)
+} TRACE_Type_TypeDef;
+
+/**
+ * @brief Traced operations (bits 16-23 of the info word).
+ */
+typedef enum {
+  TRACE_SYSTICK,      ///< SysTick interrupt
+  TRACE_USART2,       ///< USART2 interrupt
+  TRACE_TIM2,         ///< Sampler timer interrupt
+  TRACE_TIM3,         ///< LCD timer interrupt
+  TRACE_EXTI,         ///< Key press interrupt
+  TRACE_TIM7,         ///< Keyboard scan timer interrupt
+  TRACE_SOFT_TIMER,   ///< Soft timer callback (argument - timer ID)
+  TRACE_KEYS_SCAN,    ///< Keyboard scan
+  TRACE_I2C,          ///< Compass register transfer (argument - address)
+  TRACE_LCD_BYTE,     ///< Byte sent to the LCD (argument - RS << 8 | byte)
+  TRACE_RX_BYTE,      ///< Byte received by USART2 (argument - byte)
+  TRACE_IDS,          ///< Number of operations
+} TRACE_Id_TypeDef;
+
+/**
+ * @brief Info word of an event.
+ */
+#define TRACE_INFO(type, id, arg) \
+  (((uint32_t)(type) << 24) | ((uint32_t)(id) << 16) | ((arg) & 0xffff))
+
+#if TRACE_ENABLED
+  #define TRACE_BEGIN(id, arg)    TRACE_Write(TRACE_INFO(TRACE_TYPE_BEGIN, (id), (arg)))
+  #define TRACE_END(id, arg)      TRACE_Write(TRACE_INFO(TRACE_TYPE_END, (id), (arg)))
+  #define TRACE_INSTANT(id, arg)  TRACE_Write(TRACE_INFO(TRACE_TYPE_INSTANT, (id), (arg)))
+#else
+  #define TRACE_BEGIN(id, arg)    (void)0
+  #define TRACE_END(id, arg)      (void)0
+  #define TRACE_INSTANT(id, arg)  (void)0
+#endif
+
+void    TRACE_Init    (void);
+void    TRACE_Write   (uint32_t info);
+void    TRACE_Start   (void);
+void    TRACE_Stop    (void);
+void    TRACE_Dump    (void);
+void    TRACE_Update  (void);
+
+/**
+ * @}
+ */
+
+#endif /* TRACE_H_ */
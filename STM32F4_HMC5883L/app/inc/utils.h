@@ -30,7 +30,8 @@
  * @{
  */
 
-void hexdump(uint8_t* buf, uint32_t length);
+uint8_t hexdump    (uint8_t* buf, uint32_t length);
+void    UTILS_Update (void);
 
 /**
  * @}
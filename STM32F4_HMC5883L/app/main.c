@@ -17,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
@@ -26,29 +27,63 @@
 #include <keys.h>
 #include <hmc5883l.h>
 #include <hd44780.h>
+#include <utils.h>
+#include <sampler.h>
+#include <fmt.h>
+#include <recorder.h>
+#include <prof.h>
+#include <trace.h>
+#include <pcprof.h>
+#include <loop.h>
+#include <irqstat.h>
+
+#define LOG_MODULE        "MAIN"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_MAIN
+#include <log.h>
 
 #define SYSTICK_FREQ 1000 ///< Frequency of the SysTick set at 1kHz.
 #define COMM_BAUD_RATE 115200UL ///< Baud rate for communication with PC
+#define SAMPLE_FREQ 2 ///< Compass sampling frequency in Hz (one read takes over 200ms with 1kHz I2C)
 
 void softTimerCallback(void);
+static void keyHandler(KEYS_Event_TypeDef* event);
 
-#define DEBUG
+/**
+ * @brief Heartbeat pattern - two short flashes every second.
+ */
+static const LED_Step_TypeDef heartbeatSteps[] = {
+    {100, 1}, {0, 1}, {100, 1}, {0, 7},
+};
+static const LED_Pattern_TypeDef heartbeat = {
+    heartbeatSteps, sizeof(heartbeatSteps)/sizeof(heartbeatSteps[0]), 1, 100
+};
 
-#ifdef DEBUG
-#define print(str, args...) printf("MAIN--> "str"%s",##args,"\r")
-#define println(str, args...) printf("MAIN--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+/**
+ * @brief LCD glyphs - arrows showing direction.
+ */
+enum {
+  GLYPH_NORTH = 1,
+  GLYPH_EAST,
+  GLYPH_SOUTH,
+  GLYPH_WEST,
+};
+static const uint8_t glyphNorth[8] = {0x04, 0x0e, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00};
+static const uint8_t glyphEast[8]  = {0x00, 0x04, 0x02, 0x1f, 0x02, 0x04, 0x00, 0x00};
+static const uint8_t glyphSouth[8] = {0x04, 0x04, 0x04, 0x04, 0x15, 0x0e, 0x04, 0x00};
+static const uint8_t glyphWest[8]  = {0x00, 0x04, 0x08, 0x1f, 0x08, 0x04, 0x00, 0x00};
 
 
 int main(void) {
 	
   COMM_Init(COMM_BAUD_RATE);
-  println("Starting program"); // Print a string to terminal
+  LOG_INFO("Starting program");
 
 	TIMER_Init(SYSTICK_FREQ); // Initialize timer
+	PROF_Init(); // cycle count profiling of the main loop
+	TRACE_Init(); // event trace
+	PCPROF_Init(); // PC sampling profiler (started by :PCPROF ON)
+	LOOP_Init(); // main loop latency monitor
+	IRQSTAT_Init(); // interrupt duration and latency
 
 	// Add a soft timer with callback running every 1000ms
 	int8_t timerID = TIMER_AddSoftTimer(1000, softTimerCallback);
@@ -56,32 +91,47 @@ int main(void) {
 
 	LED_Init(LED0); // Add an LED
 	LED_Init(LED1); // Add an LED
+	LED_PlayPattern(LED1, &heartbeat); // Played by DMA - no CPU time used
 	LED_Init(LED2); // Add an LED
-	LED_Init(LED3); // Add an LED
+	LED_InitPWM(LED3); // Add an LED blinking in hardware
+	LED_SetPeriod(2000000); // 2s period - toggles every second
+	LED_SetDuty(LED3, 50);
+	LED_ChangeState(LED3, LED_ON);
 	LED_Init(LED5); // Add nonexising LED for test
 	LED_ChangeState(LED5, LED_ON);
 
-	KEYS_Init(); // initialize matrix keyboard
+	KEYS_Init(KEYS_MODE_IRQ); // initialize matrix keyboard (interrupt driven)
+	uint8_t key, type;
+	for (key = 0; key < KEYS_COUNT; key++) {
+	  for (type = 0; type < KEYS_EVENT_COUNT; type++) {
+	    KEYS_RegisterHandler(key, type, keyHandler);
+	  }
+	}
 	HMC5883L_Init();
+	SAMPLER_Init(SAMPLE_FREQ); // hardware timer triggered compass reads (run by SAMPLER_Update)
+	SAMPLER_Start();
 
   LCD_Init();
   LCD_Clear();
+  LCD_RegisterGlyph(GLYPH_NORTH, glyphNorth);
+  LCD_RegisterGlyph(GLYPH_EAST, glyphEast);
+  LCD_RegisterGlyph(GLYPH_SOUTH, glyphSouth);
+  LCD_RegisterGlyph(GLYPH_WEST, glyphWest);
 
   uint8_t buf[255];
   uint8_t len;
 
-  uint32_t softTimer = TIMER_GetTime(); // get start time for delay
-
 	while (1) {
 
-	  if (TIMER_DelayTimer(1000, softTimer)) {
-	    LED_Toggle(LED3);
-	    softTimer = TIMER_GetTime(); // get start time for delay
-	  }
+	  LOOP_Tick(); // measure the previous iteration
 
 	  // check for new frames from PC
-	  if (!COMM_GetFrame(buf, &len)) {
-	    println("Got frame of length %d: %s", (int)len, (char*)buf);
+	  PROF_BEGIN(PROF_COMM);
+	  uint8_t frame = COMM_GetFrame(buf, &len, sizeof(buf));
+	  PROF_END(PROF_COMM);
+
+	  if (!frame) {
+	    LOG_DEBUG("Got frame of length %d", (int)len);
 
 	    // control LED0 from terminal
 	    if (!strcmp((char*)buf, ":LED0 ON")) {
@@ -90,11 +140,121 @@ int main(void) {
 	    if (!strcmp((char*)buf, ":LED0 OFF")) {
 	      LED_ChangeState(LED0, LED_OFF);
 	    }
+	    // jitter of intervals between compass read starts
+	    if (!strcmp((char*)buf, ":JITTER")) {
+	      SAMPLER_PrintJitter();
+	    }
+	    if (!strcmp((char*)buf, ":JITTER RESET")) {
+	      SAMPLER_ResetJitter();
+	    }
+	    // runtime log level (0 - none, 5 - trace)
+	    if (!strncmp((char*)buf, ":LOG ", 5)) {
+	      LOG_SetLevel(atoi((char*)buf + 5));
+	    }
+	    // LCD glyph cache statistics
+	    if (!strcmp((char*)buf, ":GLYPHS")) {
+	      uint32_t hits, misses;
+	      LCD_GetGlyphStats(&hits, &misses);
+	      LOG_INFO("Glyph hits=%u misses=%u", (unsigned int)hits, (unsigned int)misses);
+	    }
+	    // LCD bus cost - register HAL against StdPeriph
+	    if (!strcmp((char*)buf, ":LCDBENCH")) {
+	      LCD_Benchmark();
+	    }
+	    // raw sample recording and replay
+	    if (!strcmp((char*)buf, ":REC")) {
+	      REC_PrintStatus();
+	    }
+	    if (!strcmp((char*)buf, ":REC BUF")) {
+	      REC_Start(REC_SINK_BUFFER);
+	    }
+	    if (!strcmp((char*)buf, ":REC COMM")) {
+	      REC_Start(REC_SINK_COMM);
+	    }
+	    if (!strcmp((char*)buf, ":REC STOP")) {
+	      REC_Stop();
+	    }
+	    if (!strcmp((char*)buf, ":REC PLAY")) {
+	      REC_Play();
+	    }
+	    if (!strcmp((char*)buf, ":REC DUMP")) {
+	      REC_Dump();
+	    }
+	    // profiling statistics of the main loop
+	    if (!strcmp((char*)buf, ":PROF")) {
+	      PROF_Print();
+	      PROF_Reset();
+	    }
+	    // event trace
+	    if (!strcmp((char*)buf, ":TRACE")) {
+	      TRACE_Dump();
+	    }
+	    if (!strcmp((char*)buf, ":TRACE ON")) {
+	      TRACE_Start();
+	    }
+	    if (!strcmp((char*)buf, ":TRACE OFF")) {
+	      TRACE_Stop();
+	    }
+	    // PC sampling profiler
+	    if (!strcmp((char*)buf, ":PCPROF")) {
+	      PCPROF_Dump();
+	    }
+	    if (!strcmp((char*)buf, ":PCPROF ON")) {
+	      PCPROF_Start();
+	    }
+	    if (!strcmp((char*)buf, ":PCPROF OFF")) {
+	      PCPROF_Stop();
+	    }
+	    // main loop latency
+	    if (!strcmp((char*)buf, ":LOOP")) {
+	      LOOP_Print();
+	      LOOP_Reset();
+	    }
+	    if (!strncmp((char*)buf, ":LOOP DEADLINE ", 15)) {
+	      LOOP_SetDeadline(atoi((char*)buf + 15));
+	    }
+	    // interrupt statistics
+	    if (!strcmp((char*)buf, ":IRQ")) {
+	      IRQSTAT_Print();
+	      IRQSTAT_Reset();
+	    }
 	  }
 
+		PROF_BEGIN(PROF_TIMERS);
 		TIMER_SoftTimersUpdate(); // run timers
+		PROF_END(PROF_TIMERS);
+
+		PROF_BEGIN(PROF_KEYS);
 		KEYS_Update(); // run keyboard
-		LCD_Update();
+		PROF_END(PROF_KEYS);
+
+		PROF_BEGIN(PROF_COMPASS);
+		HMC5883L_Update(); // run compass initialization
+		PROF_END(PROF_COMPASS);
+
+		PROF_BEGIN(PROF_I2C);
+		SAMPLER_Update(); // run compass reads requested by the timer
+		PROF_END(PROF_I2C);
+
+		PROF_BEGIN(PROF_UTILS);
+		UTILS_Update(); // run pending hexdumps
+		PROF_END(PROF_UTILS);
+
+		PROF_BEGIN(PROF_REC);
+		REC_Update(); // send recorder dump
+		PROF_END(PROF_REC);
+
+		TRACE_Update(); // send trace dump
+		PCPROF_Update(); // send sample counts
+
+		PROF_BEGIN(PROF_LOG);
+		LOG_Update(); // send queued log records
+		PROF_END(PROF_LOG);
+
+		// compass transfers poll the I2C bus, everything else wakes the CPU
+		if (HMC5883L_IsReady() && !SAMPLER_IsBusy()) {
+		  LOOP_Idle(); // sleep until the next interrupt
+		}
 	}
 }
 /**
@@ -106,13 +266,24 @@ void softTimerCallback(void) {
   LED_Toggle(LED0); // Toggle LED
   //printf("Test string sent from STM32F4!!!\r\n"); // Print test string
 
-  double direction = HMC5883L_ReadAngle();
+  int16_t x, y, z;
 
-  println("%.2f", direction);
+  // get latest sample read by the sampler
+  if (SAMPLER_GetSample(&x, &y, &z)) {
+    return; // no new data (e.g. compass is still being initialized)
+  }
+
+  double direction = HMC5883L_CalcAngle(x, y);
 
+  // format in hundredths of a degree - no floating point printf
+  int32_t heading = (int32_t)(direction * 100.0 + 0.5);
   char buf[20];
+  FMT_Fixed(buf, sizeof(buf), heading, 2, 0, ' ');
+
+  LOG_INFO("Heading %ld.%02ld", (long)(heading / 100), (long)(heading % 100));
 
-  sprintf(buf, "%.2f", direction);
+  PROF_BEGIN(PROF_LCD);
+  LCD_BeginFrame();
   LCD_Clear();
   LCD_Position(0,0);
   LCD_Puts("Dir: ");
@@ -120,13 +291,38 @@ void softTimerCallback(void) {
   LCD_Position(0,1);
 
   if (direction < 45 || direction >= 315) {
-    LCD_Puts("North");
+    LCD_Puts("\x1b\x01 North");
   } else if (direction >= 45 && direction < 135) {
-    LCD_Puts("East");
+    LCD_Puts("\x1b\x02 East");
   } else if (direction >= 135 && direction < 225) {
-    LCD_Puts("South");
+    LCD_Puts("\x1b\x03 South");
   } else if (direction >= 225 && direction < 315) {
-    LCD_Puts("West");
+    LCD_Puts("\x1b\x04 West");
   }
+  LCD_CommitFrame();
+  PROF_END(PROF_LCD);
 
 }
+/**
+ * @brief Key event handler - logs the events.
+ * @param event Key event
+ */
+static void keyHandler(KEYS_Event_TypeDef* event) {
+
+  switch (event->type) {
+  case KEYS_EVENT_PRESS:
+    LOG_INFO("Key %u pressed at %u", (unsigned int)event->key, (unsigned int)event->time);
+    break;
+  case KEYS_EVENT_RELEASE:
+    LOG_INFO("Key %u released at %u", (unsigned int)event->key, (unsigned int)event->time);
+    break;
+  case KEYS_EVENT_REPEAT:
+    LOG_DEBUG("Key %u repeat", (unsigned int)event->key);
+    break;
+  case KEYS_EVENT_LONG_PRESS:
+    LOG_INFO("Key %u long press", (unsigned int)event->key);
+    break;
+  default:
+    break;
+  }
+}
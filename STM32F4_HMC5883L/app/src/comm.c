@@ -17,21 +17,13 @@
 
 #include <comm.h>
 #include <fifo.h>
+#include <prof.h>
 // HAL
 #include <uart2.h>
-#include <stdio.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("COMM--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("COMM--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE        "COMM"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_COMM
+#include <log.h>
 
 /**
  * @defgroup  COMM COMM
@@ -52,7 +44,10 @@ static uint8_t txBuffer[COMM_BUF_LEN]; ///< Buffer for transmitted data.
 static FIFO_TypeDef rxFifo; ///< RX FIFO
 static FIFO_TypeDef txFifo; ///< TX FIFO
 
-static uint8_t gotFrame;  ///< Nonzero signals a new frame (number of received frames)
+static volatile uint8_t gotFrame; ///< Nonzero signals a new frame (number of received frames)
+static uint16_t rxFrameLen; ///< Bytes of the frame being received in RX FIFO
+static uint8_t rxDiscard; ///< Rest of the frame being received is dropped
+static volatile uint16_t rxLost; ///< Frames dropped - RX FIFO full
 
 uint8_t COMM_TxCallback(uint8_t* c);
 void    COMM_RxCallback(uint8_t c);
@@ -89,19 +84,27 @@ void COMM_Init(uint32_t baud) {
  * @param c Char to send.
  */
 void COMM_Putc(uint8_t c) {
-  // disable IRQ so it doesn't screw up FIFO count - leads to errors in transmission
-  COMM_HAL_IrqDisable;
+  // mask IRQ so it doesn't screw up FIFO count - leads to errors in transmission
+  uint32_t lock = COMM_HAL_IrqLock();
 
   FIFO_Push(&txFifo,c); // Put data in TX buffer
   COMM_HAL_TxEnable();  // Enable low level transmitter
 
-  // enable IRQ again
-  COMM_HAL_IrqEnable;
+  COMM_HAL_IrqUnlock(lock);
+}
+/**
+ * @brief Get free space in the transmit buffer.
+ * @return Number of chars that can be sent without overflow
+ */
+uint16_t COMM_TxFree(void) {
+
+  return txFifo.len - txFifo.count;
 }
 /**
  * @brief Get a char from USART2
  * @return Received char.
  * @warning Blocking function! Waits until char is received.
+ * Don't mix with COMM_GetFrame - the interrupt keeps track of frames.
  */
 uint8_t COMM_Getc(void) {
 
@@ -110,49 +113,74 @@ uint8_t COMM_Getc(void) {
   while (FIFO_IsEmpty(&rxFifo) == 1); // wait until buffer is not empty
   // buffer not empty => char was received
 
-//  USART_ITConfig(USART2, USART_IT_RXNE, DISABLE); // disable RX interrupt
-
+  uint32_t lock = COMM_HAL_IrqLock(); // FIFO count is changed by the interrupt
   FIFO_Pop(&rxFifo,&c); // Get data from RX buffer
-
-//  USART_ITConfig(USART2, USART_IT_RXNE, ENABLE); // enable RX interrupt
+  COMM_HAL_IrqUnlock(lock);
 
   return c;
 }
 /**
  * @brief Get a complete frame from USART2 (nonblocking)
+ * @details Frames longer than the buffer are dropped. Frames
+ * which didn't fit in the RX FIFO were dropped whole by the
+ * interrupt - a part of a line is never returned.
  * @param buf Buffer for data (data will be null terminated for easier string manipulation)
  * @param len Length not including terminator character
+ * @param size Size of buf (including the null terminator)
  * @retval 0 Received frame
  * @retval 1 No frame in buffer
  * @retval 2 Frame error
- * TODO Add maximum length checking so as not to overflow
  */
-uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len) {
+uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len, uint8_t size) {
 
+  static uint16_t lostReported; ///< rxLost already logged
   uint8_t c;
+  uint32_t lock;
+  uint8_t tooLong = 0;
   *len = 0; // zero out length variable
 
+  uint16_t lost = rxLost;
+  if (lost != lostReported) {
+    LOG_WARN("%u frame(s) lost - RX buffer full", (unsigned int)(uint16_t)(lost - lostReported));
+    lostReported = lost;
+  }
+
   if (gotFrame) {
     while (1) {
 
       // no more data and terminator wasn't reached => error
       if (FIFO_IsEmpty(&rxFifo)) {
         *len = 0;
-        println("Invalid frame");
+        LOG_WARN("Invalid frame");
         return 2;
       }
+      // FIFO count and gotFrame are changed by the interrupt
+      lock = COMM_HAL_IrqLock();
       FIFO_Pop(&rxFifo, &c);
-      buf[(*len)++] = c;
+      COMM_HAL_IrqUnlock(lock);
 
       // if end of frame
       if (c == COMM_TERMINATOR) {
-        (*len)--; // length without terminator character
         buf[*len] = 0; // USART terminator character converted to NULL terminator
         break;
       }
 
+      if (*len + 1 < size) {
+        buf[(*len)++] = c;
+      } else {
+        tooLong = 1; // rest of frame is skipped
+      }
     }
+    lock = COMM_HAL_IrqLock();
     gotFrame--;
+    COMM_HAL_IrqUnlock(lock);
+
+    if (tooLong) {
+      LOG_WARN("Frame too long (max %u)", (unsigned int)(size - 1));
+      *len = 0;
+      buf[0] = 0;
+      return 2;
+    }
     return 0;
 
   } else {
@@ -167,12 +195,29 @@ uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len) {
  */
 void COMM_RxCallback(uint8_t c) {
 
-  uint8_t res = FIFO_Push(&rxFifo, c); // Put data in RX buffer
+  PROF_BEGIN(PROF_USART2);
 
-  // Checking res to ensure no buffer overflow occurred
-  if ((c == COMM_TERMINATOR) && (res == 0)) {
+  if (rxDiscard) {
+    // frame didn't fit - wait for the next one
+    rxDiscard = (c != COMM_TERMINATOR);
+
+  } else if (FIFO_Push(&rxFifo, c)) { // Put data in RX buffer
+
+    // drop the whole frame, so that a part of it
+    // isn't taken for a command
+    FIFO_Drop(&rxFifo, rxFrameLen);
+    rxFrameLen = 0;
+    rxDiscard = (c != COMM_TERMINATOR);
+    rxLost++;
+
+  } else if (c == COMM_TERMINATOR) {
+    rxFrameLen = 0;
     gotFrame++;
+  } else {
+    rxFrameLen++;
   }
+
+  PROF_END(PROF_USART2);
 }
 /**
  * @brief Callback for transmitting data to lower layer
@@ -182,12 +227,13 @@ void COMM_RxCallback(uint8_t c) {
  */
 uint8_t COMM_TxCallback(uint8_t* c) {
 
-  if (FIFO_Pop(&txFifo, c) == 0) { // If buffer not empty
-    return 1;
-  } else {
-    return 0;
-  }
+  PROF_BEGIN(PROF_USART2);
+
+  uint8_t ret = (FIFO_Pop(&txFifo, c) == 0) ? 1 : 0; // 1 if buffer not empty
+
+  PROF_END(PROF_USART2);
 
+  return ret;
 }
 
 /**
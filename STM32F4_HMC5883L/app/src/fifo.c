@@ -16,19 +16,11 @@
  */
 
 #include <fifo.h>
-#include <stdio.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("FIFO--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("FIFO--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+// FIFOs are used in interrupts - no text formatting here
+#define LOG_MODULE        "FIFO"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_FIFO
+#include <log.h>
 
 /**
  * @addtogroup FIFO
@@ -49,7 +41,7 @@
 uint8_t FIFO_Add(FIFO_TypeDef* fifo) {
 
   if (fifo->len == 0 ) {
-    println("Zero FIFO length");
+    LOG_ERROR("Zero FIFO length");
     return 1;
   }
 
@@ -70,7 +62,7 @@ uint8_t FIFO_Push(FIFO_TypeDef* fifo, uint8_t c) {
 
   // Check for overflow
   if (fifo->count == fifo->len) {
-    println("FIFO overflow");
+    LOG_WARN("FIFO overflow (len %u)", fifo->len);
     return 1;
   }
 
@@ -93,9 +85,9 @@ uint8_t FIFO_Push(FIFO_TypeDef* fifo, uint8_t c) {
  */
 uint8_t FIFO_Pop(FIFO_TypeDef* fifo, uint8_t* c) {
 
-  // If FIFO is empty
+  // If FIFO is empty - normal end of a transmission, not logged
+  // (the TX interrupt would queue a record on every drain)
   if (fifo->count == 0) {
-    println("FIFO is empty");
     return 1;
   }
   *c = fifo->buf[fifo->tail++];
@@ -122,6 +114,24 @@ uint8_t FIFO_IsEmpty(FIFO_TypeDef* fifo) {
   return 0;
 }
 
+/**
+ * @brief Removes data pushed last.
+ * @details Takes back the newest bytes, e.g. a frame
+ * which didn't fit whole. Only the pushing side may
+ * call it.
+ * @param fifo Pointer to FIFO structure
+ * @param n Number of bytes (more than the count empties the FIFO)
+ */
+void FIFO_Drop(FIFO_TypeDef* fifo, uint16_t n) {
+
+  if (n > fifo->count) {
+    n = fifo->count;
+  }
+
+  fifo->head = (fifo->head + fifo->len - n) % fifo->len;
+  fifo->count -= n;
+}
+
 /**
  * @}
  */
@@ -0,0 +1,190 @@
+/**
+ * @file:   fmt.c
+ * @brief:  Number formatting without printf.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <fmt.h>
+
+/**
+ * @addtogroup FMT
+ * @{
+ */
+
+#define FMT_MAX_DIGITS 10 ///< Maximum number of decimal digits of uint32_t
+
+static uint8_t FMT_Number(char* buf, uint8_t size, uint8_t negative,
+    uint32_t value, uint8_t decimals, uint8_t width, char pad);
+
+/**
+ * @brief Format an unsigned decimal number.
+ * @param buf Output buffer
+ * @param size Size of output buffer (including '\0')
+ * @param value Value
+ * @param width Minimum width (0 - no padding)
+ * @param pad Padding character (' ' - padded on the left, '0' - leading zeros)
+ * @return Number of characters written
+ */
+uint8_t FMT_Uint(char* buf, uint8_t size, uint32_t value, uint8_t width, char pad) {
+
+  return FMT_Number(buf, size, 0, value, 0, width, pad);
+}
+/**
+ * @brief Format a signed decimal number.
+ * @param buf Output buffer
+ * @param size Size of output buffer (including '\0')
+ * @param value Value
+ * @param width Minimum width including sign (0 - no padding)
+ * @param pad Padding character (' ' or '0')
+ * @return Number of characters written
+ */
+uint8_t FMT_Int(char* buf, uint8_t size, int32_t value, uint8_t width, char pad) {
+
+  return FMT_Fixed(buf, size, value, 0, width, pad);
+}
+/**
+ * @brief Format a fixed point decimal number.
+ * @details E.g. value 12345 with 2 decimals gives "123.45",
+ * -5 with 2 decimals gives "-0.05".
+ * @param buf Output buffer
+ * @param size Size of output buffer (including '\0')
+ * @param value Value scaled by 10^decimals
+ * @param decimals Number of digits after the decimal point (up to 10,
+ * more gives an empty string)
+ * @param width Minimum width including sign and point (0 - no padding)
+ * @param pad Padding character (' ' or '0')
+ * @return Number of characters written
+ */
+uint8_t FMT_Fixed(char* buf, uint8_t size, int32_t value, uint8_t decimals,
+    uint8_t width, char pad) {
+
+  if (value < 0) {
+    // negate in unsigned arithmetic - works for INT32_MIN
+    return FMT_Number(buf, size, 1, 0u - (uint32_t)value, decimals, width, pad);
+  }
+
+  return FMT_Number(buf, size, 0, (uint32_t)value, decimals, width, pad);
+}
+/**
+ * @brief Format a hexadecimal number (lower case, no prefix).
+ * @param buf Output buffer
+ * @param size Size of output buffer (including '\0')
+ * @param value Value
+ * @param digits Minimum number of digits (padded with zeros)
+ * @return Number of characters written
+ */
+uint8_t FMT_Hex(char* buf, uint8_t size, uint32_t value, uint8_t digits) {
+
+  static const char hexDigits[] = "0123456789abcdef";
+
+  uint8_t len = 1;
+  while (len < 8 && (value >> (4 * len))) {
+    len++;
+  }
+  if (digits > len) {
+    len = digits;
+  }
+
+  if (size == 0) {
+    return 0;
+  }
+  if (len >= size) {
+    buf[0] = '\0';
+    return 0;
+  }
+
+  uint8_t i;
+  for (i = 0; i < len; i++) {
+    buf[len - 1 - i] = (i < 8) ? hexDigits[(value >> (4 * i)) & 0x0f] : '0';
+  }
+  buf[len] = '\0';
+
+  return len;
+}
+/**
+ * @brief Format a decimal number.
+ * @param buf Output buffer
+ * @param size Size of output buffer (including '\0')
+ * @param negative Nonzero if minus sign should be printed
+ * @param value Absolute value scaled by 10^decimals
+ * @param decimals Number of digits after the decimal point (up to 10)
+ * @param width Minimum width
+ * @param pad Padding character
+ * @return Number of characters written
+ */
+static uint8_t FMT_Number(char* buf, uint8_t size, uint8_t negative,
+    uint32_t value, uint8_t decimals, uint8_t width, char pad) {
+
+  char digits[FMT_MAX_DIGITS]; // reversed
+  uint8_t count = 0;
+
+  if (size == 0) {
+    return 0;
+  }
+  if (decimals > FMT_MAX_DIGITS) {
+    buf[0] = '\0';
+    return 0;
+  }
+
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+
+  // at least one digit before the point
+  uint16_t intDigits = (count > decimals) ? (count - decimals) : 1;
+  uint16_t len = negative + intDigits + (decimals ? decimals + 1 : 0);
+  uint16_t padLen = (width > len) ? (width - len) : 0;
+
+  if (len + padLen >= size) {
+    buf[0] = '\0';
+    return 0;
+  }
+
+  uint8_t pos = 0;
+  uint8_t i;
+
+  if (pad == '0') { // sign goes before zeros
+    if (negative) {
+      buf[pos++] = '-';
+    }
+    for (i = 0; i < padLen; i++) {
+      buf[pos++] = '0';
+    }
+  } else {
+    for (i = 0; i < padLen; i++) {
+      buf[pos++] = pad;
+    }
+    if (negative) {
+      buf[pos++] = '-';
+    }
+  }
+
+  // digit n (counting from the most significant position)
+  uint16_t total = intDigits + decimals;
+  for (i = 0; i < total; i++) {
+    if (i == intDigits) {
+      buf[pos++] = '.';
+    }
+    uint16_t n = total - 1 - i; // position from the least significant
+    buf[pos++] = (n < count) ? digits[n] : '0';
+  }
+  buf[pos] = '\0';
+
+  return pos;
+}
+
+/**
+ * @}
+ */
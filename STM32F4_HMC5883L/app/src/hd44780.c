@@ -19,20 +19,15 @@
 #include <hd44780.h>
 #include <timers.h>
 #include <fifo.h>
-#include <stdio.h>
+#include <pt.h>
 #include <hd44780_hal.h>
+#include <tim3.h>
+#include <trace.h>
+#include <stm32f4xx.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("LCD--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LCD--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE        "LCD"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_LCD
+#include <log.h>
 
 
 /*
@@ -61,10 +56,29 @@
 #define LCD_ROW2 0x40     ///< Second row address of the LCD
 #define LCD_BUSY_FLAG (1<<7)  ///< Busy flag mask
 
+/*
+ * Execution times (datasheet values at 270kHz plus margin).
+ * The display is driven from the TIM3 interrupt - one nibble
+ * per interrupt - and the next interrupt is scheduled after
+ * the time the display needs.
+ */
+#define LCD_POWER_ON_US     50000 ///< Wait for voltage to settle
+#define LCD_INIT_FIRST_US   4100  ///< Wait after first initialization nibble
+#define LCD_INIT_US         100   ///< Wait after other initialization nibbles
+#define LCD_NIBBLE_US       2     ///< Wait between nibbles of a byte
+#define LCD_EXEC_US         40    ///< Execution time of most commands and data (37us)
+#define LCD_EXEC_LONG_US    1600  ///< Execution time of clear and home (1.52ms)
+#define LCD_POLL_US         10    ///< Busy flag polling period
+
+/*
+ * Define LCD_USE_BUSY_FLAG to wait for the busy flag
+ * after each byte instead of the known execution time.
+ */
+//#define LCD_USE_BUSY_FLAG
 
-static void LCD_SendData(uint8_t data);
-static void LCD_SendCommand(uint8_t command);
+#ifdef LCD_USE_BUSY_FLAG
 static uint8_t LCD_ReadFlag(void);
+#endif
 
 #define LCD_BUF_LEN 256  	///< LCD buffer length
 #define LCD_DATA	  0x80	///< LCD data ID
@@ -73,111 +87,286 @@ static uint8_t LCD_ReadFlag(void);
 static uint8_t lcdBuffer[LCD_BUF_LEN]; 	///< Buffer for LCD commands and data
 static FIFO_TypeDef lcdFifo;			      ///< FIFO for LCD data
 
+static PT_TypeDef lcdEnginePt;  ///< Display engine thread (run from interrupt)
+static PT_TypeDef lcdBytePt;    ///< Byte sending thread (child of engine)
+static volatile uint8_t lcdIdle;///< Nonzero when engine has nothing to send and timer is stopped
+static uint8_t lcdRs;           ///< RS of byte being sent (1 - data, 0 - command)
+static uint8_t lcdByte;         ///< Byte being sent
+static uint16_t lcdDelay;       ///< Execution time of byte being sent
+static uint8_t lcdInitStep;     ///< Current command of initialization sequence
+
 /**
- * @brief Update the LCD.
- *
- * @details This function should be used in the main program loop
- * to send data and commands to the LCD. If the LCD is
- * busy the simply function returns and tries to send
- * the data later.
+ * @brief Commands sent after switching to 4-bit interface.
  */
-void LCD_Update(void) {
+static const uint8_t lcdInitCommands[] = {
+  LCD_FUNCTION|LCD_2_ROWS,  // 2 row display
+  LCD_DISPLAY_ON_OFF|LCD_DISPLAY_ON|LCD_CURSOR_ON|LCD_BLINK_ON, // Turn on display, cursor and blinking
+  LCD_CLEAR_DISPLAY,        // Clear the display
+};
+
+static uint8_t lcdFrame[LCD_ROWS][LCD_COLUMNS]; ///< Framebuffer written by application
+static uint8_t lcdShown[LCD_ROWS][LCD_COLUMNS]; ///< Characters shown by the display
+static volatile uint8_t lcdFrameDirty; ///< Nonzero if framebuffer may differ from display
+static volatile uint8_t lcdFrameHold;  ///< Nonzero while a frame is drawn (framebuffer not sent)
+static uint8_t lcdCursorX;    ///< Framebuffer column of next character
+static uint8_t lcdCursorY;    ///< Framebuffer row of next character
+static uint8_t lcdAddrX;      ///< Column of display DDRAM address counter
+static uint8_t lcdAddrY;      ///< Row of display DDRAM address counter
+static uint8_t lcdAddrValid;  ///< Nonzero if address counter is known
+static uint8_t lcdShifted;    ///< Nonzero if display was shifted
+
+#define LCD_SLOTS       8     ///< Number of CGRAM slots
+#define LCD_SLOT_CODE   0x08  ///< Character code of slot 0 (codes 0-7 mirror 8-15, 0 would end strings)
+#define LCD_NO_GLYPH    0xff  ///< Empty slot
+
+static const uint8_t* lcdGlyphs[LCD_MAX_GLYPHS];  ///< Registered glyph bitmaps
+static uint8_t lcdSlotGlyph[LCD_SLOTS]; ///< Glyph ID held in CGRAM slot
+static uint32_t lcdSlotUsed[LCD_SLOTS]; ///< Time of last use of slot (for LRU)
+static uint32_t lcdGlyphClock;          ///< Counts glyph uses
+static uint32_t lcdGlyphHits;           ///< Glyphs found in CGRAM
+static uint32_t lcdGlyphMisses;         ///< Glyphs uploaded to CGRAM
+
+static uint8_t LCD_NextFrameByte(uint8_t* rs, uint8_t* byte);
+static uint8_t LCD_GlyphSlot(uint8_t id, uint8_t* miss);
+static uint8_t LCD_SlotVisible(uint8_t slot);
+static void LCD_PushCommand(uint8_t command);
+static void LCD_Kick(void);
+static void LCD_Tick(void);
+static PT_THREAD(LCD_EngineThread(PT_TypeDef* pt));
+static PT_THREAD(LCD_ByteThread(PT_TypeDef* pt));
 
-	// If the LCD is still busy - do nothing in current run
-	if (LCD_ReadFlag()  & LCD_BUSY_FLAG)
-		return;
+/**
+ * @brief Wait given time in the engine thread.
+ * @details Schedules the next timer interrupt and returns
+ * from the current one.
+ */
+#define LCD_WAIT_US(pt, us)         \
+  do {                              \
+    LCD_HAL_TimerSchedule(us);      \
+    PT_YIELD(pt);                   \
+  } while (0)
 
-	// If the LCD FIFO is empty
-	if (FIFO_IsEmpty(&lcdFifo))
-		return;
+/**
+ * @brief Initialize the display.
+ * @details The function only starts the initialization sequence
+ * (about 60ms), which is then run from the timer interrupt,
+ * like all later communication with the display. Data and
+ * commands can be written right away - they are sent when
+ * the display is ready.
+ */
+void LCD_Init(void) {
 
-	// First byte identifies whether we're dealing with data
-	// or a command
-	uint8_t dataOrCommand;
-	FIFO_Pop(&lcdFifo, &dataOrCommand);
+	// Initialize the LCD FIFO
+	lcdFifo.buf = lcdBuffer;
+	lcdFifo.len = LCD_BUF_LEN;
 
-	// Second byte is the thing to be sent
-	uint8_t toSend;
-	FIFO_Pop(&lcdFifo, &toSend);
+	FIFO_Add(&lcdFifo);
 
-	switch (dataOrCommand) {
+	// Display is cleared during initialization
+	uint8_t i, j;
+	for (i = 0; i < LCD_ROWS; i++) {
+	  for (j = 0; j < LCD_COLUMNS; j++) {
+	    lcdFrame[i][j] = ' ';
+	    lcdShown[i][j] = ' ';
+	  }
+	}
+	lcdFrameDirty = 0;
+	lcdCursorX = 0;
+	lcdCursorY = 0;
+	lcdAddrX = 0;
+	lcdAddrY = 0;
+	lcdAddrValid = 1;
+	lcdShifted = 0;
+
+	for (i = 0; i < LCD_SLOTS; i++) {
+	  lcdSlotGlyph[i] = LCD_NO_GLYPH;
+	  lcdSlotUsed[i] = 0;
+	}
+	lcdGlyphClock = 0;
+	lcdGlyphHits = 0;
+	lcdGlyphMisses = 0;
 
-	// Send data
-	case LCD_DATA:
-		LCD_SendData(toSend);
-		break;
+	PT_INIT(&lcdEnginePt);
+	lcdIdle = 0;
 
-	// Send a command
-	case LCD_COMMAND:
-		LCD_SendCommand(toSend);
-		break;
+	LCD_HAL_TimerInit(LCD_Tick);
+	LCD_HAL_TimerSchedule(LCD_POWER_ON_US); // engine starts after power on wait
+}
+/**
+ * @brief Timer interrupt callback - runs the engine.
+ */
+static void LCD_Tick(void) {
 
-	default:
-	  println("Neither data nor command!");
-	}
+  LCD_EngineThread(&lcdEnginePt);
 }
 /**
- * @brief Initialize the display.
- * @warning This is a blocking function (can last about 60ms) - only called once though
+ * @brief Display engine.
+ * @details Initializes the display, then sends queued commands
+ * and changes of the framebuffer. Every wait schedules the next
+ * timer interrupt. When there is nothing to send the timer is
+ * not scheduled - LCD_Kick restarts the engine.
+ * @param pt Thread control structure
  */
-void LCD_Init(void) {
+static PT_THREAD(LCD_EngineThread(PT_TypeDef* pt)) {
 
-	// Wait 50 ms for voltage to settle.
-	TIMER_Delay(50);
-	// Initialize hardware
-	LCD_HAL_Init();
+  PT_BEGIN(pt);
 
-	//initialization in 4-bit interface (as per datasheet)
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(5);
+  // Initialize hardware
+  LCD_HAL_Init();
 
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(1);
+  //initialization in 4-bit interface (as per datasheet)
+  LCD_HAL_WriteNibble(0, 0b0011);
+  LCD_WAIT_US(pt, LCD_INIT_FIRST_US);
 
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(1);
+  LCD_HAL_WriteNibble(0, 0b0011);
+  LCD_WAIT_US(pt, LCD_INIT_US);
 
-	LCD_HAL_Write(0b0010);
-	TIMER_Delay(1);
+  LCD_HAL_WriteNibble(0, 0b0011);
+  LCD_WAIT_US(pt, LCD_INIT_US);
 
-	// Initialize the LCD FIFO
-	lcdFifo.buf = lcdBuffer;
-	lcdFifo.len = LCD_BUF_LEN;
+  LCD_HAL_WriteNibble(0, 0b0010);
+  LCD_WAIT_US(pt, LCD_INIT_US);
 
-	FIFO_Add(&lcdFifo);
+  for (lcdInitStep = 0; lcdInitStep < sizeof(lcdInitCommands); lcdInitStep++) {
+    lcdRs = 0;
+    lcdByte = lcdInitCommands[lcdInitStep];
+    lcdDelay = (lcdByte == LCD_CLEAR_DISPLAY) ? LCD_EXEC_LONG_US : LCD_EXEC_US;
+    PT_SPAWN(pt, &lcdBytePt, LCD_ByteThread(&lcdBytePt));
+  }
+
+  while (1) {
+
+    if (!FIFO_IsEmpty(&lcdFifo)) {
+
+      // First byte identifies whether we're dealing with data
+      // or a command, second byte is the thing to be sent
+      uint8_t dataOrCommand;
+      FIFO_Pop(&lcdFifo, &dataOrCommand);
+      FIFO_Pop(&lcdFifo, &lcdByte);
 
-	// 2 row display
-	LCD_SendCommand(LCD_FUNCTION|LCD_2_ROWS);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
-	// Turn on display, cursor and blinking
-	LCD_SendCommand(LCD_DISPLAY_ON_OFF|LCD_DISPLAY_ON|LCD_CURSOR_ON|LCD_BLINK_ON);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
-	// Clear the display
-	LCD_SendCommand(LCD_CLEAR_DISPLAY);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
+      lcdRs = (dataOrCommand == LCD_DATA) ? 1 : 0;
+      lcdDelay = LCD_EXEC_US;
+
+      if (!lcdRs) {
+        if (lcdByte == LCD_CLEAR_DISPLAY || lcdByte == LCD_HOME) {
+          lcdDelay = LCD_EXEC_LONG_US;
+          lcdAddrX = 0;
+          lcdAddrY = 0;
+          lcdAddrValid = 1;
+        } else if ((lcdByte & 0xf0) == LCD_CURSOR_SHIFT ||
+            (lcdByte & 0xc0) == LCD_SET_CGRAM) {
+          // shifting the cursor changes the address counter
+          // and CGRAM commands switch it to CGRAM
+          lcdAddrValid = 0;
+        }
+      }
+
+    } else if (LCD_NextFrameByte(&lcdRs, &lcdByte)) {
+
+      lcdDelay = LCD_EXEC_US;
+
+    } else {
+
+      lcdIdle = 1; // wait for LCD_Kick
+      PT_YIELD(pt);
+      continue;
+    }
+
+    PT_SPAWN(pt, &lcdBytePt, LCD_ByteThread(&lcdBytePt));
+  }
+
+  PT_END(pt);
+}
+/**
+ * @brief Send lcdByte to the display, one nibble per interrupt.
+ * @details Returns after the execution time lcdDelay (or after
+ * the busy flag clears if LCD_USE_BUSY_FLAG is defined).
+ * @param pt Thread control structure
+ */
+static PT_THREAD(LCD_ByteThread(PT_TypeDef* pt)) {
+
+  PT_BEGIN(pt);
+
+  TRACE_INSTANT(TRACE_LCD_BYTE, (lcdRs << 8) | lcdByte);
+
+  // write higher 4 bits first
+  LCD_HAL_WriteNibble(lcdRs, lcdByte >> 4);
+  LCD_WAIT_US(pt, LCD_NIBBLE_US);
+
+  LCD_HAL_WriteNibble(lcdRs, lcdByte);
+
+#ifdef LCD_USE_BUSY_FLAG
+  do {
+    LCD_WAIT_US(pt, LCD_POLL_US);
+  } while (LCD_ReadFlag() & LCD_BUSY_FLAG);
+#else
+  LCD_WAIT_US(pt, lcdDelay);
+#endif
+
+  PT_END(pt);
+}
+/**
+ * @brief Restart the engine if it is idle.
+ * @details Called after new data or commands are written.
+ */
+static void LCD_Kick(void) {
+
+  uint32_t lock = LCD_HAL_IrqLock();
+  if (lcdIdle) {
+    lcdIdle = 0;
+    LCD_HAL_TimerSchedule(LCD_NIBBLE_US);
+  }
+  LCD_HAL_IrqUnlock(lock);
+}
+/**
+ * @brief Queue a command for the engine.
+ * @param command Command to send.
+ */
+static void LCD_PushCommand(uint8_t command) {
+
+  // FIFO is also used by the interrupt
+  uint32_t lock = LCD_HAL_IrqLock();
+  FIFO_Push(&lcdFifo, LCD_COMMAND);
+  FIFO_Push(&lcdFifo, command);
+  LCD_HAL_IrqUnlock(lock);
+
+  LCD_Kick();
 }
 /**
  * @brief Clear the display.
- * @details Write space code 20H to all DDRAM addresses.
- * Sets DDRAM address to 0. Removes all shifts.
- * Sets I/D to 1 (increment mode) in entry mode.
+ * @details Fills the framebuffer with spaces and moves
+ * the cursor to the beginning. The slow clear command
+ * is not used - only characters which were not spaces
+ * are overwritten by the engine.
  */
 void LCD_Clear(void) {
 
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_CLEAR_DISPLAY);
+  uint8_t i, j;
+  for (i = 0; i < LCD_ROWS; i++) {
+    for (j = 0; j < LCD_COLUMNS; j++) {
+      lcdFrame[i][j] = ' ';
+    }
+  }
+
+  lcdCursorX = 0;
+  lcdCursorY = 0;
+  lcdFrameDirty = 1;
+
+  LCD_Kick();
 }
 /**
  * @brief Go to the beginning of the display.
- * @details Sets DDRAM address to 0. Removes all shifts.
+ * @details Moves the cursor to the beginning. Removes all shifts.
  */
 void LCD_Home(void) {
 
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_HOME);
+  lcdCursorX = 0;
+  lcdCursorY = 0;
+
+  if (lcdShifted) {
+    LCD_PushCommand(LCD_HOME);
+    lcdShifted = 0;
+  }
 }
 
 /**
@@ -187,24 +376,13 @@ void LCD_Home(void) {
  */
 void LCD_Position(uint8_t positionX, uint8_t positionY) {
 
-	uint8_t new_pos;
-
-	switch (positionY) {
-
-	case 0:
-		new_pos = LCD_ROW1;
-		break;
-	case 1:
-		new_pos = LCD_ROW2;
-		break;
-	default:
-	  println("Wrong row!");
+	if (positionY >= LCD_ROWS) {
+	  LOG_ERROR("Wrong row!");
 		return;
 	}
 
-	new_pos += positionX;
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_SET_DDRAM | (new_pos & 0x7f));
+	lcdCursorX = positionX;
+	lcdCursorY = positionY;
 }
 /**
  * @brief Shifts the display in the specified direction.
@@ -223,14 +401,17 @@ void LCD_ShifDisplay(uint8_t shift, uint8_t dir) {
 		break;
 
 	default:
-	  println("Wrong direction!");
+	  LOG_ERROR("Wrong direction!");
 		return;
 	}
 
 	uint8_t i;
 	for (i = 0; i < shift; i++) {
-		FIFO_Push(&lcdFifo, LCD_COMMAND);
-		FIFO_Push(&lcdFifo, LCD_CURSOR_SHIFT | LCD_SHIFT_DISPLAY | dir);
+		LCD_PushCommand(LCD_CURSOR_SHIFT | LCD_SHIFT_DISPLAY | dir);
+	}
+
+	if (shift) {
+	  lcdShifted = 1;
 	}
 
 }
@@ -252,7 +433,7 @@ void LCD_SetCursor(uint8_t onOff, uint8_t blink) {
 		break;
 
 	default:
-		println("Wrong parameter in LCD_SetCursor!");
+		LOG_ERROR("Wrong parameter in LCD_SetCursor!");
 		return;
 	}
 
@@ -267,22 +448,31 @@ void LCD_SetCursor(uint8_t onOff, uint8_t blink) {
 		break;
 
 	default:
-	  println("Wrong parameter in LCD_SetCursor!");
+	  LOG_ERROR("Wrong parameter in LCD_SetCursor!");
 		return;
 	}
 
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_DISPLAY_ON_OFF | LCD_DISPLAY_ON | blink | onOff);
+	LCD_PushCommand(LCD_DISPLAY_ON_OFF | LCD_DISPLAY_ON | blink | onOff);
 
 }
 /**
  * @brief Print a character.
+ * @details The character is written to the framebuffer
+ * and sent to the display by the engine if it differs
+ * from the character shown.
  * @param c Character to print.
  */
 void LCD_Putc(uint8_t c) {
 
-	FIFO_Push(&lcdFifo, LCD_DATA);
-	FIFO_Push(&lcdFifo, c);
+  if (lcdCursorX < LCD_COLUMNS) {
+    lcdFrame[lcdCursorY][lcdCursorX] = c;
+    lcdFrameDirty = 1;
+    LCD_Kick();
+  }
+
+  if (lcdCursorX < 0xff) {
+    lcdCursorX++;
+  }
 }
 /**
  * @brief Print a string ended with '\0'.
@@ -292,54 +482,258 @@ void LCD_Puts(char* s) {
 
 	uint8_t i=0;
 	while (s[i]!='\0') {
-		LCD_Putc((uint8_t)s[i++]);
+	  if (s[i] == LCD_GLYPH_ESC) {
+	    if (s[i+1] == '\0') {
+	      break;
+	    }
+	    LCD_PutGlyph((uint8_t)s[i+1]);
+	    i += 2;
+	  } else {
+	    LCD_Putc((uint8_t)s[i++]);
+	  }
 	}
 }
 /**
- * @brief Send data to LCD.
- * @param data Data to send.
+ * @brief Start drawing a frame.
+ * @details The engine doesn't send the framebuffer until
+ * LCD_CommitFrame, so a screen redrawn with LCD_Clear and
+ * LCD_Puts never shows half drawn (e.g. blanked fields).
+ * Queued commands are still sent.
  */
-static void LCD_SendData(uint8_t data) {
+void LCD_BeginFrame(void) {
+  lcdFrameHold = 1;
+}
+/**
+ * @brief Finish drawing a frame and send the changes.
+ */
+void LCD_CommitFrame(void) {
 
-	// rs high and rw low for writing data
-  LCD_HAL_HighRS();
-	LCD_HAL_LowRW();
+  lcdFrameHold = 0;
+  LCD_Kick();
+}
+/**
+ * @brief Register a custom glyph.
+ * @details The glyph is uploaded to CGRAM when it is
+ * first printed.
+ * @param id Glyph ID (0 - LCD_MAX_GLYPHS-1)
+ * @param bitmap 8 rows of 5 pixels (lower bits), has to stay valid
+ * @retval 0 Glyph registered
+ * @retval 1 Error: wrong ID
+ */
+uint8_t LCD_RegisterGlyph(uint8_t id, const uint8_t* bitmap) {
 
-	LCD_HAL_DataOut(); // data as output
+  if (id >= LCD_MAX_GLYPHS) {
+    LOG_ERROR("Wrong glyph ID %d!", (int)id);
+    return 1;
+  }
 
-	// write higher 4 bits first
-	LCD_HAL_HighE();
-	LCD_HAL_Write(data>>4);
-	LCD_HAL_LowE();
+  lcdGlyphs[id] = bitmap;
 
-	LCD_HAL_HighE();
-	LCD_HAL_Write(data);
-	LCD_HAL_LowE();
+  // bitmap changed - drop the old one from CGRAM
+  uint8_t i;
+  for (i = 0; i < LCD_SLOTS; i++) {
+    if (lcdSlotGlyph[i] == id) {
+      lcdSlotGlyph[i] = LCD_NO_GLYPH;
+      lcdSlotUsed[i] = 0;
+    }
+  }
 
+  return 0;
 }
-
 /**
- * @brief Send a command to the LCD.
- * @param command Command to send.
+ * @brief Print a custom glyph.
+ * @details If the glyph is not in CGRAM, it is uploaded
+ * to the least recently used slot, preferably one not
+ * shown on the display.
+ * @param id Glyph ID
  */
-static void LCD_SendCommand(uint8_t command) {
+void LCD_PutGlyph(uint8_t id) {
+
+  if (id >= LCD_MAX_GLYPHS || lcdGlyphs[id] == 0) {
+    LOG_ERROR("Unknown glyph %d!", (int)id);
+    return;
+  }
+
+  uint8_t miss;
+  uint8_t slot = LCD_GlyphSlot(id, &miss);
+
+  if (miss) {
+    // upload goes before any later framebuffer changes,
+    // the whole upload is queued at once
+    uint32_t lock = LCD_HAL_IrqLock();
+    FIFO_Push(&lcdFifo, LCD_COMMAND);
+    FIFO_Push(&lcdFifo, LCD_SET_CGRAM | (slot << 3));
+    uint8_t i;
+    for (i = 0; i < 8; i++) {
+      FIFO_Push(&lcdFifo, LCD_DATA);
+      FIFO_Push(&lcdFifo, lcdGlyphs[id][i] & 0x1f);
+    }
+    LCD_HAL_IrqUnlock(lock);
+    LCD_Kick();
+  }
+
+  LCD_Putc(LCD_SLOT_CODE + slot);
+}
+/**
+ * @brief Get glyph cache statistics.
+ * @details Every miss costs 9 bytes sent to the display.
+ * @param hits Returns number of glyphs found in CGRAM
+ * @param misses Returns number of glyphs uploaded
+ */
+void LCD_GetGlyphStats(uint32_t* hits, uint32_t* misses) {
 
-	// rs low and rw low for writing command
-  LCD_HAL_LowRW();
-  LCD_HAL_LowRS();
+  *hits = lcdGlyphHits;
+  *misses = lcdGlyphMisses;
+}
+/**
+ * @brief Log the cost of bus operations.
+ * @details Compares the register level HAL with the StdPeriph
+ * calls it replaced (cycle counter, fastest of several runs).
+ * The engine is held off while measuring.
+ */
+void LCD_Benchmark(void) {
 
-	LCD_HAL_DataOut(); // data as output
+  LCD_HAL_Bench_TypeDef fast, std;
 
-	// write higher 4 bits first
-	LCD_HAL_HighE();
-	LCD_HAL_Write(command>>4);
-	LCD_HAL_LowE();
+  uint32_t lock = LCD_HAL_IrqLock();
+  LCD_HAL_Benchmark(&fast, &std);
+  LCD_HAL_IrqUnlock(lock);
 
-	LCD_HAL_HighE();
-	LCD_HAL_Write(command);
-	LCD_HAL_LowE();
+  LOG_INFO("Write nibble: %u cycles (StdPeriph %u)",
+      (unsigned int)fast.write, (unsigned int)std.write);
+  LOG_INFO("Data turnaround: %u cycles (StdPeriph %u)",
+      (unsigned int)fast.turnaround, (unsigned int)std.turnaround);
 }
-
+/**
+ * @brief Find CGRAM slot for a glyph.
+ * @details Uses no hardware. On a miss the least recently
+ * used slot not visible on the display is chosen. If all
+ * slots are visible, the least recently used one is taken
+ * (the characters shown with it will change).
+ * @param id Glyph ID
+ * @param miss Returns 1 if glyph has to be uploaded to slot
+ * @return Slot number
+ */
+static uint8_t LCD_GlyphSlot(uint8_t id, uint8_t* miss) {
+
+  uint8_t i;
+  lcdGlyphClock++;
+
+  for (i = 0; i < LCD_SLOTS; i++) {
+    if (lcdSlotGlyph[i] == id) {
+      lcdSlotUsed[i] = lcdGlyphClock;
+      lcdGlyphHits++;
+      *miss = 0;
+      return i;
+    }
+  }
+
+  int8_t victim = -1;       // LRU slot not visible
+  uint8_t victimAny = 0;    // LRU slot
+
+  for (i = 0; i < LCD_SLOTS; i++) {
+    if (lcdSlotUsed[i] < lcdSlotUsed[victimAny]) {
+      victimAny = i;
+    }
+    if ((victim < 0 || lcdSlotUsed[i] < lcdSlotUsed[victim]) &&
+        (lcdSlotGlyph[i] == LCD_NO_GLYPH || !LCD_SlotVisible(i))) {
+      victim = i;
+    }
+  }
+
+  if (victim < 0) {
+    victim = victimAny;
+  }
+
+  lcdSlotGlyph[victim] = id;
+  lcdSlotUsed[victim] = lcdGlyphClock;
+  lcdGlyphMisses++;
+  *miss = 1;
+  return victim;
+}
+/**
+ * @brief Check whether a CGRAM slot is used by the framebuffer.
+ * @details The cell at the cursor doesn't count - the glyph
+ * being placed overwrites it.
+ * @param slot Slot number
+ * @retval 1 Slot is visible
+ * @retval 0 Slot is not visible
+ */
+static uint8_t LCD_SlotVisible(uint8_t slot) {
+
+  uint8_t x, y;
+  for (y = 0; y < LCD_ROWS; y++) {
+    for (x = 0; x < LCD_COLUMNS; x++) {
+      if (x == lcdCursorX && y == lcdCursorY) {
+        continue;
+      }
+      if (lcdFrame[y][x] == LCD_SLOT_CODE + slot ||
+          lcdShown[y][x] == LCD_SLOT_CODE + slot) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+/**
+ * @brief Find next change of the framebuffer.
+ * @details Searches for a changed character starting from the
+ * current DDRAM address, so runs of changed characters are sent
+ * without repositioning. Returns either the character (if the
+ * address is right) or the address command and assumes it
+ * is sent. Uses no hardware.
+ * @param rs Returns 1 for data, 0 for command
+ * @param byte Returns byte to send
+ * @retval 1 Byte to send
+ * @retval 0 Display shows the framebuffer
+ */
+static uint8_t LCD_NextFrameByte(uint8_t* rs, uint8_t* byte) {
+
+  if (!lcdFrameDirty || lcdFrameHold) {
+    return 0;
+  }
+
+  // Cleared before the search, so that a change written
+  // during the search is not lost
+  lcdFrameDirty = 0;
+
+  uint8_t start = 0;
+  if (lcdAddrValid && lcdAddrX < LCD_COLUMNS) {
+    start = lcdAddrY * LCD_COLUMNS + lcdAddrX;
+  }
+
+  uint8_t i;
+  for (i = 0; i < LCD_ROWS * LCD_COLUMNS; i++) {
+
+    uint8_t cell = (start + i) % (LCD_ROWS * LCD_COLUMNS);
+    uint8_t x = cell % LCD_COLUMNS;
+    uint8_t y = cell / LCD_COLUMNS;
+    uint8_t c = lcdFrame[y][x];
+
+    if (c == lcdShown[y][x]) {
+      continue;
+    }
+
+    lcdFrameDirty = 1; // there may be more changes
+
+    if (lcdAddrValid && lcdAddrX == x && lcdAddrY == y) {
+      *rs = 1;
+      *byte = c;
+      lcdShown[y][x] = c;
+      lcdAddrX++; // address counter increments after write
+    } else {
+      *rs = 0;
+      *byte = LCD_SET_DDRAM | ((y ? LCD_ROW2 : LCD_ROW1) + x);
+      lcdAddrX = x;
+      lcdAddrY = y;
+      lcdAddrValid = 1;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+#ifdef LCD_USE_BUSY_FLAG
 /**
  * @brief Read busy flag.
  * @return Returns read byte.
@@ -353,7 +747,10 @@ static uint8_t LCD_ReadFlag(void) {
 	uint8_t result = 0;
 	result = (LCD_HAL_Read() << 4);
 	result |= LCD_HAL_Read();
+
+	LCD_HAL_LowRW();
+	LCD_HAL_DataOut(); // back to writing
 	return result;
 
 }
-
+#endif
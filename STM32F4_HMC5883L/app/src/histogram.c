@@ -0,0 +1,202 @@
+/**
+ * @file:   histogram.c
+ * @brief:  Histograms with running statistics.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Only integer arithmetic is used, so values
+ * can be inserted from interrupt handlers.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <histogram.h>
+#include <stdio.h>
+
+#define LOG_MODULE        "HIST"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_HIST
+#include <log.h>
+
+/**
+ * @addtogroup HIST
+ * @{
+ */
+
+static int32_t HIST_BinLow(HIST_TypeDef* hist, uint8_t bin);
+static uint32_t HIST_Sqrt(uint64_t x);
+
+/**
+ * @brief Initialize (clear) a histogram.
+ *
+ * @details To add a histogram, you need to define a HIST_TypeDef
+ * structure and initialize it with the bin buffer, number of bins,
+ * lower bound and bin width. The rest is handled automatically.
+ *
+ * @param hist Pointer to histogram structure
+ * @retval 0 Histogram initialized successfully
+ * @retval 1 Error: no bins or zero bin width
+ */
+uint8_t HIST_Init(HIST_TypeDef* hist) {
+
+  if (hist->len == 0 || hist->width == 0) {
+    LOG_ERROR("Wrong histogram parameters");
+    return 1;
+  }
+
+  uint8_t i;
+  for (i = 0; i < hist->len; i++) {
+    hist->bins[i] = 0;
+  }
+
+  hist->count = 0;
+  hist->min   = INT32_MAX;
+  hist->max   = INT32_MIN;
+  hist->sum   = 0;
+  hist->sumSq = 0;
+
+  return 0;
+}
+/**
+ * @brief Insert a value into the histogram.
+ * @param hist Pointer to histogram structure
+ * @param value New value
+ */
+void HIST_Insert(HIST_TypeDef* hist, int32_t value) {
+
+  int64_t offset = (int64_t)value - hist->low;
+  uint32_t bin;
+
+  if (offset < 0) { // below range - first bin
+    bin = 0;
+  } else {
+    uint64_t steps = (uint64_t)offset / hist->width;
+    if (hist->scale == HIST_SCALE_LOG2) {
+      bin = 0;
+      while (steps) { // number of significant bits
+        bin++;
+        steps >>= 1;
+      }
+    } else {
+      bin = steps > hist->len ? hist->len : steps;
+    }
+    if (bin >= hist->len) { // above range - last bin
+      bin = hist->len - 1;
+    }
+  }
+
+  hist->bins[bin]++;
+  hist->count++;
+
+  if (value < hist->min) {
+    hist->min = value;
+  }
+  if (value > hist->max) {
+    hist->max = value;
+  }
+
+  hist->sum   += value;
+  hist->sumSq += (uint64_t)((int64_t)value * value);
+}
+/**
+ * @brief Mean of inserted values.
+ * @param hist Pointer to histogram structure
+ * @return Mean value (0 if histogram is empty)
+ */
+int32_t HIST_Mean(HIST_TypeDef* hist) {
+
+  if (hist->count == 0) {
+    return 0;
+  }
+
+  return (int32_t)(hist->sum / (int64_t)hist->count);
+}
+/**
+ * @brief Standard deviation of inserted values.
+ * @param hist Pointer to histogram structure
+ * @return Standard deviation (0 if histogram is empty)
+ */
+uint32_t HIST_StdDev(HIST_TypeDef* hist) {
+
+  if (hist->count == 0) {
+    return 0;
+  }
+
+  int64_t mean = hist->sum / (int64_t)hist->count;
+  uint64_t meanSq = hist->sumSq / hist->count;
+  uint64_t sq = (uint64_t)(mean * mean);
+
+  // variance = E[x^2] - E[x]^2
+  if (meanSq <= sq) {
+    return 0;
+  }
+
+  return HIST_Sqrt(meanSq - sq);
+}
+/**
+ * @brief Print statistics and bins of the histogram.
+ * @param hist Pointer to histogram structure
+ */
+void HIST_Print(HIST_TypeDef* hist) {
+
+  printf("n=%lu min=%ld max=%ld mean=%ld stddev=%lu\r\n",
+      (unsigned long)hist->count, (long)hist->min, (long)hist->max,
+      (long)HIST_Mean(hist), (unsigned long)HIST_StdDev(hist));
+
+  uint8_t i;
+  for (i = 0; i < hist->len; i++) {
+    printf("[%ld] %lu\r\n", (long)HIST_BinLow(hist, i),
+        (unsigned long)hist->bins[i]);
+  }
+}
+/**
+ * @brief Lower bound of a bin.
+ * @param hist Pointer to histogram structure
+ * @param bin Bin number
+ * @return Smallest value counted in the bin (except the first bin)
+ */
+static int32_t HIST_BinLow(HIST_TypeDef* hist, uint8_t bin) {
+
+  if (hist->scale == HIST_SCALE_LOG2) {
+    return bin ? hist->low + (int32_t)(hist->width << (bin - 1)) : hist->low;
+  }
+
+  return hist->low + (int32_t)(bin * hist->width);
+}
+/**
+ * @brief Integer square root.
+ * @param x Value
+ * @return Square root of x rounded down
+ */
+static uint32_t HIST_Sqrt(uint64_t x) {
+
+  uint64_t result = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > x) {
+    bit >>= 2;
+  }
+
+  while (bit != 0) {
+    if (x >= result + bit) {
+      x -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return (uint32_t)result;
+}
+
+/**
+ * @}
+ */
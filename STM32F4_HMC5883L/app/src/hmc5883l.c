@@ -25,17 +25,10 @@
 #include <hmc5883l.h>
 #include <hmc5883l_hal.h>
 #include <math.h>
-#include <stdio.h>
 
-#define DEBUG
-
-#ifdef DEBUG
-#define print(str, args...) printf("HMC5883L--> "str"%s",##args,"\r")
-#define println(str, args...) printf("HMC5883L--> "str"%s",##args,"\r\n")
-#else
-#define print(str, args...) (void)0
-#define println(str, args...) (void)0
-#endif
+#define LOG_MODULE        "HMC5883L"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_HMC5883L
+#include <log.h>
 
 /*
  * Register addresses
@@ -84,35 +77,95 @@ typedef enum {
   HMC6883L_75,   //!< HMC6883L_75
 } HMC5883L_DataRate_TypeDef;
 
-void HMC5883L_ReadXYZ(int16_t* x_s, int16_t* y_s, int16_t* z_s);
 void HMC5883L_ChangeMode(HMC5883L_Mode_TypeDef mode);
 
+static PT_THREAD(HMC5883L_InitThread(PT_TypeDef* pt));
+static void HMC5883L_Sample(const uint8_t* data, int16_t* x_s, int16_t* y_s, int16_t* z_s);
+
+static PT_TypeDef initPt;   ///< Initialization thread
+static PT_TypeDef halPt;    ///< Thread for I2C transfers of initialization
+static uint8_t regVal;      ///< Register value read by initialization
+static PT_TypeDef xyzHalPt; ///< Thread for I2C transfers of measurement reads
+static uint8_t xyzData[6];  ///< Data output registers read by HMC5883L_ReadXYZThread
+static uint8_t xyzIndex;    ///< Next data register of HMC5883L_ReadXYZThread
+/// Register reads of the measurement read by HMC5883L_ReadXYZThread
+static HMC5883L_ReadFunc_TypeDef xyzRead;
+static uint8_t ready;       ///< Nonzero when initialization is finished
+
+/// Configuration A, B and mode registers (read by initialization, updated on writes)
+static uint8_t config[HMC5883L_CONFIG_LEN];
+/// Register reads of measurements (sensor or replay driver)
+static HMC5883L_ReadFunc_TypeDef readFunc = HMC5883L_HAL_Read;
+/// Called with every measurement (NULL - none)
+static void (*sampleCallback)(int16_t x, int16_t y, int16_t z);
+
 /**
  * @brief Initialize the digital compass
+ * @details The function only starts the initialization sequence, which
+ * is then run from HMC5883L_Update. Check HMC5883L_IsReady before reading
+ * the compass.
  */
 void HMC5883L_Init(void) {
 
   HMC5883L_HAL_Init();
 
+  ready = 0;
+  PT_INIT(&initPt);
+}
+/**
+ * @brief Runs the initialization sequence of the compass.
+ * @details This function should be called in the main loop.
+ */
+void HMC5883L_Update(void) {
+
+  if (!ready) {
+    HMC5883L_InitThread(&initPt);
+  }
+}
+/**
+ * @brief Checks whether the compass is initialized.
+ * @retval 1 Compass is ready
+ * @retval 0 Initialization still running
+ */
+uint8_t HMC5883L_IsReady(void) {
+  return ready;
+}
+/**
+ * @brief Initialization sequence of the compass.
+ * @param pt Thread control structure
+ */
+static PT_THREAD(HMC5883L_InitThread(PT_TypeDef* pt)) {
+
+  PT_BEGIN(pt);
+
   // Read id registers and print them out.
-  uint8_t regVal = HMC5883L_HAL_Read(HMC5883L_IDA);
-  println("Id A %02x", regVal);
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_IDA, &regVal));
+  LOG_INFO("Id A %02x", regVal);
 
-  regVal = HMC5883L_HAL_Read(HMC5883L_IDB);
-  println("Id B %02x", regVal);
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_IDB, &regVal));
+  LOG_INFO("Id B %02x", regVal);
 
-  regVal = HMC5883L_HAL_Read(HMC5883L_IDC);
-  println("Id C %02x", regVal);
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_IDC, &regVal));
+  LOG_INFO("Id C %02x", regVal);
 
-  regVal = HMC5883L_HAL_Read(HMC5883L_STATUS);
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_STATUS, &regVal));
+  LOG_INFO("Status %02x", regVal);
 
-  println("Status %02x", regVal);
+  // Configuration registers keep their values over an MCU reset
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_CONFA,
+      &config[HMC5883L_CONFA]));
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_ReadThread(&halPt, HMC5883L_CONFB,
+      &config[HMC5883L_CONFB]));
+  LOG_INFO("Config A %02x B %02x", config[HMC5883L_CONFA], config[HMC5883L_CONFB]);
 
   // continuous measurement mode
-  HMC5883L_ChangeMode(HMC6883L_MODE_CONT);
-
+  PT_SPAWN(pt, &halPt, HMC5883L_HAL_WriteThread(&halPt, HMC5883L_MODE,
+      HMC6883L_MODE_CONT & 0x03));
+  config[HMC5883L_MODE] = HMC6883L_MODE_CONT & 0x03;
 
+  ready = 1;
 
+  PT_END(pt);
 }
 
 /**
@@ -127,6 +180,18 @@ double HMC5883L_ReadAngle(void) {
   // Read XYZ
   HMC5883L_ReadXYZ(&x_s, &y_s, &z_s);
 
+  return HMC5883L_CalcAngle(x_s, y_s);
+
+}
+/**
+ * @brief Calculates the direction angle from compass readings.
+ * @param x_s X reading
+ * @param y_s Y reading
+ * @return Direction angle (0 or 360 means north, 180 means south
+ * 90 east and 270 west).
+ */
+double HMC5883L_CalcAngle(int16_t x_s, int16_t y_s) {
+
   double direction; // the direction angle
 
   // These formulas are taken from AN-203 application note
@@ -158,24 +223,92 @@ double HMC5883L_ReadAngle(void) {
  */
 void HMC5883L_ReadXYZ(int16_t* x_s, int16_t* y_s, int16_t* z_s) {
 
-  uint16_t x, y, z;
+  uint8_t data[6];
+  uint8_t i;
+
+  for (i = 0; i < 6; i++) {
+    data[i] = readFunc(HMC5883L_DATAX_MSB + i);
+  }
+
+  HMC5883L_Sample(data, x_s, y_s, z_s);
+}
+/**
+ * @brief Read XYZ readings from the compass (nonblocking).
+ * @details Same as HMC5883L_ReadXYZ, but every wait for the I2C
+ * bus returns control to the caller. The source of measurements
+ * (HMC5883L_SetSource) is taken at the start of the read.
+ * @param pt Thread control structure
+ * @param x_s X reading (valid when the thread ends)
+ * @param y_s Y reading
+ * @param z_s Z reading
+ */
+PT_THREAD(HMC5883L_ReadXYZThread(PT_TypeDef* pt, int16_t* x_s, int16_t* y_s, int16_t* z_s)) {
+
+  PT_BEGIN(pt);
 
-  // Read x
-  x = HMC5883L_HAL_Read(0x03) << 8;
-  x |= HMC5883L_HAL_Read(0x04);
+  xyzRead = readFunc;
 
-  // Read y
-  y = HMC5883L_HAL_Read(0x07) << 8;
-  y |= HMC5883L_HAL_Read(0x08);
+  for (xyzIndex = 0; xyzIndex < 6; xyzIndex++) {
+
+    if (xyzRead == HMC5883L_HAL_Read) {
+      PT_SPAWN(pt, &xyzHalPt, HMC5883L_HAL_ReadThread(&xyzHalPt,
+          HMC5883L_DATAX_MSB + xyzIndex, &xyzData[xyzIndex]));
+    } else {
+      xyzData[xyzIndex] = xyzRead(HMC5883L_DATAX_MSB + xyzIndex); // replay doesn't wait
+    }
+  }
+
+  HMC5883L_Sample(xyzData, x_s, y_s, z_s);
+
+  PT_END(pt);
+}
+/**
+ * @brief Decode the data output registers.
+ * @details Calls the sample callback with the readings.
+ * @param data Registers from HMC5883L_DATAX_MSB on (X, Z, Y - MSB first)
+ * @param x_s X reading
+ * @param y_s Y reading
+ * @param z_s Z reading
+ */
+static void HMC5883L_Sample(const uint8_t* data, int16_t* x_s, int16_t* y_s, int16_t* z_s) {
 
-  // Read z
-  z = HMC5883L_HAL_Read(0x05) << 8;
-  z |= HMC5883L_HAL_Read(0x06);
+  *x_s = (int16_t)((data[0] << 8) | data[1]);
+  *z_s = (int16_t)((data[2] << 8) | data[3]);
+  *y_s = (int16_t)((data[4] << 8) | data[5]);
 
-  *x_s = (int16_t) x;
-  *y_s = (int16_t) y;
-  *z_s = (int16_t) z;
+  if (sampleCallback) { // if not NULL
+    sampleCallback(*x_s, *y_s, *z_s);
+  }
+}
+/**
+ * @brief Set the source of measurements.
+ * @details The function replaces HMC5883L_HAL_Read for the
+ * data output registers, e.g. to replay recorded samples.
+ * @param read Register read function (NULL - the sensor)
+ */
+void HMC5883L_SetSource(HMC5883L_ReadFunc_TypeDef read) {
+  readFunc = read ? read : HMC5883L_HAL_Read;
+}
+/**
+ * @brief Set function called with every measurement.
+ * @param cb Callback (NULL - none). Runs in the context of
+ * the read (SAMPLER_Update in the main loop).
+ */
+void HMC5883L_SetSampleCallback(void (*cb)(int16_t x, int16_t y, int16_t z)) {
+  sampleCallback = cb;
+}
+/**
+ * @brief Get the configuration of the compass.
+ * @details Valid when HMC5883L_IsReady returns 1.
+ * @param buf Configuration A, configuration B and mode
+ * registers (HMC5883L_CONFIG_LEN bytes)
+ */
+void HMC5883L_GetConfig(uint8_t* buf) {
 
+  uint8_t i;
+  for (i = 0; i < HMC5883L_CONFIG_LEN; i++) {
+    buf[i] = config[i];
+  }
 }
 
 /**
@@ -185,5 +318,6 @@ void HMC5883L_ReadXYZ(int16_t* x_s, int16_t* y_s, int16_t* z_s) {
 void HMC5883L_ChangeMode(HMC5883L_Mode_TypeDef mode) {
   // Mode bits are the two LSB of MODE register
   HMC5883L_HAL_Write(HMC5883L_MODE, mode & 0x03);
+  config[HMC5883L_MODE] = mode & 0x03;
 }
 
@@ -0,0 +1,214 @@
+/**
+ * @file:   irqstat.c
+ * @brief:  Interrupt duration and latency statistics.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Statistics of an interrupt are written only by
+ * its handler, so no locking is needed there. They are
+ * copied with interrupts disabled for printing - a BASEPRI
+ * section (irq.h) can't hold off the priority 0 profiler
+ * timer. PRIMASK is restored afterwards, so a caller's own
+ * interrupt lock is kept.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <irqstat.h>
+#include <timers.h>
+#include <stdio.h>
+// HAL
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup IRQSTAT
+ * @{
+ */
+
+/**
+ * @brief Statistics of an interrupt.
+ */
+typedef struct {
+  uint32_t count;       ///< Number of handler runs
+  uint64_t total;       ///< Sum of cycles
+  uint32_t max;         ///< Longest run
+  uint32_t latCount;    ///< Number of measured latencies
+  uint64_t latTotal;    ///< Sum of latencies
+  uint32_t latMax;      ///< Longest latency
+  uint32_t late;        ///< Number of late events
+} IRQSTAT_Stats_TypeDef;
+
+#if IRQSTAT_ENABLED
+/**
+ * @brief Names of interrupts (same order as IRQSTAT_Id_TypeDef).
+ */
+static const char* const irqNames[IRQSTAT_IDS] = {
+    "SYSTICK", "USART2", "TIM2", "TIM3", "TIM5", "EXTI", "TIM7",
+};
+#endif
+
+volatile uint32_t irqStatCycles; ///< Exclusive cycles of all handlers
+
+static IRQSTAT_Stats_TypeDef irqStats[IRQSTAT_IDS]; ///< Statistics of interrupts
+static uint32_t irqOverhead;  ///< Cycles of an empty measurement
+static uint32_t irqStart;     ///< Time of the last reset (ms)
+
+/**
+ * @brief Initialize the statistics.
+ * @details Starts the cycle counter and measures the
+ * instrumentation overhead.
+ */
+void IRQSTAT_Init(void) {
+
+  DWT_Init();
+
+#if IRQSTAT_ENABLED
+  uint32_t min = UINT32_MAX;
+  uint8_t i;
+
+  for (i = 0; i < 8; i++) { // first passes fill the caches
+    IRQSTAT_ENTER(i); // same as an empty handler
+    uint32_t cycles = DWT_GetCycles() - irqStatStart;
+    (void)irqStatBase;
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+  irqOverhead = min;
+#endif
+
+  IRQSTAT_Reset();
+}
+/**
+ * @brief Add a run of a handler.
+ * @details Use IRQSTAT_EXIT instead of calling directly.
+ * @param id Interrupt
+ * @param cycles Measured cycles (with the overhead)
+ * @param base irqStatCycles at the start of the handler
+ */
+void IRQSTAT_Add(IRQSTAT_Id_TypeDef id, uint32_t cycles, uint32_t base) {
+
+  IRQSTAT_Stats_TypeDef* stats = &irqStats[id];
+
+  cycles = (cycles > irqOverhead) ? cycles - irqOverhead : 0;
+
+  // handlers which preempted this one are in cycles already
+  irqStatCycles = base + cycles;
+
+  stats->count++;
+  stats->total += cycles;
+  if (cycles > stats->max) {
+    stats->max = cycles;
+  }
+}
+/**
+ * @brief Add an entry latency.
+ * @details Use IRQSTAT_LATENCY instead of calling directly.
+ * @param id Interrupt
+ * @param cycles Cycles from the event to the handler
+ */
+void IRQSTAT_Latency(IRQSTAT_Id_TypeDef id, uint32_t cycles) {
+
+  IRQSTAT_Stats_TypeDef* stats = &irqStats[id];
+
+  stats->latCount++;
+  stats->latTotal += cycles;
+  if (cycles > stats->latMax) {
+    stats->latMax = cycles;
+  }
+}
+/**
+ * @brief Count an event handled too late.
+ * @details Use IRQSTAT_LATE instead of calling directly.
+ * @param id Interrupt
+ */
+void IRQSTAT_Late(IRQSTAT_Id_TypeDef id) {
+  irqStats[id].late++;
+}
+/**
+ * @brief Print statistics of all interrupts to terminal.
+ * @details Times are in cycles, except the total. The share
+ * is the total time of the handler per time since the reset.
+ * Latency columns are empty for interrupts which don't
+ * report it.
+ */
+void IRQSTAT_Print(void) {
+
+#if IRQSTAT_ENABLED
+  uint32_t elapsed = TIMER_GetTime() - irqStart;
+  uint32_t mhz = SystemCoreClock / 1000000;
+  uint8_t i;
+
+  printf("IRQ--> %lu ms, overhead %lu cycles\r\n",
+      (unsigned long)elapsed, (unsigned long)irqOverhead);
+  printf("irq         count   total us  share       avg       max  lat avg  lat max    late\r\n");
+
+  for (i = 0; i < IRQSTAT_IDS; i++) {
+
+    IRQSTAT_Stats_TypeDef stats;
+
+    uint32_t primask = __get_PRIMASK(); // may be called with interrupts disabled
+    __disable_irq(); // consistent copy
+    stats = irqStats[i];
+    __set_PRIMASK(primask);
+
+    if (stats.count == 0) {
+      printf("%-8s %8lu\r\n", irqNames[i], 0UL);
+      continue;
+    }
+
+    uint32_t us = (uint32_t)(stats.total / mhz);
+    uint32_t share = elapsed ? us / elapsed : 0; // tenths of percent
+
+    printf("%-8s %8lu %10lu %4lu.%lu%% %9lu %9lu", irqNames[i],
+        (unsigned long)stats.count, (unsigned long)us,
+        (unsigned long)(share / 10), (unsigned long)(share % 10),
+        (unsigned long)(stats.total / stats.count), (unsigned long)stats.max);
+
+    if (stats.latCount) {
+      printf(" %8lu %8lu", (unsigned long)(stats.latTotal / stats.latCount),
+          (unsigned long)stats.latMax);
+    } else {
+      printf(" %8s %8s", "-", "-");
+    }
+
+    printf(" %7lu\r\n", (unsigned long)stats.late);
+  }
+#else
+  printf("IRQ--> Statistics disabled\r\n");
+#endif
+}
+/**
+ * @brief Clear statistics of all interrupts.
+ */
+void IRQSTAT_Reset(void) {
+
+  uint8_t i;
+
+  for (i = 0; i < IRQSTAT_IDS; i++) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    irqStats[i].count = 0;
+    irqStats[i].total = 0;
+    irqStats[i].max = 0;
+    irqStats[i].latCount = 0;
+    irqStats[i].latTotal = 0;
+    irqStats[i].latMax = 0;
+    irqStats[i].late = 0;
+    __set_PRIMASK(primask);
+  }
+
+  irqStart = TIMER_GetTime();
+}
+
+/**
+ * @}
+ */
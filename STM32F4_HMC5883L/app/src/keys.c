@@ -4,6 +4,19 @@
  * @date: 	5 maj 2014
  * @author: Michal Ksiezopolski
  * 
+ * @details In interrupt mode the columns are driven low and
+ * the MCU waits for a row edge (EXTI). The edge starts a
+ * hardware timer which scans one column per SCAN_PERIOD in its
+ * interrupt until all keys are released and settled, then the
+ * keyboard goes back to waiting for an edge. Between key
+ * presses neither the main loop nor any timer does keyboard work.
+ *
+ * Scanning only puts events in a queue. Handlers are always
+ * called from KEYS_Update in the main loop, never from the scan
+ * interrupt, so they may be slow and use any module. In polling
+ * mode the scan runs from KEYS_Update too, before the dispatch,
+ * so there a slow handler delays the next column.
+ *
  * @verbatim
  * Copyright (c) 2014 Michal Ksiezopolski.
  * All rights reserved. This program and the 
@@ -17,92 +30,339 @@
 
 #include <keys.h>
 #include <timers.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <keys_hal.h>
+#include <tim7.h>
+#include <trace.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
+#define LOG_MODULE        "KEYS"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_KEYS
+#include <log.h>
 
-#ifdef DEBUG
-  #define print(str, args...) printf("KEYS--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("KEYS--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define SCAN_PERIOD       1 ///< Column scan period in ms
+#define DEBOUNCE_SAMPLES  2 ///< Integrator limit - a key has to be stable for this many sweeps (2 sweeps = 8ms)
 
-#define DEBOUNCE_TIME 200 ///< Key debounce time in ms
+#define REPEAT_DELAY      500   ///< Time from press to first repeat event in ms
+#define REPEAT_PERIOD     100   ///< Time between repeat events in ms
+#define LONG_PRESS_TIME   1500  ///< Time from press to long press event in ms
+
+#define EVENT_QUEUE_LEN   16    ///< Length of key event queue (power of 2)
 
 /**
  * Key structure typedef.
  */
 typedef struct {
 	uint8_t id;		///< KEY_ID
-	void (*PressCallback)(void);
-	void (*RepeatCallback)(void);
-	uint16_t len;	///<
-	uint16_t count;	///<
+	KEYS_Handler_TypeDef handler[KEYS_EVENT_COUNT]; ///< Event handlers
+	uint32_t pressTime;   ///< Time of last press
+	uint32_t repeatTime;  ///< Time of last press or repeat event
+	uint8_t longPress;    ///< Long press event already generated
 } KEY_TypeDef;
 
+static KEY_TypeDef keys[KEYS_COUNT]; ///< Keys
 
+/// Queue of events waiting for dispatch (written before eventHead moves)
+static volatile KEYS_Event_TypeDef eventQueue[EVENT_QUEUE_LEN];
+static volatile uint8_t eventHead;  ///< Queue write index (scanning)
+static volatile uint8_t eventTail;  ///< Queue read index (dispatching)
+static volatile uint16_t lostEvents; ///< Number of events dropped on full queue
 
 uint8_t currentColumn; ///< Selected keyboard column
 
-void KEYS_Init(void) {
+static KEYS_Mode_TypeDef keysMode;  ///< Scanning mode
+static uint32_t lastScan;           ///< Time of last column scan in polling mode
+
+static uint8_t integrator[KEYS_COUNT]; ///< Debounce integrators of keys
+static volatile uint16_t keysState; ///< Debounced state of all keys (bit set - key pressed)
+static uint16_t keysPressed;        ///< Keys pressed since last KEYS_GetChanges
+static uint16_t keysReleased;       ///< Keys released since last KEYS_GetChanges
+
+static void KEYS_Scan(void);
+static void KEYS_HeldKeys(uint32_t time);
+static void KEYS_PushEvent(uint8_t key, KEYS_EventType_TypeDef type, uint32_t time);
+static void KEYS_Dispatch(void);
+static void KEYS_PressCallback(void);
+static void KEYS_StartScan(void);
+static void KEYS_WaitForPress(void);
+
+/**
+ * @brief Initialize the matrix keyboard.
+ * @param mode Scanning mode
+ */
+void KEYS_Init(KEYS_Mode_TypeDef mode) {
 
   KEYS_HAL_Init();
   currentColumn = 0;
+  keysMode = mode;
+
+  uint8_t i;
+  for (i = 0; i < KEYS_COUNT; i++) {
+    keys[i].id = i;
+  }
+
+  if (keysMode == KEYS_MODE_IRQ) {
+    KEYS_HAL_ScanInit(1000 / SCAN_PERIOD, KEYS_Scan);
+    KEYS_HAL_IrqInit(KEYS_PressCallback);
+    KEYS_WaitForPress();
+    return;
+  }
 
   // select first column as default
   KEYS_HAL_SelectColumn(0);
+  lastScan = TIMER_GetTime();
 
 }
 
 /**
- * @brief Checks if any keys are set.
- * @details Run this function in main loop to check for pressed keys.
- * TODO Add repeat, function calling
+ * @brief Runs the keyboard.
+ * @details Run this function in main loop. In polling mode the function
+ * scans one column every SCAN_PERIOD. In interrupt mode scanning runs
+ * in the timer interrupt. Key events generated by scanning are
+ * dispatched to the registered handlers here, so slow handlers don't
+ * stall scanning.
  */
-uint8_t KEYS_Update(void) {
-
-  static uint8_t keyId = KEY_NONE;
-  uint8_t keyValid = KEY_NONE; // hold a valid debounced key ID
-  uint8_t currentKey = KEY_NONE;
+void KEYS_Update(void) {
 
-  static uint32_t debounceTimer = 0; // timer for counting debounce time
+  if (keysMode == KEYS_MODE_POLL) {
+    if (TIMER_DelayTimer(SCAN_PERIOD, lastScan)) {
+      lastScan = TIMER_GetTime();
+      KEYS_Scan();
+    }
+  }
 
-  int8_t row = KEYS_HAL_ReadRow();
+  KEYS_Dispatch();
+}
+/**
+ * @brief Registers a key event handler.
+ * @param key Key number (KEYS_INDEX)
+ * @param type Type of event
+ * @param handler Function called on event (NULL removes handler).
+ * Called in the main loop (KEYS_Update) in both scanning modes.
+ */
+void KEYS_RegisterHandler(uint8_t key, KEYS_EventType_TypeDef type,
+    KEYS_Handler_TypeDef handler) {
 
-  // if a keypress has been recongized
-  if (row != -1) {
-    currentKey = (currentColumn << 4) | row;
-//    println("You pressed a key in row %d, column %d.", row, currentColumn);
+  if (key >= KEYS_COUNT || type >= KEYS_EVENT_COUNT) {
+    LOG_ERROR("Wrong key %d or event %d!", (int)key, (int)type);
+    return;
   }
 
-  // if key value changed start debounce timer for new key
-  if (keyId != currentKey && currentKey != KEY_NONE) {
-    keyId = currentKey;
-    debounceTimer = TIMER_GetTime();
+  keys[key].handler[type] = handler;
+}
+/**
+ * @brief Returns number of events lost due to full queue.
+ * @return Number of lost events
+ */
+uint16_t KEYS_GetLostEvents(void) {
+  return lostEvents;
+}
+/**
+ * @brief Returns the debounced state of all keys.
+ * @return Bitmap of pressed keys (bit KEYS_INDEX(column, row))
+ */
+uint16_t KEYS_GetState(void) {
+  return keysState;
+}
+/**
+ * @brief Returns keys pressed and released since previous call.
+ * @param pressed Bitmap of newly pressed keys
+ * @param released Bitmap of newly released keys
+ * @retval 0 No changes
+ * @retval 1 Some keys changed
+ */
+uint8_t KEYS_GetChanges(uint16_t* pressed, uint16_t* released) {
+
+  uint32_t lock = KEYS_HAL_ScanLock(); // updated by the scan interrupt
+
+  *pressed = keysPressed;
+  *released = keysReleased;
+
+  keysPressed = 0;
+  keysReleased = 0;
+
+  KEYS_HAL_ScanUnlock(lock);
+
+  return (*pressed | *released) ? 1 : 0;
+}
+
+/**
+ * @brief Scans the current column and selects the next one.
+ * @details Every key has an integrator counting up when the key
+ * is read as pressed and down when it is read as released. The
+ * debounced state changes only when the integrator reaches
+ * its limit, so bounces shorter than DEBOUNCE_SAMPLES sweeps are
+ * ignored and all keys are debounced independently.
+ * Runs in the timer interrupt in interrupt mode.
+ */
+static void KEYS_Scan(void) {
+
+  TRACE_BEGIN(TRACE_KEYS_SCAN, currentColumn);
+
+  uint8_t rows = KEYS_HAL_ReadRows();
+  uint16_t oldState = keysState;
+  uint32_t time = TIMER_GetTime();
+
+  uint8_t row;
+  for (row = 0; row < KEYS_ROWS; row++) {
+
+    uint8_t key = KEYS_INDEX(currentColumn, row);
+
+    if (rows & (1 << row)) {
+      if (integrator[key] < DEBOUNCE_SAMPLES) {
+        integrator[key]++;
+      }
+    } else if (integrator[key] > 0) {
+      integrator[key]--;
+    }
+
+    if (integrator[key] == DEBOUNCE_SAMPLES && !(keysState & (1 << key))) {
+      keysState |= (1 << key);
+      keys[key].pressTime = time;
+      keys[key].repeatTime = time;
+      keys[key].longPress = 0;
+      KEYS_PushEvent(key, KEYS_EVENT_PRESS, time);
+    } else if (integrator[key] == 0 && (keysState & (1 << key))) {
+      keysState &= ~(1 << key);
+      KEYS_PushEvent(key, KEYS_EVENT_RELEASE, time);
+    }
   }
-  // if debounce finished, the key is valid
-  if (keyId != KEY_NONE && TIMER_DelayTimer(DEBOUNCE_TIME, debounceTimer)) {
-    keyValid = keyId;
-    println("You pressed a key 0x%02x.", keyValid);
-    keyId = KEY_NONE;
+
+  KEYS_HeldKeys(time);
+
+  uint16_t changed = keysState ^ oldState;
+
+  if (changed) {
+    keysPressed |= changed & keysState;
+    keysReleased |= changed & oldState;
+    LOG_DEBUG("Keys state 0x%04x.", keysState);
   }
 
   // update column
   currentColumn++;
 
-  if (currentColumn == 4) {
+  if (currentColumn == KEYS_COLUMNS) {
+
     currentColumn = 0;
+
+    // all keys released and settled - go back to waiting for interrupt
+    if (keysMode == KEYS_MODE_IRQ && keysState == 0) {
+
+      uint8_t i;
+      for (i = 0; i < KEYS_COUNT; i++) {
+        if (integrator[i]) {
+          break;
+        }
+      }
+
+      if (i == KEYS_COUNT) {
+        KEYS_HAL_ScanStop();
+        KEYS_WaitForPress();
+        TRACE_END(TRACE_KEYS_SCAN, 0);
+        return;
+      }
+    }
   }
 
   KEYS_HAL_SelectColumn(currentColumn);
 
-  // if key is valid return ID, if not returns KEY_NONE
-  return keyValid;
+  TRACE_END(TRACE_KEYS_SCAN, 0);
+}
+/**
+ * @brief Generates repeat and long press events for held keys.
+ * @param time Current system time
+ */
+static void KEYS_HeldKeys(uint32_t time) {
+
+  uint8_t i;
+  for (i = 0; i < KEYS_COUNT; i++) {
+
+    if (!(keysState & (1 << i))) {
+      continue;
+    }
+
+    if (!keys[i].longPress && time - keys[i].pressTime >= LONG_PRESS_TIME) {
+      keys[i].longPress = 1;
+      KEYS_PushEvent(i, KEYS_EVENT_LONG_PRESS, time);
+    }
+
+    // first repeat after REPEAT_DELAY, then every REPEAT_PERIOD
+    uint32_t wait = (keys[i].repeatTime == keys[i].pressTime) ?
+        REPEAT_DELAY : REPEAT_PERIOD;
+
+    if (time - keys[i].repeatTime >= wait) {
+      keys[i].repeatTime = time;
+      KEYS_PushEvent(i, KEYS_EVENT_REPEAT, time);
+    }
+  }
+}
+/**
+ * @brief Puts an event in the queue.
+ * @details Runs in the scanning context (the timer interrupt in
+ * interrupt mode). Single producer - no lock needed.
+ * @param key Key number
+ * @param type Type of event
+ * @param time System time of event
+ */
+static void KEYS_PushEvent(uint8_t key, KEYS_EventType_TypeDef type, uint32_t time) {
+
+  uint8_t next = (eventHead + 1) & (EVENT_QUEUE_LEN - 1);
+
+  if (next == eventTail) { // queue full
+    lostEvents++;
+    return;
+  }
+
+  eventQueue[eventHead].time = time;
+  eventQueue[eventHead].key = key;
+  eventQueue[eventHead].type = type;
+
+  eventHead = next;
 }
+/**
+ * @brief Calls handlers of all queued events.
+ * @details Runs in the main loop. Single consumer - the slot is
+ * copied before it is given back to the scan.
+ */
+static void KEYS_Dispatch(void) {
+
+  while (eventTail != eventHead) {
 
+    KEYS_Event_TypeDef event = eventQueue[eventTail];
+    eventTail = (eventTail + 1) & (EVENT_QUEUE_LEN - 1);
+
+    if (keys[event.key].handler[event.type] != NULL) {
+      keys[event.key].handler[event.type](&event);
+    }
+  }
+}
+/**
+ * @brief Key press interrupt callback.
+ * @details Called in interrupt context - starts scanning.
+ */
+static void KEYS_PressCallback(void) {
+  KEYS_StartScan();
+}
+/**
+ * @brief Selects the first column and starts the scan timer.
+ */
+static void KEYS_StartScan(void) {
+
+  currentColumn = 0;
+  KEYS_HAL_SelectColumn(currentColumn);
+  KEYS_HAL_ScanStart();
+}
+/**
+ * @brief Drives all columns low and enables key press interrupt.
+ */
+static void KEYS_WaitForPress(void) {
+
+  KEYS_HAL_SelectAll();
+  KEYS_HAL_IrqEnable();
+
+  // a key pressed before enabling the interrupt didn't generate an edge
+  if (KEYS_HAL_ReadRows()) {
+    KEYS_HAL_IrqDisable();
+    KEYS_StartScan();
+  }
+}
 
@@ -24,21 +24,12 @@
  *
  */
 
-#include <stdio.h>
 #include <led.h>
 #include <led_hal.h>
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("LED--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LED--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE        "LED"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_LED
+#include <log.h>
 
 /**
  * @addtogroup LED
@@ -46,6 +37,21 @@
  */
 
 static LED_State_TypeDef ledState[MAX_LEDS]; ///< States of the LEDs (MAX_LEDS is hardware dependent)
+static uint8_t ledPwm[MAX_LEDS];      ///< Nonzero for LEDs driven by PWM
+static uint8_t ledDuty[MAX_LEDS];     ///< Duty cycle of PWM LEDs in percent
+static uint16_t ledCompare[MAX_LEDS]; ///< Compare value of PWM LEDs for LED_ON state
+static uint32_t pwmTicks;             ///< Number of PWM timer ticks in period
+
+#define LED_PATTERN_BUF_LEN 256 ///< Maximum length of compiled pattern in ticks
+
+static uint32_t patternBuf[LED_PATTERN_BUF_LEN]; ///< Compiled pattern played by DMA
+static int8_t patternLed = -1;        ///< LED playing the pattern (-1 none)
+static LED_State_TypeDef patternPrevState; ///< State of LED before pattern
+static LED_State_TypeDef patternEndState;  ///< State of LED after a one-shot pattern
+static uint8_t patternLoop;           ///< Pattern repeats
+
+static void LED_SetOutput(LED_Number_TypeDef led, LED_State_TypeDef state);
+static void LED_CheckPattern(void);
 
 /**
  * @brief Add an LED.
@@ -55,13 +61,80 @@ void LED_Init(LED_Number_TypeDef led) {
 
   // Check if LED number is correct.
   if (led >= MAX_LEDS) {
-    println("Error: Incorrect LED number %d!", (int)led);
+    LOG_ERROR("Incorrect LED number %d!", (int)led);
     return;
   }
 
   LED_HAL_Init(led);
+  ledPwm[led] = 0;
   ledState[led] = LED_OFF; // LED initially off
 }
+/**
+ * @brief Add an LED driven by PWM.
+ * @details The LED is fully on in LED_ON state until
+ * LED_SetDuty is called.
+ * @param led LED number.
+ */
+void LED_InitPWM(LED_Number_TypeDef led) {
+
+  // Check if LED number is correct.
+  if (led >= MAX_LEDS) {
+    LOG_ERROR("Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  LED_HAL_InitPWM(led);
+
+  if (pwmTicks == 0) {
+    LED_SetPeriod(1000); // 1kHz - dimming
+  }
+
+  ledPwm[led] = 1;
+  ledState[led] = LED_OFF; // LED initially off
+  LED_SetDuty(led, 100);
+}
+/**
+ * @brief Set period of PWM LEDs.
+ * @details Around 1000us for brightness control, hundreds of ms
+ * for blinking. Duty cycles of all PWM LEDs are kept.
+ * @param periodUs Period in microseconds.
+ */
+void LED_SetPeriod(uint32_t periodUs) {
+
+  pwmTicks = LED_HAL_SetPeriod(periodUs);
+
+  uint8_t i;
+  for (i = 0; i < MAX_LEDS; i++) {
+    if (ledPwm[i]) {
+      LED_SetDuty(i, ledDuty[i]);
+    }
+  }
+}
+/**
+ * @brief Set duty cycle of a PWM LED.
+ * @details Sets brightness of the LED in LED_ON state (short period)
+ * or the on-time of hardware blinking (long period).
+ * @param led LED number.
+ * @param duty Duty cycle in percent (0-100).
+ */
+void LED_SetDuty(LED_Number_TypeDef led, uint8_t duty) {
+
+  if (led >= MAX_LEDS || !ledPwm[led]) {
+    LOG_ERROR("LED %d is not a PWM LED!", (int)led);
+    return;
+  }
+
+  if (duty > 100) {
+    duty = 100;
+  }
+
+  ledDuty[led] = duty;
+  ledCompare[led] = pwmTicks * duty / 100;
+
+  if (ledState[led] == LED_ON) {
+    LED_HAL_SetCompare(led, ledCompare[led]);
+  }
+}
 
 /**
  * @brief Change the state of an LED.
@@ -71,19 +144,20 @@ void LED_Init(LED_Number_TypeDef led) {
 void LED_ChangeState(LED_Number_TypeDef led, LED_State_TypeDef state) {
 
   if (led >= MAX_LEDS) {
-    println("Error: Incorrect LED number %d!", (int)led);
+    LOG_ERROR("Incorrect LED number %d!", (int)led);
     return;
   }
 
+  LED_CheckPattern();
+
   if (ledState[led] == LED_UNUSED) {
-    println("Error: Uninitialized LED %d!", (int)led);
+    LOG_ERROR("Uninitialized LED %d!", (int)led);
     return;
   } else {
-    if (state == LED_OFF) {
-      LED_HAL_ChangeState(led, 0); // turn off LED
-    } else if (state == LED_ON) {
-      LED_HAL_ChangeState(led, 1); // light up LED
+    if (ledState[led] == LED_PATTERN) {
+      LED_StopPattern();
     }
+    LED_SetOutput(led, state);
   }
 
   ledState[led] = state; // update LED state
@@ -96,20 +170,249 @@ void LED_ChangeState(LED_Number_TypeDef led, LED_State_TypeDef state) {
 void LED_Toggle(LED_Number_TypeDef led) {
 
   if (led >= MAX_LEDS) {
-    println("Error: Incorrect LED number %d!", (int)led);
+    LOG_ERROR("Incorrect LED number %d!", (int)led);
     return;
   }
 
+  LED_CheckPattern();
+
   if (ledState[led] == LED_UNUSED) {
-    println("Error: Uninitialized LED %d!", (int)led);
+    LOG_ERROR("Uninitialized LED %d!", (int)led);
     return;
   } else {
+    if (ledState[led] == LED_PATTERN) {
+      LED_StopPattern();
+    }
+
     if (ledState[led] == LED_OFF) {
       ledState[led] = LED_ON;
     } else if (ledState[led] == LED_ON) {
       ledState[led]= LED_OFF;
     }
-    LED_HAL_Toggle(led);
+
+    if (ledPwm[led]) {
+      LED_SetOutput(led, ledState[led]);
+    } else {
+      LED_HAL_Toggle(led);
+    }
+  }
+}
+/**
+ * @brief Turn a group of LEDs on and off.
+ * @details All on/off LEDs are changed with a single
+ * atomic write, so they change at the same moment.
+ * Uninitialized LEDs are skipped.
+ * @param on Mask of LEDs to turn on (see LED_MASK)
+ * @param off Mask of LEDs to turn off (ignored for LEDs in on mask)
+ */
+void LED_SetMask(uint8_t on, uint8_t off) {
+
+  uint8_t gpioOn = 0;
+  uint8_t gpioOff = 0;
+  uint8_t i;
+
+  off &= ~on;
+
+  LED_CheckPattern();
+
+  for (i = 0; i < MAX_LEDS; i++) {
+
+    uint8_t mask = LED_MASK(i);
+
+    if (!((on | off) & mask) || ledState[i] == LED_UNUSED) {
+      continue;
+    }
+
+    if (ledState[i] == LED_PATTERN) {
+      LED_StopPattern();
+    }
+
+    ledState[i] = (on & mask) ? LED_ON : LED_OFF;
+
+    if (ledPwm[i]) {
+      LED_SetOutput(i, ledState[i]);
+    } else if (on & mask) {
+      gpioOn |= mask;
+    } else {
+      gpioOff |= mask;
+    }
+  }
+
+  LED_HAL_SetMask(gpioOn, gpioOff);
+}
+/**
+ * @brief Get the state of an LED.
+ * @details A one-shot pattern which played to the end is reported
+ * as the state of its last step.
+ * @param led LED number.
+ * @return State of the LED (LED_UNUSED for wrong numbers)
+ */
+LED_State_TypeDef LED_GetState(LED_Number_TypeDef led) {
+
+  if (led >= MAX_LEDS) {
+    return LED_UNUSED;
+  }
+
+  LED_CheckPattern();
+
+  return ledState[led];
+}
+/**
+ * @brief Set all LEDs according to a frame.
+ * @param frame Bit n set - LEDn on, cleared - LEDn off
+ */
+void LED_ApplyFrame(uint8_t frame) {
+
+  LED_SetMask(frame, ~frame);
+}
+/**
+ * @brief Play a pattern on an LED.
+ * @details The pattern is played by hardware (timer triggered DMA),
+ * so it costs no CPU time. A pattern already playing on any LED
+ * is stopped. LED_ChangeState or LED_Toggle stop the pattern.
+ * One-shot patterns leave the LED in the state of the last step -
+ * LED_ON for levels from 50 up, LED_OFF below (the output of a PWM
+ * LED keeps the level of the step until it is changed).
+ * @param led LED number.
+ * @param pattern Pattern to play (copied, may be temporary).
+ */
+void LED_PlayPattern(LED_Number_TypeDef led, const LED_Pattern_TypeDef* pattern) {
+
+  if (led >= MAX_LEDS) {
+    LOG_ERROR("Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  if (ledState[led] == LED_UNUSED) {
+    LOG_ERROR("Uninitialized LED %d!", (int)led);
+    return;
+  }
+
+  if (pattern->tickMs == 0) {
+    LOG_ERROR("Pattern tick can't be zero!");
+    return;
+  }
+
+  LED_StopPattern(); // only one DMA stream - one pattern at a time
+
+  uint16_t len;
+
+  if (ledPwm[led]) {
+    len = LED_CompilePattern(pattern, patternBuf, LED_PATTERN_BUF_LEN,
+        pwmTicks, 0, 0);
+  } else {
+    len = LED_CompilePattern(pattern, patternBuf, LED_PATTERN_BUF_LEN,
+        0, LED_HAL_SequenceWord(led, 1), LED_HAL_SequenceWord(led, 0));
+  }
+
+  if (len == 0) {
+    LOG_ERROR("Pattern too long or empty!");
+    return;
+  }
+
+  patternLed = led;
+  patternPrevState = ledState[led];
+  patternEndState = (pattern->steps[pattern->len - 1].level >= 50) ? LED_ON : LED_OFF;
+  patternLoop = pattern->loop;
+  ledState[led] = LED_PATTERN;
+
+  LED_HAL_StartSequence(led, ledPwm[led], patternBuf, len,
+      pattern->loop, (uint32_t)pattern->tickMs * 1000);
+}
+/**
+ * @brief Stop the pattern being played.
+ * @details The LED returns to the state it had before the pattern.
+ */
+void LED_StopPattern(void) {
+
+  LED_CheckPattern();
+
+  if (patternLed < 0) {
+    return;
+  }
+
+  LED_HAL_StopSequence();
+
+  ledState[patternLed] = patternPrevState;
+  LED_SetOutput(patternLed, patternPrevState);
+  patternLed = -1;
+}
+/**
+ * @brief Compile a pattern into a buffer of output values (one per tick).
+ * @details Has no hardware dependencies, so it can be run on the host.
+ * @param pattern Pattern to compile.
+ * @param buf Output buffer.
+ * @param size Size of output buffer.
+ * @param fullValue Output value for 100% brightness (PWM LEDs) or zero
+ * for on/off LEDs.
+ * @param onValue Output value of a lit on/off LED.
+ * @param offValue Output value of a dark on/off LED.
+ * @return Number of values written, 0 if pattern is empty or doesn't fit.
+ */
+uint16_t LED_CompilePattern(const LED_Pattern_TypeDef* pattern, uint32_t* buf,
+    uint16_t size, uint32_t fullValue, uint32_t onValue, uint32_t offValue) {
+
+  uint16_t len = 0;
+  uint8_t i;
+  uint16_t j;
+  uint32_t value;
+
+  for (i = 0; i < pattern->len; i++) {
+
+    const LED_Step_TypeDef* step = &pattern->steps[i];
+    uint8_t level = (step->level > 100) ? 100 : step->level;
+
+    if (fullValue) {
+      value = fullValue * level / 100;
+    } else {
+      value = (level >= 50) ? onValue : offValue;
+    }
+
+    if (step->duration > size - len) {
+      return 0; // doesn't fit
+    }
+
+    for (j = 0; j < step->duration; j++) {
+      buf[len++] = value;
+    }
+  }
+
+  return len;
+}
+/**
+ * @brief Finish a one-shot pattern which played to the end.
+ * @details The DMA stops by itself after the last value, the
+ * state is updated when the LED is used next.
+ */
+static void LED_CheckPattern(void) {
+
+  if (patternLed < 0 || patternLoop || LED_HAL_SequenceBusy()) {
+    return;
+  }
+
+  LED_HAL_StopSequence(); // step timer still runs
+  ledState[patternLed] = patternEndState;
+  patternLed = -1;
+}
+/**
+ * @brief Drive LED output.
+ * @param led LED number.
+ * @param state New state.
+ */
+static void LED_SetOutput(LED_Number_TypeDef led, LED_State_TypeDef state) {
+
+  if (ledPwm[led]) { // just a compare register write
+    if (state == LED_OFF) {
+      LED_HAL_SetCompare(led, 0);
+    } else if (state == LED_ON) {
+      LED_HAL_SetCompare(led, ledCompare[led]);
+    }
+  } else {
+    if (state == LED_OFF) {
+      LED_HAL_ChangeState(led, 0); // turn off LED
+    } else if (state == LED_ON) {
+      LED_HAL_ChangeState(led, 1); // light up LED
+    }
   }
 }
 
@@ -0,0 +1,218 @@
+/**
+ * @file:   log.c
+ * @brief:  Deferred binary logging.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Records are kept in a ring of fixed size slots.
+ * Writers (main loop and interrupts) reserve a slot by
+ * incrementing the head index with LDREX/STREX, fill it
+ * and mark it ready - no interrupts are disabled. The main
+ * loop sends ready slots in order.
+ *
+ * Frame sent for every record (little endian):
+ * @verbatim
+ * 0xa5 0x5a len id[4] time[4] arg[4]*n checksum
+ * @endverbatim
+ * len is the number of bytes between len and checksum,
+ * checksum is the XOR of len and these bytes. Time is in ms.
+ * Record with ID 0 means records were lost (argument
+ * is the number of lost records). Records with IDs LOG_ID_REC,
+ * LOG_ID_TRACE and LOG_ID_PCPROF carry recorded compass samples,
+ * trace events and PC sample counts.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <log.h>
+#include <comm.h>
+#include <timers.h>
+#include <stdarg.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+#define LOG_BUF_LEN   32    ///< Number of record slots (power of 2)
+#define LOG_SYNC1     0xa5  ///< First frame sync byte
+#define LOG_SYNC2     0x5a  ///< Second frame sync byte
+#define LOG_ID_LOST   0     ///< ID of lost records message
+
+/**
+ * @brief Log record.
+ */
+typedef struct {
+  volatile uint8_t ready;       ///< Nonzero when record is complete
+  uint8_t nargs;                ///< Number of arguments
+  uint32_t id;                  ///< Format string ID
+  uint32_t time;                ///< Timestamp in ms
+  uint32_t args[LOG_MAX_ARGS];  ///< Arguments
+} LOG_Record_TypeDef;
+
+volatile uint8_t logMask = 0xff;  ///< Levels enabled at runtime (all)
+
+static LOG_Record_TypeDef logBuf[LOG_BUF_LEN];  ///< Record slots
+static volatile uint32_t logHead;   ///< Number of reserved records
+static volatile uint32_t logTail;   ///< Number of sent records
+static volatile uint32_t logLost;   ///< Number of dropped records (not yet reported)
+
+static uint8_t LOG_SendFrame(uint32_t id, uint32_t time, uint8_t nargs,
+    const uint32_t* args);
+
+/**
+ * @brief Queue a log record.
+ * @details Use the LOG macro instead of calling directly.
+ * Safe to call from interrupts.
+ * @param id Format string ID
+ * @param nargs Number of 32-bit arguments that follow
+ */
+void LOG_Write(uint32_t id, uint8_t nargs, ...) {
+
+  uint32_t head;
+
+  // reserve a slot
+  do {
+    head = __LDREXW(&logHead);
+
+    if (head - logTail >= LOG_BUF_LEN) { // no free slot
+      __CLREX();
+      uint32_t lost;
+      do {
+        lost = __LDREXW(&logLost);
+      } while (__STREXW(lost + 1, &logLost));
+      return;
+    }
+  } while (__STREXW(head + 1, &logHead));
+
+  LOG_Record_TypeDef* rec = &logBuf[head & (LOG_BUF_LEN - 1)];
+
+  if (nargs > LOG_MAX_ARGS) {
+    nargs = LOG_MAX_ARGS;
+  }
+
+  rec->id = id;
+  rec->time = TIMER_GetTime();
+  rec->nargs = nargs;
+
+  va_list ap;
+  va_start(ap, nargs);
+  uint8_t i;
+  for (i = 0; i < nargs; i++) {
+    rec->args[i] = va_arg(ap, uint32_t);
+  }
+  va_end(ap);
+
+  __DMB(); // record contents before ready flag
+  rec->ready = 1;
+}
+/**
+ * @brief Send queued records to COMM.
+ * @details Call in the main loop. Records are sent only
+ * while there is room in the COMM transmit buffer.
+ */
+void LOG_Update(void) {
+
+  while (1) {
+
+    LOG_Record_TypeDef* rec = &logBuf[logTail & (LOG_BUF_LEN - 1)];
+
+    if (!rec->ready) {
+      break;
+    }
+
+    if (LOG_SendFrame(rec->id, rec->time, rec->nargs, rec->args)) {
+      return; // no room - try later
+    }
+
+    rec->ready = 0;
+    __DMB(); // slot free only after it was read
+    logTail++;
+  }
+
+  // report dropped records once the queue is empty
+  if (logLost) {
+    uint32_t lost = logLost;
+    if (LOG_SendFrame(LOG_ID_LOST, TIMER_GetTime(), 1, &lost) == 0) {
+      uint32_t now;
+      do {
+        now = __LDREXW(&logLost);
+      } while (__STREXW(now - lost, &logLost));
+    }
+  }
+}
+/**
+ * @brief Set runtime log level.
+ * @details Messages up to the given level are sent (if they
+ * are compiled in - see log_config.h).
+ * @param level LOG_LEVEL_NONE - LOG_LEVEL_TRACE
+ */
+void LOG_SetLevel(uint8_t level) {
+
+  if (level > LOG_LEVEL_TRACE) {
+    level = LOG_LEVEL_TRACE;
+  }
+
+  logMask = (uint8_t)((1 << (level + 1)) - 2); // bits 1 - level
+}
+/**
+ * @brief Number of free record slots.
+ * @details Lets bulk writers leave room for messages.
+ * @return Number of records that can be queued
+ */
+uint32_t LOG_Free(void) {
+  return LOG_BUF_LEN - (logHead - logTail);
+}
+/**
+ * @brief Send one frame.
+ * @retval 0 Frame sent
+ * @retval 1 No room in COMM buffer
+ */
+static uint8_t LOG_SendFrame(uint32_t id, uint32_t time, uint8_t nargs,
+    const uint32_t* args) {
+
+  uint8_t payload[8 + 4 * LOG_MAX_ARGS];
+  uint8_t len = 0;
+  uint8_t i, j;
+
+  for (j = 0; j < 4; j++) {
+    payload[len++] = id >> (8 * j);
+  }
+  for (j = 0; j < 4; j++) {
+    payload[len++] = time >> (8 * j);
+  }
+  for (i = 0; i < nargs; i++) {
+    for (j = 0; j < 4; j++) {
+      payload[len++] = args[i] >> (8 * j);
+    }
+  }
+
+  if (COMM_TxFree() < len + 4) {
+    return 1;
+  }
+
+  uint8_t checksum = len;
+  COMM_Putc(LOG_SYNC1);
+  COMM_Putc(LOG_SYNC2);
+  COMM_Putc(len);
+  for (i = 0; i < len; i++) {
+    COMM_Putc(payload[i]);
+    checksum ^= payload[i];
+  }
+  COMM_Putc(checksum);
+
+  return 0;
+}
+
+/**
+ * @}
+ */
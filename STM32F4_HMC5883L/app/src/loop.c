@@ -0,0 +1,266 @@
+/**
+ * @file:   loop.c
+ * @brief:  Main loop latency monitor.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The duration of an iteration is the time between
+ * two calls of LOOP_Tick, so it includes interrupts. Missed
+ * deadlines are also logged, at most once per LOOP_WARN_PERIOD,
+ * so a slow unit shows up in the log without flooding it.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <loop.h>
+#include <histogram.h>
+#include <prof.h>
+#include <timers.h>
+#include <stdio.h>
+// HAL
+#include <dwt.h>
+#include <irq.h>
+#include <stm32f4xx.h>
+
+#define LOG_MODULE        "LOOP"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_LOOP
+#include <log.h>
+
+/**
+ * @addtogroup LOOP
+ * @{
+ */
+
+#define LOOP_BINS         20    ///< Number of histogram bins (last from 2^18 us)
+#define LOOP_WARN_PERIOD  1000  ///< Minimum time between deadline warnings in ms
+#define LOOP_NO_REGION    0xff  ///< No region reported in an iteration
+
+static uint32_t loopBins[LOOP_BINS];  ///< Histogram bins
+static HIST_TypeDef loopHist;         ///< Iteration durations in us
+static uint32_t loopDeadline = LOOP_DEADLINE_US; ///< Deadline in us
+static uint32_t loopMissed;           ///< Iterations over the deadline
+static uint32_t loopLast;             ///< Cycle counter at the previous tick
+static uint8_t loopStarted;           ///< Nonzero after the first tick
+static uint32_t loopSleep;            ///< Cycles slept in the current iteration
+static uint32_t sleepMs;              ///< Total sleep since the reset (ms)
+static uint32_t sleepCycles;          ///< Sleep not added to sleepMs yet
+static uint32_t resetTime;            ///< System time of the reset (ms)
+
+static volatile uint8_t iterRegion;   ///< Longest region of the iteration
+static volatile uint32_t iterCycles;  ///< Cycles of the longest region
+
+static uint32_t worstUs;              ///< Longest iteration
+static uint8_t worstRegion;           ///< Longest region of the longest iteration
+static uint32_t worstRegionUs;        ///< Duration of that region
+static uint32_t worstTime;            ///< System time of the longest iteration (ms)
+
+static uint32_t warnTime;             ///< Time of the last warning (ms)
+static uint32_t warnMissed;           ///< Missed deadlines since the last warning
+
+static void LOOP_Warn(uint8_t region, uint32_t missed, uint32_t us);
+
+/**
+ * @brief Initialize the monitor.
+ */
+void LOOP_Init(void) {
+
+  DWT_Init();
+
+  loopHist.bins  = loopBins;
+  loopHist.len   = LOOP_BINS;
+  loopHist.low   = 0;
+  loopHist.width = 1;
+  loopHist.scale = HIST_SCALE_LOG2;
+
+  LOOP_Reset();
+}
+/**
+ * @brief Mark the start of a main loop iteration.
+ * @details Finishes the measurement of the previous iteration.
+ */
+void LOOP_Tick(void) {
+
+  uint32_t now = DWT_GetCycles();
+
+  // take the longest region and start a new iteration
+  uint32_t lock = IRQ_Lock(IRQ_PRIO_APP);
+  uint8_t region = iterRegion;
+  uint32_t regionCycles = iterCycles;
+  iterRegion = LOOP_NO_REGION;
+  iterCycles = 0;
+  IRQ_Unlock(lock);
+
+  if (!loopStarted) {
+    loopStarted = 1;
+    loopLast = now;
+    return;
+  }
+
+  uint32_t us = DWT_CyclesToUs(now - loopLast - loopSleep);
+  loopLast = now;
+  loopSleep = 0;
+
+  HIST_Insert(&loopHist, (int32_t)us);
+
+  if (us > worstUs) {
+    worstUs = us;
+    worstRegion = region;
+    worstRegionUs = DWT_CyclesToUs(regionCycles);
+    worstTime = TIMER_GetTime();
+  }
+
+  if (us <= loopDeadline) {
+    return;
+  }
+
+  loopMissed++;
+  warnMissed++;
+
+  uint32_t time = TIMER_GetTime();
+
+  if (time - warnTime >= LOOP_WARN_PERIOD) {
+    LOOP_Warn(region, warnMissed, us);
+    warnMissed = 0;
+    warnTime = time;
+  }
+}
+/**
+ * @brief Warn about missed deadlines.
+ * @details LOG can't print strings, so every region has its
+ * own log site with the name in the format string.
+ * @param region Longest region of the last iteration
+ * @param missed Missed deadlines since the last warning
+ * @param us Duration of the last iteration
+ */
+static void LOOP_Warn(uint8_t region, uint32_t missed, uint32_t us) {
+
+/// Log site of a region (name as in PROF_Name)
+#define LOOP_WARN_REGION(name) \
+  case PROF_##name: \
+    LOG_WARN("Deadline missed %u times, last %u us (" #name ")", \
+        (unsigned int)missed, (unsigned int)us); \
+    break
+
+  switch (region) {
+  LOOP_WARN_REGION(TIMERS);
+  LOOP_WARN_REGION(KEYS);
+  LOOP_WARN_REGION(COMPASS);
+  LOOP_WARN_REGION(COMM);
+  LOOP_WARN_REGION(UTILS);
+  LOOP_WARN_REGION(LOG);
+  LOOP_WARN_REGION(REC);
+  LOOP_WARN_REGION(LCD);
+  LOOP_WARN_REGION(I2C);
+  LOOP_WARN_REGION(USART2);
+  default: // not profiled
+    LOG_WARN("Deadline missed %u times, last %u us",
+        (unsigned int)missed, (unsigned int)us);
+    break;
+  }
+
+#undef LOOP_WARN_REGION
+}
+/**
+ * @brief Sleep until the next interrupt.
+ * @details Call at the end of an iteration with nothing left to
+ * do - every event the loop waits for comes with an interrupt
+ * (SysTick wakes it every ms at the latest). Interrupts are
+ * masked around WFI, so the wakeup time is taken before the
+ * handler runs and only the sleep is left out of the iteration.
+ */
+void LOOP_Idle(void) {
+
+  __disable_irq();
+  uint32_t start = DWT_GetCycles();
+  __WFI(); // a pending interrupt wakes the core also with PRIMASK set
+  uint32_t cycles = DWT_GetCycles() - start;
+  __enable_irq(); // the handler runs here
+
+  loopSleep += cycles;
+  sleepCycles += cycles;
+
+  uint32_t msCycles = SystemCoreClock / 1000;
+  if (sleepCycles >= msCycles) {
+    sleepMs += sleepCycles / msCycles;
+    sleepCycles %= msCycles;
+  }
+}
+/**
+ * @brief Report a profiled region of the current iteration.
+ * @details Called by PROF_Add, also from interrupts.
+ * @param region Region (PROF_Region_TypeDef)
+ * @param cycles Duration of the region
+ */
+void LOOP_Blame(uint8_t region, uint32_t cycles) {
+
+  uint32_t lock = IRQ_Lock(IRQ_PRIO_APP);
+  if (cycles > iterCycles) {
+    iterCycles = cycles;
+    iterRegion = region;
+  }
+  IRQ_Unlock(lock);
+}
+/**
+ * @brief Set the deadline of an iteration.
+ * @param us Deadline in microseconds
+ */
+void LOOP_SetDeadline(uint32_t us) {
+
+  loopDeadline = us;
+  LOG_INFO("Deadline %u us", (unsigned int)us);
+}
+/**
+ * @brief Print iteration statistics to terminal.
+ */
+void LOOP_Print(void) {
+
+  uint32_t elapsed = TIMER_GetTime() - resetTime;
+
+  printf("LOOP--> Deadline %lu us, missed %lu, sleep %lu of %lu ms\r\n",
+      (unsigned long)loopDeadline, (unsigned long)loopMissed,
+      (unsigned long)sleepMs, (unsigned long)elapsed);
+
+  if (loopHist.count) {
+    printf("Worst %lu us at %lu ms, longest region %s %lu us\r\n",
+        (unsigned long)worstUs, (unsigned long)worstTime,
+        PROF_Name(worstRegion), (unsigned long)worstRegionUs);
+  }
+
+  printf("Iteration time (us):\r\n");
+  HIST_Print(&loopHist);
+}
+/**
+ * @brief Clear statistics.
+ * @details The next iteration is not measured - it is the
+ * one printing the statistics.
+ */
+void LOOP_Reset(void) {
+
+  HIST_Init(&loopHist);
+
+  loopMissed = 0;
+  loopStarted = 0;
+  loopSleep = 0;
+  sleepMs = 0;
+  sleepCycles = 0;
+  resetTime = TIMER_GetTime();
+
+  worstUs = 0;
+  worstRegion = LOOP_NO_REGION;
+  worstRegionUs = 0;
+  worstTime = 0;
+
+  warnMissed = 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,192 @@
+/**
+ * @file:   pcprof.c
+ * @brief:  Statistical profiling by sampling the program counter.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Counts are kept in an open addressing hash table
+ * indexed by the address, so the sampling interrupt does a
+ * few comparisons and no allocation. A sample is dropped
+ * (and counted) when its slot and the following
+ * PCPROF_PROBES - 1 slots hold other addresses.
+ *
+ * The table is written only by the sampling interrupt.
+ * Sampling is stopped while the table is cleared or sent.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <pcprof.h>
+#include <string.h>
+// HAL
+#include <tim5.h>
+
+#define LOG_MODULE        "PCPROF"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_PCPROF
+#include <log.h>
+
+/**
+ * @addtogroup PCPROF
+ * @{
+ */
+
+#define PCPROF_SLOT_BITS    9   ///< log2 of the number of table slots
+#define PCPROF_SLOTS        (1 << PCPROF_SLOT_BITS) ///< Number of table slots
+#define PCPROF_PROBES       8   ///< Slots tried for an address
+#define PCPROF_DUMP_RESERVE 8   ///< Log slots left free for messages while dumping
+
+/**
+ * @brief Table slot.
+ */
+typedef struct {
+  uint32_t pc;      ///< Sampled address
+  uint32_t count;   ///< Number of samples (0 - free slot)
+} PCPROF_Slot_TypeDef;
+
+static PCPROF_Slot_TypeDef pcSlots[PCPROF_SLOTS]; ///< Sample counts
+static volatile uint32_t pcSamples;   ///< Number of samples
+static volatile uint32_t pcDropped;   ///< Samples dropped (table full)
+static uint8_t sampling;              ///< Nonzero while sampling
+
+static uint8_t dumping;               ///< Nonzero while sending the table
+static uint8_t dumpHeader;            ///< Header not sent yet
+static uint8_t dumpRestart;           ///< Restart sampling after the dump
+static uint16_t dumpPos;              ///< Next slot to send
+static uint16_t dumpCount;            ///< Number of addresses sent
+
+static void PCPROF_Sample(uint32_t pc);
+
+/**
+ * @brief Initialize the profiler.
+ * @details Sampling is not started - the interrupt
+ * is enabled only while profiling.
+ */
+void PCPROF_Init(void) {
+  PCPROF_HAL_Init(PCPROF_FREQ, PCPROF_Sample);
+}
+/**
+ * @brief Start sampling with an empty table.
+ */
+void PCPROF_Start(void) {
+
+  if (dumping) {
+    dumpRestart = 1;
+    return;
+  }
+
+  PCPROF_HAL_Stop();
+
+  memset(pcSlots, 0, sizeof(pcSlots));
+  pcSamples = 0;
+  pcDropped = 0;
+
+  sampling = 1;
+  PCPROF_HAL_Start();
+
+  LOG_INFO("Sampling at %u Hz", PCPROF_FREQ);
+}
+/**
+ * @brief Stop sampling (the table keeps its counts).
+ */
+void PCPROF_Stop(void) {
+
+  PCPROF_HAL_Stop();
+  sampling = 0;
+  dumpRestart = 0;
+}
+/**
+ * @brief Send the table to COMM.
+ * @details Sampling stops until the counts are sent from
+ * PCPROF_Update, then it starts again if it was running.
+ */
+void PCPROF_Dump(void) {
+
+  if (dumping) {
+    return;
+  }
+
+  uint8_t restart = sampling;
+  PCPROF_Stop();
+  dumpRestart = restart;
+
+  dumpPos = 0;
+  dumpCount = 0;
+  dumpHeader = 1;
+  dumping = 1;
+}
+/**
+ * @brief Send pending counts of a dump.
+ * @details This function should be called in the main loop.
+ */
+void PCPROF_Update(void) {
+
+  if (!dumping) {
+    return;
+  }
+
+  if (dumpHeader) {
+    if (LOG_Free() <= PCPROF_DUMP_RESERVE) {
+      return;
+    }
+    LOG_Write(LOG_ID_PCPROF, 4, 0, PCPROF_FREQ, pcSamples, pcDropped);
+    dumpHeader = 0;
+  }
+
+  while (dumpPos < PCPROF_SLOTS && LOG_Free() > PCPROF_DUMP_RESERVE) {
+    PCPROF_Slot_TypeDef* slot = &pcSlots[dumpPos++];
+    if (slot->count) {
+      LOG_Write(LOG_ID_PCPROF, 2, slot->pc, slot->count);
+      dumpCount++;
+    }
+  }
+
+  if (dumpPos == PCPROF_SLOTS) {
+    dumping = 0;
+    LOG_INFO("Dumped %u addresses, %u samples, %u dropped", (unsigned int)dumpCount,
+        (unsigned int)pcSamples, (unsigned int)pcDropped);
+    if (dumpRestart) {
+      PCPROF_Start();
+    }
+  }
+}
+/**
+ * @brief Count a sample (sampling interrupt).
+ * @param pc Interrupted program counter
+ */
+static void PCPROF_Sample(uint32_t pc) {
+
+  // Fibonacci hashing - Thumb addresses are even
+  uint32_t index = ((pc >> 1) * 2654435761u) >> (32 - PCPROF_SLOT_BITS);
+  uint8_t i;
+
+  pcSamples++;
+
+  for (i = 0; i < PCPROF_PROBES; i++) {
+
+    PCPROF_Slot_TypeDef* slot = &pcSlots[(index + i) & (PCPROF_SLOTS - 1)];
+
+    if (slot->count == 0) {
+      slot->pc = pc;
+      slot->count = 1;
+      return;
+    }
+    if (slot->pc == pc) {
+      slot->count++;
+      return;
+    }
+  }
+
+  pcDropped++;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,198 @@
+/**
+ * @file:   prof.c
+ * @brief:  Cycle count profiling of code regions.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Every region keeps the number of passes and the
+ * total, minimum and maximum number of cycles. The cost of
+ * reading the cycle counter twice is measured at start and
+ * subtracted from every pass. Passes are also reported to
+ * the main loop monitor, which finds the cause of long
+ * iterations.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <prof.h>
+#include <loop.h>
+#include <timers.h>
+#include <stdio.h>
+// HAL
+#include <irq.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup PROF
+ * @{
+ */
+
+/**
+ * @brief Statistics of a region.
+ */
+typedef struct {
+  uint32_t count;   ///< Number of passes
+  uint64_t total;   ///< Sum of exclusive cycles
+  uint64_t totalIncl; ///< Sum of inclusive cycles
+  uint32_t min;     ///< Shortest pass (exclusive)
+  uint32_t max;     ///< Longest pass (exclusive)
+} PROF_Stats_TypeDef;
+
+/**
+ * @brief Names of regions (same order as PROF_Region_TypeDef).
+ */
+static const char* const profNames[PROF_REGIONS] = {
+    "TIMERS", "KEYS", "COMPASS", "COMM", "UTILS",
+    "LOG", "REC", "LCD", "I2C", "USART2",
+};
+
+static PROF_Stats_TypeDef profStats[PROF_REGIONS]; ///< Statistics of regions
+static uint32_t profOverhead;   ///< Cycles of an empty region
+static uint32_t profStart;      ///< Time of the last reset (ms)
+
+/**
+ * @brief Initialize profiling.
+ * @details Starts the cycle counter and measures the
+ * instrumentation overhead.
+ */
+void PROF_Init(void) {
+
+  DWT_Init();
+
+#if PROF_ENABLED
+  uint32_t min = UINT32_MAX;
+  uint8_t i;
+
+  for (i = 0; i < 8; i++) { // first passes fill the caches
+    PROF_BEGIN(PROF_REGIONS); // same as an empty region
+    uint32_t cycles = DWT_GetCycles() - profStart_PROF_REGIONS;
+    (void)profIrq_PROF_REGIONS;
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+  profOverhead = min;
+#endif
+
+  PROF_Reset();
+}
+/**
+ * @brief Add a pass of a region.
+ * @details Use PROF_END instead of calling directly.
+ * @param region Region
+ * @param cycles Measured cycles (with the overhead)
+ * @param irqCycles Cycles of interrupts which preempted the region
+ */
+void PROF_Add(PROF_Region_TypeDef region, uint32_t cycles, uint32_t irqCycles) {
+
+  PROF_Stats_TypeDef* stats = &profStats[region];
+
+  cycles = (cycles > profOverhead) ? cycles - profOverhead : 0;
+  stats->totalIncl += cycles;
+
+  cycles = (cycles > irqCycles) ? cycles - irqCycles : 0;
+
+  stats->count++;
+  stats->total += cycles;
+  if (cycles < stats->min) {
+    stats->min = cycles;
+  }
+  if (cycles > stats->max) {
+    stats->max = cycles;
+  }
+
+  LOOP_Blame(region, cycles);
+}
+/**
+ * @brief Print statistics of all regions to terminal.
+ * @details Times are in cycles, except the totals. The share
+ * is the exclusive total of the region per time since the
+ * reset. Only the inclusive total counts interrupts.
+ */
+void PROF_Print(void) {
+
+#if PROF_ENABLED
+  uint32_t elapsed = TIMER_GetTime() - profStart;
+  uint32_t mhz = SystemCoreClock / 1000000;
+  uint8_t i;
+
+  printf("PROF--> %lu ms, overhead %lu cycles\r\n",
+      (unsigned long)elapsed, (unsigned long)profOverhead);
+  printf("region      count   total us  share     avg     min     max    incl us\r\n");
+
+  for (i = 0; i < PROF_REGIONS; i++) {
+
+    PROF_Stats_TypeDef stats;
+
+    uint32_t lock = IRQ_Lock(IRQ_PRIO_APP); // consistent copy of regions updated by interrupts
+    stats = profStats[i];
+    IRQ_Unlock(lock);
+
+    if (stats.count == 0) {
+      printf("%-8s %8lu\r\n", profNames[i], 0UL);
+      continue;
+    }
+
+    uint32_t us = (uint32_t)(stats.total / mhz);
+    uint32_t share = elapsed ? us / elapsed : 0; // tenths of percent
+
+    printf("%-8s %8lu %10lu %4lu.%lu%% %7lu %7lu %7lu %10lu\r\n", profNames[i],
+        (unsigned long)stats.count, (unsigned long)us,
+        (unsigned long)(share / 10), (unsigned long)(share % 10),
+        (unsigned long)(stats.total / stats.count),
+        (unsigned long)stats.min, (unsigned long)stats.max,
+        (unsigned long)(stats.totalIncl / mhz));
+  }
+#if IRQSTAT_ENABLED
+  printf("Interrupts left out, except incl us (overlaps :IRQ)\r\n");
+#else
+  printf("Interrupts counted - IRQSTAT disabled, shares overlap\r\n");
+#endif
+#else
+  printf("PROF--> Profiling disabled\r\n");
+#endif
+}
+/**
+ * @brief Name of a region.
+ * @param region Region (PROF_Region_TypeDef)
+ * @return Name ("-" for an invalid region)
+ */
+const char* PROF_Name(uint8_t region) {
+
+  if (region >= PROF_REGIONS) {
+    return "-";
+  }
+
+  return profNames[region];
+}
+/**
+ * @brief Clear statistics of all regions.
+ */
+void PROF_Reset(void) {
+
+  uint8_t i;
+
+  for (i = 0; i < PROF_REGIONS; i++) {
+    uint32_t lock = IRQ_Lock(IRQ_PRIO_APP);
+    profStats[i].count = 0;
+    profStats[i].total = 0;
+    profStats[i].totalIncl = 0;
+    profStats[i].min = UINT32_MAX;
+    profStats[i].max = 0;
+    IRQ_Unlock(lock);
+  }
+
+  profStart = TIMER_GetTime();
+}
+
+/**
+ * @}
+ */
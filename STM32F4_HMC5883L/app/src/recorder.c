@@ -0,0 +1,335 @@
+/**
+ * @file:   recorder.c
+ * @brief:  Recording and replay of raw compass samples.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Samples are captured with the sample callback of
+ * the compass driver, so they are recorded exactly as read
+ * from the sensor, before any processing.
+ *
+ * Replay works below the driver: the recording replaces
+ * HMC5883L_HAL_Read for the data output registers and the
+ * whole pipeline (sampler, angle calculation, display) runs
+ * unchanged. One recorded sample is returned for every read
+ * of all six data registers, so samples are replayed at the
+ * sampling rate, not at the recorded times. In the host
+ * simulation with --virtual this is much faster than real time.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <recorder.h>
+#include <hmc5883l.h>
+#include <timers.h>
+#include <string.h>
+
+#define LOG_MODULE        "REC"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_REC
+#include <log.h>
+
+/**
+ * @addtogroup REC
+ * @{
+ */
+
+#define REC_DATA_FIRST    0x03  ///< First data output register of the compass
+#define REC_DATA_LAST     0x08  ///< Last data output register of the compass
+#define REC_STATUS        0x09  ///< Status register of the compass
+#define REC_STATUS_RDY    0x01  ///< Data ready bit
+#define REC_DATA_ALL      0x3f  ///< All data registers read
+#define REC_DUMP_RESERVE  8     ///< Log slots left free for messages while dumping
+
+/**
+ * @brief Offset in a sample record of the byte read from
+ * data register 0x03 + n (X MSB, X LSB, Z MSB, Z LSB, Y MSB, Y LSB).
+ */
+static const uint8_t replayOffset[REC_DATA_LAST - REC_DATA_FIRST + 1] = {
+    3, 2, 7, 6, 5, 4
+};
+
+static uint8_t recBuf[REC_BUF_LEN];   ///< On-chip recording
+static volatile uint32_t recLen;      ///< Number of bytes in recBuf
+static volatile uint8_t recording;    ///< Nonzero while recording
+static REC_Sink_TypeDef recSink;      ///< Destination of records
+static uint32_t recLastTime;          ///< Time of the previous sample (ms)
+
+static volatile uint8_t replaying;    ///< Nonzero while replaying
+static uint32_t playPos;              ///< Offset of the sample being replayed
+static uint8_t playMask;              ///< Data registers of the sample already read
+
+static uint8_t dumping;               ///< Nonzero while sending recBuf to COMM
+static uint32_t dumpPos;              ///< Offset of the next record to send
+
+static void REC_Sample(int16_t x, int16_t y, int16_t z);
+static void REC_Write(const uint8_t* rec);
+static uint8_t REC_ReplayRead(uint8_t address);
+static void REC_SendRecord(const uint8_t* rec);
+
+/**
+ * @brief Start recording.
+ * @details The header record is written right away. Recording
+ * to the buffer overwrites the previous recording.
+ * @param sink Destination of records
+ */
+void REC_Start(REC_Sink_TypeDef sink) {
+
+  REC_Stop();
+
+  if (sink == REC_SINK_BUFFER && (replaying || dumping)) {
+    LOG_WARN("Buffer in use");
+    return;
+  }
+
+  uint8_t header[REC_RECORD_LEN] = {REC_MAGIC1, REC_MAGIC2, REC_VERSION};
+  HMC5883L_GetConfig(&header[3]);
+
+  recSink = sink;
+  if (sink == REC_SINK_BUFFER) {
+    recLen = 0;
+  }
+  REC_Write(header);
+
+  recLastTime = TIMER_GetTime();
+  recording = 1;
+  HMC5883L_SetSampleCallback(REC_Sample);
+
+  LOG_INFO("Recording to %c", sink == REC_SINK_BUFFER ? 'B' : 'C');
+}
+/**
+ * @brief Stop recording.
+ */
+void REC_Stop(void) {
+
+  if (recording) {
+    HMC5883L_SetSampleCallback(NULL);
+    recording = 0;
+    if (recSink == REC_SINK_BUFFER) {
+      LOG_INFO("Recorded %u samples", (unsigned int)(recLen / REC_RECORD_LEN - 1));
+    } else {
+      LOG_INFO("Recording stopped");
+    }
+  }
+}
+/**
+ * @brief Replay the recording in the buffer.
+ * @details Replay stops by itself after the last sample and
+ * the compass is read again.
+ * @retval 0 Replay started
+ * @retval 1 No valid recording in the buffer
+ */
+uint8_t REC_Play(void) {
+
+  if (recording && recSink == REC_SINK_BUFFER) {
+    LOG_WARN("Buffer in use");
+    return 1;
+  }
+
+  if (recLen < 2 * REC_RECORD_LEN || recBuf[0] != REC_MAGIC1 ||
+      recBuf[1] != REC_MAGIC2 || recBuf[2] != REC_VERSION) {
+    LOG_WARN("No recording");
+    return 1;
+  }
+
+  uint8_t config[HMC5883L_CONFIG_LEN];
+  HMC5883L_GetConfig(config);
+
+  if (memcmp(config, &recBuf[3], HMC5883L_CONFIG_LEN)) {
+    LOG_WARN("Recorded with config %02x %02x %02x", recBuf[3], recBuf[4], recBuf[5]);
+  }
+
+  playPos = REC_RECORD_LEN;
+  playMask = 0;
+  replaying = 1;
+  HMC5883L_SetSource(REC_ReplayRead);
+
+  LOG_INFO("Replaying %u samples", (unsigned int)(recLen / REC_RECORD_LEN - 1));
+
+  return 0;
+}
+/**
+ * @brief Send the recording in the buffer to COMM.
+ * @details Records are sent from REC_Update, leaving room
+ * for log messages.
+ */
+void REC_Dump(void) {
+
+  if (recording && recSink == REC_SINK_BUFFER) {
+    LOG_WARN("Buffer in use");
+    return;
+  }
+
+  dumpPos = 0;
+  dumping = 1;
+}
+/**
+ * @brief Send pending records of a dump.
+ * @details This function should be called in the main loop.
+ */
+void REC_Update(void) {
+
+  if (!dumping) {
+    return;
+  }
+
+  while (dumpPos < recLen && LOG_Free() > REC_DUMP_RESERVE) {
+    REC_SendRecord(&recBuf[dumpPos]);
+    dumpPos += REC_RECORD_LEN;
+  }
+
+  if (dumpPos >= recLen) {
+    dumping = 0;
+    LOG_INFO("Dumped %u bytes", (unsigned int)recLen);
+  }
+}
+/**
+ * @brief Load a recording into the buffer.
+ * @details Used to replay recordings made elsewhere, e.g.
+ * on the host. Recording, replay and dump are stopped.
+ * @param data Recording
+ * @param len Length in bytes
+ * @return Number of bytes loaded (whole records that fit the buffer)
+ */
+uint32_t REC_Load(const uint8_t* data, uint32_t len) {
+
+  REC_Stop();
+
+  if (replaying) {
+    HMC5883L_SetSource(NULL);
+    replaying = 0;
+  }
+  dumping = 0;
+
+  if (len > REC_BUF_LEN) {
+    len = REC_BUF_LEN;
+  }
+  len -= len % REC_RECORD_LEN;
+
+  memcpy(recBuf, data, len);
+  recLen = len;
+
+  return len;
+}
+/**
+ * @brief Log the state of the recorder.
+ */
+void REC_PrintStatus(void) {
+
+  uint32_t samples = recLen ? recLen / REC_RECORD_LEN - 1 : 0;
+
+  LOG_INFO("Buffer %u/%u samples, recording %u, replay %u",
+      (unsigned int)samples, (unsigned int)(REC_BUF_LEN / REC_RECORD_LEN - 1),
+      (unsigned int)recording,
+      (unsigned int)(replaying ? playPos / REC_RECORD_LEN : 0));
+}
+/**
+ * @brief Sample callback of the compass driver.
+ * @param x X reading
+ * @param y Y reading
+ * @param z Z reading
+ */
+static void REC_Sample(int16_t x, int16_t y, int16_t z) {
+
+  uint32_t now = TIMER_GetTime();
+  uint32_t dt = now - recLastTime;
+  recLastTime = now;
+
+  if (dt > 0xffff) {
+    dt = 0xffff;
+  }
+
+  uint8_t rec[REC_RECORD_LEN] = {
+      dt, dt >> 8,
+      (uint16_t)x, (uint16_t)x >> 8,
+      (uint16_t)y, (uint16_t)y >> 8,
+      (uint16_t)z, (uint16_t)z >> 8,
+  };
+
+  REC_Write(rec);
+}
+/**
+ * @brief Write a record to the sink.
+ * @param rec Record (REC_RECORD_LEN bytes)
+ */
+static void REC_Write(const uint8_t* rec) {
+
+  if (recSink == REC_SINK_COMM) {
+    REC_SendRecord(rec);
+    return;
+  }
+
+  if (recLen + REC_RECORD_LEN > REC_BUF_LEN) {
+    HMC5883L_SetSampleCallback(NULL);
+    recording = 0;
+    LOG_WARN("Buffer full");
+    return;
+  }
+
+  memcpy(&recBuf[recLen], rec, REC_RECORD_LEN);
+  recLen += REC_RECORD_LEN;
+}
+/**
+ * @brief Register read function replaying the recording.
+ * @details Reads of data registers return the current sample,
+ * which is replaced when all six registers were read - like
+ * the data lock of the sensor.
+ * @param address Register address
+ * @return Register value
+ */
+static uint8_t REC_ReplayRead(uint8_t address) {
+
+  if (address < HMC5883L_CONFIG_LEN) {
+    return recBuf[3 + address]; // recorded configuration
+  }
+  if (address == REC_STATUS) {
+    return REC_STATUS_RDY;
+  }
+  if (address < REC_DATA_FIRST || address > REC_DATA_LAST) {
+    return 0;
+  }
+
+  uint8_t value = recBuf[playPos + replayOffset[address - REC_DATA_FIRST]];
+  playMask |= 1 << (address - REC_DATA_FIRST);
+
+  if (playMask == REC_DATA_ALL) {
+
+    playMask = 0;
+    playPos += REC_RECORD_LEN;
+
+    if (playPos >= recLen) { // last sample - back to the sensor
+      HMC5883L_SetSource(NULL);
+      replaying = 0;
+      LOG_INFO("Replay finished");
+    }
+  }
+
+  return value;
+}
+/**
+ * @brief Send a record in a log frame.
+ * @param rec Record (REC_RECORD_LEN bytes)
+ */
+static void REC_SendRecord(const uint8_t* rec) {
+
+  uint32_t words[2];
+  uint8_t i;
+
+  for (i = 0; i < 2; i++) {
+    words[i] = rec[4 * i] | (rec[4 * i + 1] << 8) |
+        (rec[4 * i + 2] << 16) | ((uint32_t)rec[4 * i + 3] << 24);
+  }
+
+  LOG_Write(LOG_ID_REC, 2, words[0], words[1]);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,238 @@
+/**
+ * @file:   sampler.c
+ * @brief:  Periodic sampling of the compass.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Every sensor read is requested by a hardware timer
+ * interrupt, so the sampling rate doesn't depend on the main loop.
+ *
+ * The interrupt only requests a read. The read itself (six
+ * registers on the 1kHz I2C bus, over 200ms) is a protothread run
+ * by SAMPLER_Update in the main loop, so it never blocks an
+ * interrupt. A request which comes before the previous read started
+ * is counted as missed.
+ *
+ * Jitter is measured where the sample is taken - the cycle counter
+ * is read when the I2C read starts, and the deviation of the
+ * interval between read starts from the nominal period goes to a
+ * histogram. So a main loop which comes late to a request shows up
+ * as jitter, and the longest delay from the request to the read is
+ * kept too.
+ *
+ * @warning The compass must not be read anywhere else while
+ * sampling is running - use SAMPLER_GetSample instead.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <sampler.h>
+#include <hmc5883l.h>
+#include <pt.h>
+#include <histogram.h>
+#include <stdio.h>
+// HAL
+#include <tim2.h>
+#include <dwt.h>
+#include <stm32f4xx.h>
+
+#define LOG_MODULE        "SAMPLER"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_SAMPLER
+#include <log.h>
+
+/**
+ * @addtogroup SAMPLER
+ * @{
+ */
+
+#define SAMPLER_JITTER_BINS   16  ///< Number of jitter histogram bins
+#define SAMPLER_JITTER_WIDTH  5   ///< Width of jitter bin in us
+
+static uint32_t jitterBins[SAMPLER_JITTER_BINS]; ///< Jitter histogram bins
+static HIST_TypeDef jitterHist;   ///< Deviation of sampling interval from period in us
+
+static uint32_t period;           ///< Nominal sampling period in us
+static uint32_t prevTimestamp;    ///< Cycle counter at the start of the previous read
+static uint8_t prevValid;         ///< Is prevTimestamp valid?
+static uint32_t maxDelay;         ///< Longest delay from the request to the read in us
+
+static volatile uint8_t readRequest; ///< Set by the interrupt, cleared when the read starts
+static volatile uint32_t requestTime; ///< Cycle counter at the request
+static volatile uint32_t missed;  ///< Requests which came before the previous read started
+static uint8_t reading;           ///< Nonzero while a read is running
+
+static PT_TypeDef readPt;         ///< Read thread
+static PT_TypeDef xyzPt;          ///< Compass read started by the read thread
+static int16_t readX;             ///< X reading of the running read
+static int16_t readY;             ///< Y reading of the running read
+static int16_t readZ;             ///< Z reading of the running read
+
+static int16_t sampleX;           ///< Latest X reading
+static int16_t sampleY;           ///< Latest Y reading
+static int16_t sampleZ;           ///< Latest Z reading
+static uint8_t newSample;         ///< Nonzero signals a new sample
+
+static void SAMPLER_Callback(void);
+static PT_THREAD(SAMPLER_ReadThread(PT_TypeDef* pt));
+
+/**
+ * @brief Initialize periodic sampling.
+ * @param freq Sampling frequency in Hz
+ */
+void SAMPLER_Init(uint32_t freq) {
+
+  period = 1000000 / freq;
+  PT_INIT(&readPt);
+
+  jitterHist.bins  = jitterBins;
+  jitterHist.len   = SAMPLER_JITTER_BINS;
+  jitterHist.width = SAMPLER_JITTER_WIDTH;
+  jitterHist.low   = -(SAMPLER_JITTER_BINS / 2) * SAMPLER_JITTER_WIDTH;
+  HIST_Init(&jitterHist);
+
+  DWT_Init();
+  SAMPLER_HAL_Init(freq, SAMPLER_Callback);
+}
+/**
+ * @brief Start sampling.
+ */
+void SAMPLER_Start(void) {
+
+  prevValid = 0;
+  readRequest = 0;
+  SAMPLER_HAL_Start();
+}
+/**
+ * @brief Stop sampling.
+ */
+void SAMPLER_Stop(void) {
+  SAMPLER_HAL_Stop();
+}
+/**
+ * @brief Runs the compass reads requested by the timer.
+ * @details This function should be called in the main loop.
+ */
+void SAMPLER_Update(void) {
+  SAMPLER_ReadThread(&readPt);
+}
+/**
+ * @brief Checks whether a compass read is requested or running.
+ * @details The read polls the I2C bus, so the main loop must
+ * not sleep while it runs.
+ * @retval 1 Read pending
+ * @retval 0 Waiting for the timer
+ */
+uint8_t SAMPLER_IsBusy(void) {
+  return (readRequest || reading) ? 1 : 0;
+}
+/**
+ * @brief Get the latest sample.
+ * @param x X reading
+ * @param y Y reading
+ * @param z Z reading
+ * @retval 0 New sample since last call
+ * @retval 1 No new sample (values of the previous sample are returned)
+ */
+uint8_t SAMPLER_GetSample(int16_t* x, int16_t* y, int16_t* z) {
+
+  uint8_t ret;
+
+  // written by SAMPLER_Update - same context, no lock
+  *x = sampleX;
+  *y = sampleY;
+  *z = sampleZ;
+  ret = newSample ? 0 : 1;
+  newSample = 0;
+
+  return ret;
+}
+/**
+ * @brief Print jitter statistics (in us) to terminal.
+ * @details The histogram holds deviations of intervals between
+ * starts of compass reads from the sampling period.
+ */
+void SAMPLER_PrintJitter(void) {
+
+  // written by SAMPLER_Update - same context, no lock
+  printf("SAMPLER--> Sampling period %lu us, missed %lu, read delay max %lu us, "
+      "jitter of reads:\r\n", (unsigned long)period, (unsigned long)missed,
+      (unsigned long)maxDelay);
+  HIST_Print(&jitterHist);
+}
+/**
+ * @brief Clear jitter statistics.
+ */
+void SAMPLER_ResetJitter(void) {
+
+  HIST_Init(&jitterHist);
+  prevValid = 0;
+  maxDelay = 0;
+
+  uint32_t lock = SAMPLER_HAL_IrqLock();
+  missed = 0;
+  SAMPLER_HAL_IrqUnlock(lock);
+}
+/**
+ * @brief Timer callback - requests a compass read.
+ */
+static void SAMPLER_Callback(void) {
+
+  // compass initialization is still using the bus
+  if (!HMC5883L_IsReady()) {
+    return;
+  }
+
+  if (readRequest) { // previous read didn't start yet
+    missed++;
+  }
+  requestTime = DWT_GetCycles();
+  readRequest = 1;
+}
+/**
+ * @brief Compass read thread.
+ * @param pt Thread control structure
+ */
+static PT_THREAD(SAMPLER_ReadThread(PT_TypeDef* pt)) {
+
+  PT_BEGIN(pt);
+
+  PT_WAIT_UNTIL(pt, readRequest);
+
+  uint32_t timestamp = DWT_GetCycles(); // the sample is taken now
+  uint32_t delay = DWT_CyclesToUs(timestamp - requestTime);
+
+  readRequest = 0;
+  reading = 1;
+
+  if (delay > maxDelay) {
+    maxDelay = delay;
+  }
+  if (prevValid) {
+    uint32_t interval = DWT_CyclesToUs(timestamp - prevTimestamp);
+    HIST_Insert(&jitterHist, (int32_t)(interval - period));
+  }
+  prevTimestamp = timestamp;
+  prevValid = 1;
+
+  PT_SPAWN(pt, &xyzPt, HMC5883L_ReadXYZThread(&xyzPt, &readX, &readY, &readZ));
+
+  sampleX = readX;
+  sampleY = readY;
+  sampleZ = readZ;
+  newSample = 1;
+  reading = 0;
+
+  PT_END(pt);
+}
+
+/**
+ * @}
+ */
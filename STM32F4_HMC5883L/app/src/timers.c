@@ -20,21 +20,14 @@
  */
 
 #include <timers.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <systick.h>
+#include <trace.h>
 
 
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("LED--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LED--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
+#define LOG_MODULE        "TIMER"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_TIMER
+#include <log.h>
 
 /**
  * @addtogroup TIMER
@@ -43,21 +36,41 @@
 
 #define MAX_SOFT_TIMERS 10 ///< Maximum number of soft timers.
 
-static uint8_t softTimerCount; ///< Count number of soft timers
+/*
+ * Timer IDs carry the slot in the low bits and a generation
+ * count of the slot in the high bits, so that an ID kept after
+ * TIMER_RemoveSoftTimer doesn't control the next timer which
+ * gets the same slot. IDs stay positive int8_t values.
+ */
+#define TIMER_SLOT_BITS 4     ///< Bits of the slot number in an ID
+#define TIMER_SLOT_MASK ((1 << TIMER_SLOT_BITS) - 1) ///< Slot number of an ID
+#define TIMER_GEN_MASK  0x07  ///< Generation count (fills the rest of an int8_t)
+
+static uint8_t softTimerCount; ///< Number of soft timer slots ever used
+static int8_t  freeTimers = -1; ///< First free slot (freelist head), -1 if empty
 
 /**
  * @brief Soft timer structure.
  */
 typedef struct {
-  uint8_t id;                     ///< Timer ID
-  uint32_t value;                 ///< Current count value
-  uint32_t max;                   ///< Overflow value
-  uint8_t active;                 ///< Is timer active?
-  void (*overflowCallback)(void); ///< Function called on overflow event
+  uint8_t id;                       ///< Timer ID (slot and generation)
+  uint32_t value;                   ///< Current count value
+  uint32_t max;                     ///< Overflow value
+  uint8_t used;                     ///< Is slot allocated?
+  uint8_t active;                   ///< Is timer active?
+  uint8_t expired;                  ///< Overflow detected, callback pending
+  TIMER_Mode_TypeDef mode;          ///< Periodic or one-shot
+  int8_t next;                      ///< Next free slot (valid only when slot is free)
+  void (*overflowCallback)(void);   ///< Function called on overflow event (no parameters)
+  TIMER_Callback_TypeDef callback;  ///< Function called on overflow event (with context)
+  void* context;                    ///< Context passed to callback
 } TIMER_Soft_TypeDef;
 
 static TIMER_Soft_TypeDef softTimers[MAX_SOFT_TIMERS]; ///< Array of soft timers
 
+static int8_t TIMER_AllocSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode);
+static int8_t TIMER_Slot(uint8_t id);
+
 /**
  * @brief Initiate the system time interrupt with a given frequency.
  * @param freq Required frequency of the timer in Hz
@@ -129,30 +142,93 @@ uint8_t TIMER_DelayTimer(uint32_t ms, uint32_t startTime) {
  */
 int8_t TIMER_AddSoftTimer(uint32_t maxVal, void (*fun)(void)) {
 
-  if (softTimerCount > MAX_SOFT_TIMERS) {
-    println("TIMERS: Reached maximum number of timers!");
-    return -1;
+  int8_t id = TIMER_AllocSoftTimer(maxVal, TIMER_PERIODIC);
+
+  if (id >= 0) {
+    softTimers[id & TIMER_SLOT_MASK].overflowCallback = fun;
   }
 
-  softTimers[softTimerCount].id = softTimerCount;
-  softTimers[softTimerCount].overflowCallback = fun;
-  softTimers[softTimerCount].max = maxVal;
-  softTimers[softTimerCount].value = 0;
-  softTimers[softTimerCount].active = 0; // inactive on startup
+  return id;
+}
+/**
+ * @brief Creates a soft timer with a context pointer.
+ * @details The timer is inactive after creation - use TIMER_StartSoftTimer.
+ * One-shot timers stop after the first overflow, but keep their slot
+ * until TIMER_RemoveSoftTimer is called, so they can be rearmed.
+ * @param maxVal Overflow value of timer
+ * @param mode Periodic or one-shot timer
+ * @param fun Function called on overflow (gets timer ID and context)
+ * @param context Pointer passed to the callback
+ * @return Returns the ID of the new counter or error code (-1)
+ * @retval -1 Error: too many timers
+ */
+int8_t TIMER_CreateSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode,
+    TIMER_Callback_TypeDef fun, void* context) {
+
+  int8_t id = TIMER_AllocSoftTimer(maxVal, mode);
 
-  softTimerCount++;
+  if (id >= 0) {
+    softTimers[id & TIMER_SLOT_MASK].callback = fun;
+    softTimers[id & TIMER_SLOT_MASK].context = context;
+  }
 
-  return (softTimerCount - 1);
+  return id;
 }
+/**
+ * @brief Removes a soft timer and frees its slot.
+ * @details Can be safely called from a timer callback (also for
+ * the timer that called it).
+ * The ID stays invalid when a new timer gets the slot.
+ * @param id Timer ID
+ */
+void TIMER_RemoveSoftTimer(uint8_t id) {
+
+  int8_t slot = TIMER_Slot(id);
+
+  if (slot < 0) {
+    return;
+  }
 
+  softTimers[slot].used = 0;
+  softTimers[slot].active = 0;
+  softTimers[slot].expired = 0; // don't call pending callback
+  softTimers[slot].next = freeTimers;
+  freeTimers = slot;
+}
 /**
  * @brief Starts the timer (zeroes out current count value).
+ * @details Can be used to rearm a timer from its own callback. A
+ * timer rearmed by an earlier callback of the same update isn't
+ * called in that update.
  * @param id Timer ID
  */
 void TIMER_StartSoftTimer(uint8_t id) {
 
-  softTimers[id].value = 0;
-  softTimers[id].active = 1; // start timer
+  int8_t slot = TIMER_Slot(id);
+
+  if (slot < 0) {
+    return;
+  }
+
+  softTimers[slot].value = 0;
+  softTimers[slot].active = 1; // start timer
+  softTimers[slot].expired = 0; // rearmed before its callback in this update
+}
+/**
+ * @brief Starts the timer with a new overflow value.
+ * @param id Timer ID
+ * @param maxVal New overflow value of timer
+ */
+void TIMER_RestartSoftTimer(uint8_t id, uint32_t maxVal) {
+
+  int8_t slot = TIMER_Slot(id);
+
+  if (slot < 0) {
+    return;
+  }
+
+  softTimers[slot].max = maxVal;
+  TIMER_StartSoftTimer(id);
 }
 /**
  * @brief Pauses given timer (current count value unchanged)
@@ -160,7 +236,14 @@ void TIMER_StartSoftTimer(uint8_t id) {
  */
 void TIMER_PauseSoftTimer(uint8_t id) {
 
-  softTimers[id].active = 0; // pause timer
+  int8_t slot = TIMER_Slot(id);
+
+  if (slot < 0) {
+    return;
+  }
+
+  softTimers[slot].active = 0; // pause timer
+  softTimers[slot].expired = 0;
 }
 /**
  * @brief Resumes a timer (starts counting from last value).
@@ -168,36 +251,38 @@ void TIMER_PauseSoftTimer(uint8_t id) {
  */
 void TIMER_ResumeSoftTimer(uint8_t id) {
 
-  softTimers[id].active = 1; // start timer
+  int8_t slot = TIMER_Slot(id);
+
+  if (slot < 0) {
+    return;
+  }
+
+  softTimers[slot].active = 1; // start timer
 }
 /**
  * @brief Updates all the timers and calls the overflow functions as
  * necessary
  *
  * @details This function should be called periodically in the main
- * loop of the program.
+ * loop of the program. Periodic timers keep the time which passed
+ * after the overflow, so they don't drift however often this is
+ * called (periods missed altogether are skipped).
  */
 void TIMER_SoftTimersUpdate(void) {
 
   static uint32_t prevVal;
-  uint32_t delta;
   uint32_t sysTicks = SYSTICK_GetTime();
 
-  if (sysTicks >= prevVal) {
-
-    delta = sysTicks - prevVal; // How much time passed from previous run
+  // How much time passed from previous run (unsigned - also across
+  // the overflow of the system time)
+  uint32_t delta = sysTicks - prevVal;
 
-  } else { // if overflow occurs
-
-    // the difference is the value that prevVal
-    // has to UINT32_MAX + the new number of sysTicks
-    delta = UINT32_MAX - prevVal + sysTicks;
-
-  }
-
-  prevVal += delta; // update time for the function
+  prevVal = sysTicks; // update time for the function
 
   uint8_t i;
+
+  // First update all the timers, so that callbacks which add, remove
+  // or rearm timers don't influence the current run.
   for (i = 0; i < softTimerCount; i++) {
 
     if (softTimers[i].active == 1) {
@@ -205,13 +290,98 @@ void TIMER_SoftTimersUpdate(void) {
       softTimers[i].value += delta; // update active timer values
 
       if (softTimers[i].value >= softTimers[i].max) { // if overflow
-        softTimers[i].value = 0; // zero out timer
-        if (softTimers[i].overflowCallback != NULL) {
-          softTimers[i].overflowCallback(); // call the overflow function
-        }
+        softTimers[i].expired = 1;
       }
     }
   }
+
+  // Call the overflow functions
+  for (i = 0; i < softTimerCount; i++) {
+
+    if (softTimers[i].expired == 0) {
+      continue;
+    }
+
+    softTimers[i].expired = 0;
+
+    if (softTimers[i].mode == TIMER_ONE_SHOT) {
+      softTimers[i].value = 0; // zero out timer
+      softTimers[i].active = 0; // stop timer (callback may rearm it)
+    } else if (softTimers[i].max) {
+      // next period started at the overflow, not now
+      softTimers[i].value = (softTimers[i].value - softTimers[i].max) %
+          softTimers[i].max;
+    } else {
+      softTimers[i].value = 0;
+    }
+
+    TRACE_BEGIN(TRACE_SOFT_TIMER, i);
+
+    if (softTimers[i].overflowCallback != NULL) {
+      softTimers[i].overflowCallback(); // call the overflow function
+    } else if (softTimers[i].callback != NULL) {
+      softTimers[i].callback(softTimers[i].id, softTimers[i].context);
+    }
+
+    TRACE_END(TRACE_SOFT_TIMER, i);
+  }
+}
+/**
+ * @brief Allocates a soft timer slot.
+ * @details Slots of removed timers are reused first, with the
+ * generation count of the slot advanced.
+ * @param maxVal Overflow value of timer
+ * @param mode Periodic or one-shot timer
+ * @return Returns the ID of the new counter or error code (-1)
+ * @retval -1 Error: too many timers
+ */
+static int8_t TIMER_AllocSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode) {
+
+  int8_t id;
+  uint8_t gen = 0;
+
+  if (freeTimers >= 0) { // reuse freed slot
+    id = freeTimers;
+    freeTimers = softTimers[id].next;
+    gen = ((softTimers[id].id >> TIMER_SLOT_BITS) + 1) & TIMER_GEN_MASK;
+  } else if (softTimerCount < MAX_SOFT_TIMERS) {
+    id = softTimerCount++;
+  } else {
+    LOG_ERROR("Reached maximum number of timers!");
+    return -1;
+  }
+
+  softTimers[id].id = (gen << TIMER_SLOT_BITS) | id;
+  softTimers[id].overflowCallback = NULL;
+  softTimers[id].callback = NULL;
+  softTimers[id].context = NULL;
+  softTimers[id].max = maxVal;
+  softTimers[id].value = 0;
+  softTimers[id].mode = mode;
+  softTimers[id].expired = 0;
+  softTimers[id].active = 0; // inactive on startup
+  softTimers[id].used = 1;
+
+  return softTimers[id].id;
+}
+/**
+ * @brief Finds the slot of an allocated timer.
+ * @details IDs of removed timers are invalid, also after their
+ * slot was given to a new timer (the generation differs).
+ * @param id Timer ID
+ * @return Slot of the timer or -1 if the ID is invalid
+ */
+static int8_t TIMER_Slot(uint8_t id) {
+
+  uint8_t slot = id & TIMER_SLOT_MASK;
+
+  if (slot >= softTimerCount || softTimers[slot].used == 0 ||
+      softTimers[slot].id != id) {
+    LOG_ERROR("Invalid timer %d!", (int)id);
+    return -1;
+  }
+
+  return slot;
 }
 
 /**
@@ -0,0 +1,184 @@
+/**
+ * @file:   trace.c
+ * @brief:  Event trace ring buffer.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Writers (main loop and interrupts) reserve a slot
+ * by incrementing the head index with LDREX/STREX, like the
+ * log records, and no interrupts are disabled. An interrupt
+ * can write its events between the reservation and the time
+ * stamp of the preempted writer, so events in the ring are
+ * ordered by time only approximately - the host tool sorts them.
+ *
+ * Tracing is stopped while the ring is dumped and restarted
+ * with an empty ring afterwards.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <trace.h>
+// HAL
+#include <dwt.h>
+#include <stm32f4xx.h>
+
+#define LOG_MODULE        "TRACE"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_TRACE_BUF
+#include <log.h>
+
+/**
+ * @addtogroup TRACE
+ * @{
+ */
+
+#define TRACE_BUF_LEN       512 ///< Number of events in the ring (power of 2)
+#define TRACE_CALIBRATION   16  ///< Events written to measure the overhead
+#define TRACE_DUMP_RESERVE  8   ///< Log slots left free for messages while dumping
+
+/**
+ * @brief Trace event.
+ */
+typedef struct {
+  uint32_t time;    ///< Cycle counter
+  uint32_t info;    ///< Type, operation and argument (TRACE_INFO)
+} TRACE_Event_TypeDef;
+
+static TRACE_Event_TypeDef traceBuf[TRACE_BUF_LEN]; ///< Event ring
+static volatile uint32_t traceHead;   ///< Number of events written
+static volatile uint8_t traceOn;      ///< Nonzero while tracing
+static uint32_t traceOverhead;        ///< Cycles of writing one event
+
+static uint8_t dumping;               ///< Nonzero while sending the ring
+static uint8_t dumpHeader;            ///< Header not sent yet
+static uint8_t dumpRestart;           ///< Restart tracing after the dump
+static uint32_t dumpPos;              ///< Next event to send
+static uint32_t dumpEnd;              ///< Event after the last one to send
+
+/**
+ * @brief Initialize and start tracing.
+ * @details Measures the cost of writing an event.
+ */
+void TRACE_Init(void) {
+
+  DWT_Init();
+
+  traceOn = 1;
+
+  uint32_t start = DWT_GetCycles();
+  uint8_t i;
+  for (i = 0; i < TRACE_CALIBRATION; i++) {
+    TRACE_Write(TRACE_INFO(TRACE_TYPE_INSTANT, TRACE_IDS, i));
+  }
+  traceOverhead = (DWT_GetCycles() - start) / TRACE_CALIBRATION;
+
+  traceHead = 0;
+
+  LOG_INFO("Event overhead %u cycles", (unsigned int)traceOverhead);
+}
+/**
+ * @brief Write an event.
+ * @details Use the TRACE_BEGIN, TRACE_END and TRACE_INSTANT
+ * macros instead of calling directly. Safe to call from interrupts.
+ * @param info Info word (TRACE_INFO)
+ */
+void TRACE_Write(uint32_t info) {
+
+  if (!traceOn) {
+    return;
+  }
+
+  uint32_t head;
+
+  do {
+    head = __LDREXW(&traceHead);
+  } while (__STREXW(head + 1, &traceHead));
+
+  TRACE_Event_TypeDef* ev = &traceBuf[head & (TRACE_BUF_LEN - 1)];
+  ev->time = DWT_GetCycles();
+  ev->info = info;
+}
+/**
+ * @brief Start tracing (with an empty ring).
+ */
+void TRACE_Start(void) {
+
+  if (dumping) {
+    dumpRestart = 1;
+    return;
+  }
+
+  traceHead = 0;
+  traceOn = 1;
+}
+/**
+ * @brief Stop tracing (the ring keeps its events).
+ */
+void TRACE_Stop(void) {
+
+  traceOn = 0;
+  dumpRestart = 0;
+}
+/**
+ * @brief Send the ring to COMM.
+ * @details Tracing stops until the events are sent from
+ * TRACE_Update, then it starts again if it was running.
+ */
+void TRACE_Dump(void) {
+
+  if (dumping) {
+    return;
+  }
+
+  dumpRestart = traceOn;
+  traceOn = 0;
+
+  dumpEnd = traceHead;
+  dumpPos = (dumpEnd > TRACE_BUF_LEN) ? dumpEnd - TRACE_BUF_LEN : 0;
+  dumpHeader = 1;
+  dumping = 1;
+}
+/**
+ * @brief Send pending events of a dump.
+ * @details This function should be called in the main loop.
+ */
+void TRACE_Update(void) {
+
+  if (!dumping) {
+    return;
+  }
+
+  if (dumpHeader) {
+    if (LOG_Free() <= TRACE_DUMP_RESERVE) {
+      return;
+    }
+    LOG_Write(LOG_ID_TRACE, 2, SystemCoreClock,
+        TRACE_INFO(TRACE_TYPE_HEADER, TRACE_IDS, traceOverhead));
+    dumpHeader = 0;
+  }
+
+  while (dumpPos != dumpEnd && LOG_Free() > TRACE_DUMP_RESERVE) {
+    TRACE_Event_TypeDef* ev = &traceBuf[dumpPos & (TRACE_BUF_LEN - 1)];
+    LOG_Write(LOG_ID_TRACE, 2, ev->time, ev->info);
+    dumpPos++;
+  }
+
+  if (dumpPos == dumpEnd) {
+    dumping = 0;
+    LOG_INFO("Dumped %u events", (unsigned int)(dumpEnd > TRACE_BUF_LEN ? TRACE_BUF_LEN : dumpEnd));
+    if (dumpRestart) {
+      TRACE_Start();
+    }
+  }
+}
+
+/**
+ * @}
+ */
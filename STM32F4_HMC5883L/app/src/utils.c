@@ -18,37 +18,78 @@
 
 #include <utils.h>
 #include <stdio.h>
-#include <timers.h>
+#include <pt.h>
 
 /**
  * @addtogroup UTILS
  * @{
  */
 
+static PT_THREAD(hexdumpThread(PT_TypeDef* pt));
+
+static PT_TypeDef dumpPt;     ///< Hexdump thread
+static uint8_t* dumpBuf;      ///< Buffer being dumped
+static uint32_t dumpLength;   ///< Number of bytes to dump
+static uint32_t dumpPos;      ///< Number of bytes already dumped
+
 /**
  * @brief Send data in hex format to terminal.
+ * @details The dump is only started here - the data is sent
+ * from UTILS_Update, so the buffer has to stay valid until
+ * the dump finishes.
  * @param buf Data buffer.
  * @param length Number of bytes to send.
- * @warning Uses blocking delays so as not to overflow buffer.
+ * @retval 0 Dump started
+ * @retval 1 Error: previous dump still running
  */
-void hexdump(uint8_t* buf, uint32_t length) {
+uint8_t hexdump(uint8_t* buf, uint32_t length) {
 
-  uint32_t i = 0;
+  if (dumpPos < dumpLength) {
+    return 1;
+  }
 
-  while (length--) {
+  dumpBuf = buf;
+  dumpLength = length;
+  dumpPos = 0;
+  PT_INIT(&dumpPt);
 
-    printf("%02x ", buf[i]);
+  return 0;
+}
+/**
+ * @brief Runs pending utility tasks (hexdump).
+ * @details This function should be called in the main loop.
+ */
+void UTILS_Update(void) {
 
-    i++;
+  if (dumpPos < dumpLength) {
+    hexdumpThread(&dumpPt);
+  }
+}
+/**
+ * @brief Hexdump thread.
+ * @details Waits every 50 chars so as not to overflow the buffer.
+ * @param pt Thread control structure
+ */
+static PT_THREAD(hexdumpThread(PT_TypeDef* pt)) {
+
+  PT_BEGIN(pt);
+
+  while (dumpPos < dumpLength) {
+
+    printf("%02x ", dumpBuf[dumpPos]);
+
+    dumpPos++;
     // new line every 16 chars
-    if ((i % 16) == 0) {
+    if ((dumpPos % 16) == 0) {
       printf("\r\n");
     }
     // delay every 50 chars
-    if ((i % 50) == 0) {
-      TIMER_Delay(500); // Delay so as not to overflow buffer
+    if ((dumpPos % 50) == 0) {
+      PT_WAIT_TIME(pt, 500); // Delay so as not to overflow buffer
     }
   }
+
+  PT_END(pt);
 }
 
 /**
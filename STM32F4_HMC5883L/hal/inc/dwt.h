@@ -0,0 +1,42 @@
+/**
+ * @file:   dwt.h
+ * @brief:  Cycle counter of the Data Watchpoint and Trace unit.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef DWT_H_
+#define DWT_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  DWT DWT
+ * @brief     Cycle counter functions.
+ */
+
+/**
+ * @addtogroup DWT
+ * @{
+ */
+
+void      DWT_Init        (void);
+uint32_t  DWT_GetCycles   (void);
+void      DWT_DelayCycles (uint32_t cycles);
+uint32_t  DWT_CyclesToUs  (uint32_t cycles);
+
+/**
+ * @}
+ */
+
+#endif /* DWT_H_ */
@@ -20,8 +20,16 @@
 
 #include <inttypes.h>
 
+/**
+ * @brief Cost of bus operations in core clock cycles.
+ */
+typedef struct {
+  uint32_t write;       ///< RS, RW and a nibble on the data lines
+  uint32_t turnaround;  ///< Data lines to inputs and back to outputs
+} LCD_HAL_Bench_TypeDef;
 
 void    LCD_HAL_Write   (uint8_t data);
+void    LCD_HAL_WriteNibble(uint8_t rs, uint8_t nibble);
 uint8_t LCD_HAL_Read    (void);
 void    LCD_HAL_DataOut (void);
 void    LCD_HAL_DataIn  (void);
@@ -32,5 +40,6 @@ void    LCD_HAL_LowRW   (void);
 void    LCD_HAL_HighRW  (void);
 void    LCD_HAL_HighE   (void);
 void    LCD_HAL_LowE    (void);
+void    LCD_HAL_Benchmark(LCD_HAL_Bench_TypeDef* fast, LCD_HAL_Bench_TypeDef* std);
 
 #endif /* HD44780_HAL_H_ */
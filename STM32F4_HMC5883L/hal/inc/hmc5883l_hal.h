@@ -18,8 +18,13 @@
 #ifndef HMC5883L_HAL_H_
 #define HMC5883L_HAL_H_
 
+#include <inttypes.h>
+#include <pt.h>
+
 void HMC5883L_HAL_Init(void);
 uint8_t HMC5883L_HAL_Read(uint8_t address);
 void HMC5883L_HAL_Write(uint8_t address, uint8_t data);
+PT_THREAD(HMC5883L_HAL_ReadThread(PT_TypeDef* pt, uint8_t address, uint8_t* data));
+PT_THREAD(HMC5883L_HAL_WriteThread(PT_TypeDef* pt, uint8_t address, uint8_t data));
 
 #endif /* HMC5883L_HAL_H_ */
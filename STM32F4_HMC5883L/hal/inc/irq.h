@@ -0,0 +1,104 @@
+/**
+ * @file:   irq.h
+ * @brief:  Interrupt priorities and critical sections.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details All interrupt priorities are set here, drivers
+ * only pass them to NVIC_SetPriority. Lower number preempts
+ * higher, the reset priority grouping is used (4 bits of
+ * preemption priority, no subpriorities).
+ *
+ * Critical sections raise BASEPRI, so they only hold off
+ * interrupts of the given priority and less urgent ones -
+ * the ones which share data with the section. Sections nest,
+ * an inner section never lowers the mask of an outer one:
+ *
+ * @code
+ * uint32_t lock = IRQ_Lock(IRQ_PRIO_USART2);
+ * FIFO_Push(&txFifo, c); // shared with the USART2 interrupt
+ * IRQ_Unlock(lock);
+ * @endcode
+ *
+ * BASEPRI can't mask priority 0, so that level is left for
+ * interrupts which must never wait for a section.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef IRQ_H_
+#define IRQ_H_
+
+#include <inttypes.h>
+#include <stm32f4xx.h>
+
+/**
+ * @defgroup  IRQ IRQ
+ * @brief     Interrupt priorities and critical sections
+ */
+
+/**
+ * @addtogroup IRQ
+ * @{
+ */
+
+/*
+ * Priority plan. Handlers are short - the sampler only
+ * requests a compass read, which runs in the main loop.
+ * The least urgent ones go last.
+ */
+#define IRQ_PRIO_TIM5     0   ///< PC sampling profiler (samples inside other handlers)
+#define IRQ_PRIO_SYSTICK  1   ///< System time (shares only a word read atomically)
+#define IRQ_PRIO_USART2   2   ///< COMM (a byte overruns the receiver after 87us at 115200)
+#define IRQ_PRIO_I2C      3   ///< Reserved - compass I2C is polled from the main loop
+#define IRQ_PRIO_DMA      4   ///< Reserved - no DMA transfers
+#define IRQ_PRIO_EXTI     5   ///< Key press (only starts the scan timer)
+#define IRQ_PRIO_TIM7     13  ///< Keyboard scan (a late column only delays debouncing)
+#define IRQ_PRIO_TIM3     14  ///< LCD engine (a late nibble only slows the display)
+#define IRQ_PRIO_TIM2     15  ///< Compass sampler
+
+/**
+ * @brief Most urgent interrupt calling application code
+ * (e.g. PROF_Add). Sections at this level exclude all of them.
+ */
+#define IRQ_PRIO_APP      IRQ_PRIO_USART2
+
+/**
+ * @brief Enter a critical section.
+ * @details Masks interrupts with priority prio and lower
+ * (higher numbers). Does nothing if an outer section masks
+ * more already.
+ * @param prio Priority to mask (nonzero)
+ * @return State for IRQ_Unlock
+ */
+static inline uint32_t IRQ_Lock(uint32_t prio) {
+
+  uint32_t state = __get_BASEPRI();
+  uint32_t mask = prio << (8 - __NVIC_PRIO_BITS);
+
+  if (state == 0 || mask < state) {
+    __set_BASEPRI(mask);
+  }
+  return state;
+}
+/**
+ * @brief Leave a critical section.
+ * @param state Value returned by the matching IRQ_Lock
+ */
+static inline void IRQ_Unlock(uint32_t state) {
+  __set_BASEPRI(state);
+}
+
+/**
+ * @}
+ */
+
+#endif /* IRQ_H_ */
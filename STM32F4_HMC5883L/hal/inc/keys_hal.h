@@ -21,7 +21,12 @@
 #include <inttypes.h>
 
 int8_t KEYS_HAL_ReadRow(void);
+uint8_t KEYS_HAL_ReadRows(void);
 void KEYS_HAL_SelectColumn(uint8_t col);
+void KEYS_HAL_SelectAll(void);
 void KEYS_HAL_Init(void);
+void KEYS_HAL_IrqInit(void (*pressCb)(void));
+void KEYS_HAL_IrqEnable(void);
+void KEYS_HAL_IrqDisable(void);
 
 #endif /* KEYS_HAL_H_ */
@@ -19,7 +19,7 @@
 #define LED_HAL_H_
 
 #include <inttypes.h>
-
+#include <stm32f4xx.h>
 
 /**
  * @defgroup  LED_HAL LED_HAL
@@ -33,9 +33,73 @@
 
 #define MAX_LEDS    4 ///< Maximum number of LEDs available in design
 
-void LED_HAL_Init         (uint8_t led);
-void LED_HAL_Toggle       (uint8_t led);
-void LED_HAL_ChangeState  (uint8_t led, uint8_t state);
+/*
+ * All LEDs are on one port, on consecutive pins, so the pin
+ * of an LED and the BSRR value for a set of LEDs are resolved
+ * at compile time and common calls inline to a single store.
+ */
+#define LED_HAL_PORT          GPIOD                 ///< LED GPIO port
+#define LED_HAL_CLK           RCC_AHB1Periph_GPIOD  ///< LED GPIO port clock
+#define LED_HAL_FIRST_PIN     12                    ///< Pin number of LED0
+#define LED_HAL_PIN(led)      ((uint16_t)(1 << (LED_HAL_FIRST_PIN + (led))))  ///< Pin of LED
+#define LED_HAL_PIN_SOURCE(led) ((uint8_t)(LED_HAL_FIRST_PIN + (led)))        ///< Pin source of LED
+#define LED_HAL_ALL           ((1 << MAX_LEDS) - 1) ///< Mask of all LEDs
+
+/**
+ * @brief BSRR register of LED port written as one word.
+ * @details Low half sets pins, high half resets pins.
+ * Set has priority if a pin is in both halves.
+ */
+#define LED_HAL_BSRR          (*(volatile uint32_t*)&LED_HAL_PORT->BSRRL)
+
+/**
+ * @brief Set and reset a group of LEDs in one atomic write.
+ * @details Other pins of the port are not affected.
+ * @param on Mask of LEDs to turn on (bit n - LEDn)
+ * @param off Mask of LEDs to turn off
+ */
+static inline void LED_HAL_SetMask(uint8_t on, uint8_t off) {
+
+  LED_HAL_BSRR = ((uint32_t)(on & LED_HAL_ALL) << LED_HAL_FIRST_PIN) |
+      ((uint32_t)(off & LED_HAL_ALL) << (LED_HAL_FIRST_PIN + 16));
+}
+/**
+ * @brief Change the state of an LED.
+ * @param led LED number.
+ * @param state New state.
+ */
+static inline void LED_HAL_ChangeState(uint8_t led, uint8_t state) {
+
+  if (state == 1) {
+    LED_HAL_PORT->BSRRL = LED_HAL_PIN(led); // set bit
+  } else {
+    LED_HAL_PORT->BSRRH = LED_HAL_PIN(led); // reset bit
+  }
+}
+/**
+ * @brief Toggle an LED.
+ * @details Done with BSRR, so an interrupt changing other
+ * pins of the port (e.g. LCD lines) between reading ODR
+ * and the write is not undone.
+ * @param led LED number.
+ */
+static inline void LED_HAL_Toggle(uint8_t led) {
+
+  uint32_t odr = LED_HAL_PORT->ODR & LED_HAL_PIN(led);
+
+  // reset bit if it was set, set it otherwise
+  LED_HAL_BSRR = odr ? (odr << 16) : LED_HAL_PIN(led);
+}
+
+void      LED_HAL_Init         (uint8_t led);
+void      LED_HAL_InitPWM      (uint8_t led);
+uint32_t  LED_HAL_SetPeriod    (uint32_t periodUs);
+void      LED_HAL_SetCompare   (uint8_t led, uint16_t value);
+uint32_t  LED_HAL_SequenceWord (uint8_t led, uint8_t state);
+void      LED_HAL_StartSequence(uint8_t led, uint8_t pwm, const uint32_t* buf,
+                                uint16_t len, uint8_t loop, uint32_t tickUs);
+void      LED_HAL_StopSequence (void);
+uint8_t   LED_HAL_SequenceBusy (void);
 
 /**
  * @}
@@ -0,0 +1,49 @@
+/**
+ * @file:   tim2.h
+ * @brief:  Periodic interrupt from TIM2.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TIM2_H_
+#define TIM2_H_
+
+#include <inttypes.h>
+#include <irq.h>
+
+/**
+ * @defgroup  TIM2 TIM2
+ * @brief     TIM2 low level functions
+ */
+
+/**
+ * @addtogroup TIM2
+ * @{
+ */
+
+void TIM2_Init    (uint32_t freq, void (*updateCb)(void));
+void TIM2_Start   (void);
+void TIM2_Stop    (void);
+
+// HAL functions for use in higher level
+#define SAMPLER_HAL_Init        TIM2_Init
+#define SAMPLER_HAL_Start       TIM2_Start
+#define SAMPLER_HAL_Stop        TIM2_Stop
+#define SAMPLER_HAL_IrqLock()   IRQ_Lock(IRQ_PRIO_TIM2)
+#define SAMPLER_HAL_IrqUnlock   IRQ_Unlock
+
+/**
+ * @}
+ */
+
+#endif /* TIM2_H_ */
@@ -0,0 +1,49 @@
+/**
+ * @file:   tim3.h
+ * @brief:  One-shot delay interrupts from TIM3.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TIM3_H_
+#define TIM3_H_
+
+#include <inttypes.h>
+#include <irq.h>
+
+/**
+ * @defgroup  TIM3 TIM3
+ * @brief     TIM3 low level functions
+ */
+
+/**
+ * @addtogroup TIM3
+ * @{
+ */
+
+#define TIM3_MAX_DELAY 65535 ///< Maximum delay in microseconds (16-bit counter)
+
+void TIM3_Init      (void (*updateCb)(void));
+void TIM3_Schedule  (uint16_t delayUs);
+
+// HAL functions for use in higher level
+#define LCD_HAL_TimerInit       TIM3_Init
+#define LCD_HAL_TimerSchedule   TIM3_Schedule
+#define LCD_HAL_IrqLock()       IRQ_Lock(IRQ_PRIO_TIM3)
+#define LCD_HAL_IrqUnlock       IRQ_Unlock
+
+/**
+ * @}
+ */
+
+#endif /* TIM3_H_ */
@@ -0,0 +1,46 @@
+/**
+ * @file:   tim5.h
+ * @brief:  PC sampling interrupt from TIM5.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TIM5_H_
+#define TIM5_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  TIM5 TIM5
+ * @brief     TIM5 low level functions
+ */
+
+/**
+ * @addtogroup TIM5
+ * @{
+ */
+
+void TIM5_Init    (uint32_t freq, void (*sampleCb)(uint32_t pc));
+void TIM5_Start   (void);
+void TIM5_Stop    (void);
+
+// HAL functions for use in higher level
+#define PCPROF_HAL_Init   TIM5_Init
+#define PCPROF_HAL_Start  TIM5_Start
+#define PCPROF_HAL_Stop   TIM5_Stop
+
+/**
+ * @}
+ */
+
+#endif /* TIM5_H_ */
@@ -0,0 +1,49 @@
+/**
+ * @file:   tim7.h
+ * @brief:  Periodic interrupt from TIM7.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TIM7_H_
+#define TIM7_H_
+
+#include <inttypes.h>
+#include <irq.h>
+
+/**
+ * @defgroup  TIM7 TIM7
+ * @brief     TIM7 low level functions
+ */
+
+/**
+ * @addtogroup TIM7
+ * @{
+ */
+
+void TIM7_Init    (uint32_t freq, void (*updateCb)(void));
+void TIM7_Start   (void);
+void TIM7_Stop    (void);
+
+// HAL functions for use in higher level
+#define KEYS_HAL_ScanInit       TIM7_Init
+#define KEYS_HAL_ScanStart      TIM7_Start
+#define KEYS_HAL_ScanStop       TIM7_Stop
+#define KEYS_HAL_ScanLock()     IRQ_Lock(IRQ_PRIO_TIM7)
+#define KEYS_HAL_ScanUnlock     IRQ_Unlock
+
+/**
+ * @}
+ */
+
+#endif /* TIM7_H_ */
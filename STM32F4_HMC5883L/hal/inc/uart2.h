@@ -19,6 +19,7 @@
 #define UART_H_
 
 #include <inttypes.h>
+#include <irq.h>
 
 /**
  * @defgroup  USART2 USART2
@@ -36,8 +37,8 @@ void    UART2_TxEnable(void);
 // HAL functions for use in higher level
 #define COMM_HAL_Init       UART2_Init
 #define COMM_HAL_TxEnable   UART2_TxEnable
-#define COMM_HAL_IrqEnable  NVIC_EnableIRQ(USART2_IRQn);
-#define COMM_HAL_IrqDisable NVIC_DisableIRQ(USART2_IRQn);
+#define COMM_HAL_IrqLock()  IRQ_Lock(IRQ_PRIO_USART2)
+#define COMM_HAL_IrqUnlock  IRQ_Unlock
 
 /**
  * @}
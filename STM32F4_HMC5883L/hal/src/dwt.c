@@ -0,0 +1,74 @@
+/**
+ * @file:   dwt.c
+ * @brief:  Cycle counter of the Data Watchpoint and Trace unit.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The counter runs at the core clock frequency
+ * and overflows every 25s at 168MHz, so only differences
+ * of shorter intervals are meaningful.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <dwt.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup DWT
+ * @{
+ */
+
+/**
+ * @brief Enable the cycle counter.
+ * @details Does nothing if the counter is already running,
+ * so it can be called by every module using it.
+ */
+void DWT_Init(void) {
+
+  if (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+    return;
+  }
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // enable trace unit
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; // start counting
+}
+/**
+ * @brief Get current value of the cycle counter.
+ * @return Number of core clock cycles
+ */
+uint32_t DWT_GetCycles(void) {
+  return DWT->CYCCNT;
+}
+/**
+ * @brief Busy wait for a short time.
+ * @details For delays shorter than a microsecond (e.g. bus
+ * timing of external chips).
+ * @param cycles Number of core clock cycles to wait
+ */
+void DWT_DelayCycles(uint32_t cycles) {
+
+  uint32_t start = DWT->CYCCNT;
+  while ((DWT->CYCCNT - start) < cycles);
+}
+/**
+ * @brief Convert cycles to microseconds.
+ * @param cycles Number of core clock cycles
+ * @return Time in microseconds
+ */
+uint32_t DWT_CyclesToUs(uint32_t cycles) {
+  return cycles / (SystemCoreClock / 1000000);
+}
+
+/**
+ * @}
+ */
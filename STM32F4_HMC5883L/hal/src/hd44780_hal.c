@@ -16,6 +16,7 @@
  */
 
 #include <hd44780_hal.h>
+#include <dwt.h>
 
 #include <stm32f4xx.h>
 
@@ -32,12 +33,46 @@
 #define LCD_E   GPIO_Pin_6 ///< Enable pin
 
 /*
- * We use the 4-bit interface
+ * We use the 4-bit interface. Data pins have to be
+ * consecutive, so a nibble is written with one store.
  */
-#define LCD_D4  GPIO_Pin_0 ///< Data 4 pin
-#define LCD_D5  GPIO_Pin_1 ///< Data 5 pin
-#define LCD_D6  GPIO_Pin_2 ///< Data 6 pin
-#define LCD_D7  GPIO_Pin_3 ///< Data 7 pin
+#define LCD_D4_PIN  0           ///< Number of data 4 pin
+#define LCD_D4  GPIO_Pin_0      ///< Data 4 pin
+#define LCD_D5  GPIO_Pin_1      ///< Data 5 pin
+#define LCD_D6  GPIO_Pin_2      ///< Data 6 pin
+#define LCD_D7  GPIO_Pin_3      ///< Data 7 pin
+
+#define LCD_DATA_MODER_MASK (0xff << (2 * LCD_D4_PIN))  ///< MODER bits of data pins
+#define LCD_DATA_MODER_OUT  (0x55 << (2 * LCD_D4_PIN))  ///< MODER value of data pins as outputs
+
+/*
+ * Bus timing (datasheet values for 2.7V - 4.5V supply)
+ */
+#define LCD_SETUP_NS  140 ///< RS, RW setup time before E rises
+#define LCD_E_HIGH_NS 450 ///< Minimum E pulse width
+#define LCD_DATA_NS   360 ///< Data delay after E rises (reading)
+#define LCD_CYCLE_NS  1000 ///< Enable cycle time (E rise to E rise)
+
+#define LCD_BENCH_RUNS  16  ///< Runs of a benchmarked operation (fastest counts)
+
+/**
+ * @brief Set and reset bits of a port with one store.
+ * @details Low half of BSRR sets pins, high half resets pins.
+ */
+#define LCD_BSRR(port) (*(volatile uint32_t*)&(port)->BSRRL)
+
+static uint8_t dataIsInput;       ///< Current direction of data lines (cached)
+static uint32_t setupCycles;      ///< LCD_SETUP_NS in core clock cycles
+static uint32_t eHighCycles;      ///< LCD_E_HIGH_NS in core clock cycles
+static uint32_t dataCycles;       ///< LCD_DATA_NS in core clock cycles
+static uint32_t eLowCycles;       ///< Rest of the enable cycle after E falls
+
+static uint32_t LCD_HAL_Measure(void (*op)(void));
+static void LCD_HAL_BenchEmpty(void);
+static void LCD_HAL_BenchWrite(void);
+static void LCD_HAL_BenchWriteStd(void);
+static void LCD_HAL_BenchTurnaround(void);
+static void LCD_HAL_BenchTurnaroundStd(void);
 
 /**
  * @brief Low level initalization of the LCD.
@@ -48,11 +83,28 @@ void LCD_HAL_Init(void) {
   RCC_AHB1PeriphClockCmd(LCD_DATA_CLK, ENABLE);
   RCC_AHB1PeriphClockCmd(LCD_CTRL_CLK, ENABLE);
 
-  // Set LCD data pins initially as output
-  LCD_HAL_DataOut();
+  // Bus timing is done with the cycle counter
+  DWT_Init();
+  uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+  setupCycles = cyclesPerUs * LCD_SETUP_NS / 1000 + 1;
+  eHighCycles = cyclesPerUs * LCD_E_HIGH_NS / 1000 + 1;
+  dataCycles  = cyclesPerUs * LCD_DATA_NS / 1000 + 1;
+  // the next read starts with the setup time, E is low during it too
+  eLowCycles  = cyclesPerUs * (LCD_CYCLE_NS - LCD_E_HIGH_NS - LCD_SETUP_NS) / 1000 + 1;
 
-  // Set control pins as output
+  // Set LCD data pins as output - pull-ups are only
+  // needed when reading, but they don't hurt outputs,
+  // so later direction changes only write MODER
   GPIO_InitTypeDef GPIO_InitStructure;
+  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
+  GPIO_Init(LCD_DATA_PORT, &GPIO_InitStructure);
+  dataIsInput = 0;
+
+  // Set control pins as output
   GPIO_InitStructure.GPIO_Pin   = (LCD_RS|LCD_RW|LCD_E);
   GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
   GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
@@ -61,54 +113,58 @@ void LCD_HAL_Init(void) {
   GPIO_Init(LCD_CTRL_PORT,&GPIO_InitStructure);
 
   // Clear all control signals initially
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RW|LCD_RS|LCD_E);
+  LCD_BSRR(LCD_CTRL_PORT) = (LCD_RW|LCD_RS|LCD_E) << 16;
 
 }
 
 void LCD_HAL_LowRS(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RS);
+  LCD_CTRL_PORT->BSRRH = LCD_RS;
 }
 void LCD_HAL_HighRS(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_RS);
+  LCD_CTRL_PORT->BSRRL = LCD_RS;
 }
 void LCD_HAL_LowRW(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RW);
+  LCD_CTRL_PORT->BSRRH = LCD_RW;
 }
 void LCD_HAL_HighRW(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_RW);
+  LCD_CTRL_PORT->BSRRL = LCD_RW;
 }
 void LCD_HAL_HighE(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_E);
+  LCD_CTRL_PORT->BSRRL = LCD_E;
 }
 void LCD_HAL_LowE(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_E);
+  LCD_CTRL_PORT->BSRRH = LCD_E;
 }
 
 /**
  * @brief Set data lines as output.
+ * @details Only MODER is written, nothing is done if
+ * lines already are outputs.
  */
 void LCD_HAL_DataOut(void) {
-  GPIO_InitTypeDef GPIO_InitStructure;
 
-  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
-  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
-  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
-  GPIO_Init(LCD_DATA_PORT, &GPIO_InitStructure);
+  if (!dataIsInput) {
+    return;
+  }
+
+  LCD_DATA_PORT->MODER = (LCD_DATA_PORT->MODER & ~LCD_DATA_MODER_MASK) |
+      LCD_DATA_MODER_OUT;
+  dataIsInput = 0;
 }
 
 /**
  * @brief Set data lines as input with pull up
+ * @details Only MODER is written, nothing is done if
+ * lines already are inputs.
  */
 void LCD_HAL_DataIn(void) {
-  GPIO_InitTypeDef GPIO_InitStructure;
 
-  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
-  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_IN;
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
-  GPIO_Init(LCD_DATA_PORT,&GPIO_InitStructure);
+  if (dataIsInput) {
+    return;
+  }
+
+  LCD_DATA_PORT->MODER &= ~LCD_DATA_MODER_MASK;
+  dataIsInput = 1;
 }
 
 /**
@@ -117,7 +173,129 @@ void LCD_HAL_DataIn(void) {
  */
 void LCD_HAL_Write(uint8_t data) {
 
-  // set the various bits
+  uint32_t nibble = data & 0x0f;
+
+  // set ones and reset zeros with one store
+  LCD_BSRR(LCD_DATA_PORT) = (nibble << LCD_D4_PIN) |
+      ((~nibble & 0x0f) << (LCD_D4_PIN + 16));
+}
+
+/**
+ * @brief Write a nibble to the display (whole bus cycle).
+ * @details Sets RS, RW low, data lines as outputs, puts
+ * the nibble on the bus and strobes E.
+ * @param rs 1 - data, 0 - command
+ * @param nibble Nibble to write (lower 4 bits)
+ */
+void LCD_HAL_WriteNibble(uint8_t rs, uint8_t nibble) {
+
+  LCD_HAL_DataOut();
+
+  LCD_BSRR(LCD_CTRL_PORT) = rs ? (LCD_RS | (LCD_RW << 16)) : ((LCD_RS | LCD_RW) << 16);
+  LCD_HAL_Write(nibble);
+  DWT_DelayCycles(setupCycles);
+
+  LCD_CTRL_PORT->BSRRL = LCD_E;
+  DWT_DelayCycles(eHighCycles);
+  LCD_CTRL_PORT->BSRRH = LCD_E; // data latched on falling edge
+}
+
+/**
+ * @brief Reads the data lines
+ * @details Strobes E and waits out the enable cycle, so the
+ * two nibbles of a byte can be read back to back. Writes
+ * don't need it - their nibbles are sent from separate
+ * timer interrupts, microseconds apart.
+ * @return Read data.
+ */
+uint8_t LCD_HAL_Read(void) {
+
+  DWT_DelayCycles(setupCycles);
+  LCD_CTRL_PORT->BSRRL = LCD_E;
+  DWT_DelayCycles(dataCycles);
+
+  uint8_t result = (LCD_DATA_PORT->IDR >> LCD_D4_PIN) & 0x0f;
+
+  DWT_DelayCycles(eHighCycles - dataCycles);
+  LCD_CTRL_PORT->BSRRH = LCD_E;
+  DWT_DelayCycles(eLowCycles);
+  return result;
+}
+/**
+ * @brief Compare the bus operations with the StdPeriph path.
+ * @details The StdPeriph path is the previous HAL - a
+ * GPIO_SetBits/GPIO_ResetBits call per line and GPIO_Init
+ * for every direction change. E is not strobed, so the display
+ * ignores the lines. Bus timing delays are the same in both
+ * paths and are not counted. The caller has to keep the LCD
+ * engine from running meanwhile.
+ * @param fast Returns cycles of this HAL
+ * @param std Returns cycles of the StdPeriph path
+ */
+void LCD_HAL_Benchmark(LCD_HAL_Bench_TypeDef* fast, LCD_HAL_Bench_TypeDef* std) {
+
+  fast->write = LCD_HAL_Measure(LCD_HAL_BenchWrite);
+  std->write = LCD_HAL_Measure(LCD_HAL_BenchWriteStd);
+  fast->turnaround = LCD_HAL_Measure(LCD_HAL_BenchTurnaround);
+  std->turnaround = LCD_HAL_Measure(LCD_HAL_BenchTurnaroundStd);
+
+  // engine sets the lines before every nibble
+  LCD_BSRR(LCD_CTRL_PORT) = (LCD_RW|LCD_RS) << 16;
+}
+/**
+ * @brief Measure an operation.
+ * @param op Operation
+ * @return Cycles of the fastest run without the measurement overhead
+ */
+static uint32_t LCD_HAL_Measure(void (*op)(void)) {
+
+  uint32_t min = UINT32_MAX;
+  uint32_t overhead = UINT32_MAX;
+  uint8_t i;
+
+  for (i = 0; i < LCD_BENCH_RUNS; i++) {
+
+    uint32_t start = DWT_GetCycles();
+    LCD_HAL_BenchEmpty();
+    uint32_t cycles = DWT_GetCycles() - start;
+    if (cycles < overhead) {
+      overhead = cycles;
+    }
+
+    start = DWT_GetCycles();
+    op();
+    cycles = DWT_GetCycles() - start;
+    if (cycles < min) {
+      min = cycles;
+    }
+  }
+
+  return (min > overhead) ? min - overhead : 0;
+}
+/**
+ * @brief Empty operation - measurement overhead.
+ */
+static void LCD_HAL_BenchEmpty(void) {
+  __NOP();
+}
+/**
+ * @brief Control lines and a nibble (LCD_HAL_WriteNibble without E).
+ */
+static void LCD_HAL_BenchWrite(void) {
+
+  LCD_BSRR(LCD_CTRL_PORT) = LCD_RS | (LCD_RW << 16);
+  LCD_HAL_Write(0x05);
+}
+/**
+ * @brief Control lines and a nibble with StdPeriph calls.
+ */
+static void LCD_HAL_BenchWriteStd(void) {
+
+  uint8_t data = 0x05;
+
+  GPIO_SetBits(LCD_CTRL_PORT, LCD_RS);
+  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RW);
+
   if (data & (1<<3))
     GPIO_SetBits(LCD_DATA_PORT, LCD_D7);
   else
@@ -138,25 +316,28 @@ void LCD_HAL_Write(uint8_t data) {
   else
     GPIO_ResetBits(LCD_DATA_PORT, LCD_D4);
 }
+/**
+ * @brief Data lines to inputs and back (busy flag read).
+ */
+static void LCD_HAL_BenchTurnaround(void) {
 
+  LCD_HAL_DataIn();
+  LCD_HAL_DataOut();
+}
 /**
- * @brief Reads the data lines
- * @return Read data.
+ * @brief Data lines to inputs and back with GPIO_Init.
  */
-uint8_t LCD_HAL_Read(void) {
-  uint8_t result = 0;
+static void LCD_HAL_BenchTurnaroundStd(void) {
 
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_E);
+  GPIO_InitTypeDef GPIO_InitStructure;
 
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D7))
-    result |= (1<<3);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D6))
-    result |= (1<<2);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D5))
-    result |= (1<<1);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D4))
-    result |= (1<<0);
+  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_IN;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
+  GPIO_Init(LCD_DATA_PORT, &GPIO_InitStructure);
 
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_E);
-  return result;
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+  GPIO_Init(LCD_DATA_PORT, &GPIO_InitStructure);
 }
@@ -15,7 +15,9 @@
  * @endverbatim
  */
 
+#include <hmc5883l_hal.h>
 #include <stm32f4xx.h>
+#include <trace.h>
 
 #define HMC5883L_SCL_PIN    GPIO_Pin_6
 #define HMC5883L_SDA_PIN    GPIO_Pin_7
@@ -65,37 +67,71 @@ void HMC5883L_HAL_Init(void) {
  * @brief Read data from the compass on the I2C bus
  * @param address Address of read
  * @return Read data
+ * @warning This is a blocking function.
  */
 uint8_t HMC5883L_HAL_Read(uint8_t address) {
 
+  PT_TypeDef pt;
   uint8_t ret;
 
+  PT_INIT(&pt);
+  while (PT_SCHEDULE(HMC5883L_HAL_ReadThread(&pt, address, &ret)));
+
+  return ret;
+}
+/**
+ * @brief Write data to the compass on the I2C bus
+ * @param address Address of write
+ * @param data Data to write
+ * @warning This is a blocking function.
+ */
+void HMC5883L_HAL_Write(uint8_t address, uint8_t data) {
+
+  PT_TypeDef pt;
+
+  PT_INIT(&pt);
+  while (PT_SCHEDULE(HMC5883L_HAL_WriteThread(&pt, address, data)));
+}
+/**
+ * @brief Read data from the compass on the I2C bus (nonblocking)
+ * @details The thread has to be run until it ends. Every wait for
+ * an I2C event returns control to the caller.
+ * @param pt Thread control structure
+ * @param address Address of read
+ * @param data Read data (valid when the thread ends)
+ */
+PT_THREAD(HMC5883L_HAL_ReadThread(PT_TypeDef* pt, uint8_t address, uint8_t* data)) {
+
+  PT_BEGIN(pt);
+
+  TRACE_BEGIN(TRACE_I2C, address);
+
   // Wait while I2C busy
-  while(I2C_GetFlagStatus(HMC5883L_I2C, I2C_FLAG_BUSY));
+  PT_WAIT_WHILE(pt, I2C_GetFlagStatus(HMC5883L_I2C, I2C_FLAG_BUSY));
 
   // Send start
   I2C_GenerateSTART(HMC5883L_I2C, ENABLE);
 
   // Wait for EV5
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
 
   // Send HMC5883L address for write
   I2C_Send7bitAddress(HMC5883L_I2C, HMC5883L_ADDR, I2C_Direction_Transmitter);
 
   // Wait for EV6
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
 
   // Send register address
   I2C_SendData(HMC5883L_I2C, address);
 
   // Wait for EV8
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
 
   // Repeated start
   I2C_GenerateSTART(HMC5883L_I2C, ENABLE);
 
   // Wait for EV5
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
 
   // Send HMC5883L address for read
   I2C_Send7bitAddress(HMC5883L_I2C, HMC5883L_ADDR, I2C_Direction_Receiver);
@@ -103,56 +139,68 @@ uint8_t HMC5883L_HAL_Read(uint8_t address) {
   // Disable ACK
   I2C_AcknowledgeConfig(HMC5883L_I2C, DISABLE);
 
-  // Wait for EV6
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
+  // Wait for EV6 (STOP is generated in the same run as
+  // the event is detected, so timing is not affected)
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
 
   // Generate stop
   I2C_GenerateSTOP(HMC5883L_I2C, ENABLE);
 
   // Wait for EV7
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_RECEIVED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_RECEIVED));
 
-  ret = I2C_ReceiveData(HMC5883L_I2C);
+  *data = I2C_ReceiveData(HMC5883L_I2C);
 
   // Enable ACK
   I2C_AcknowledgeConfig(HMC5883L_I2C, ENABLE);
 
-  return ret;
+  TRACE_END(TRACE_I2C, address);
+
+  PT_END(pt);
 }
 /**
- * @brief Write data to the compass on the I2C bus
+ * @brief Write data to the compass on the I2C bus (nonblocking)
+ * @param pt Thread control structure
  * @param address Address of write
  * @param data Data to write
  */
-void HMC5883L_HAL_Write(uint8_t address, uint8_t data) {
+PT_THREAD(HMC5883L_HAL_WriteThread(PT_TypeDef* pt, uint8_t address, uint8_t data)) {
+
+  PT_BEGIN(pt);
+
+  TRACE_BEGIN(TRACE_I2C, address);
 
   // Wait while I2C busy
-  while(I2C_GetFlagStatus(HMC5883L_I2C, I2C_FLAG_BUSY));
+  PT_WAIT_WHILE(pt, I2C_GetFlagStatus(HMC5883L_I2C, I2C_FLAG_BUSY));
 
   // Send start
   I2C_GenerateSTART(HMC5883L_I2C, ENABLE);
 
   // Wait for EV5
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_MODE_SELECT));
 
   // Send HMC5883L address for write
   I2C_Send7bitAddress(HMC5883L_I2C, HMC5883L_ADDR, I2C_Direction_Transmitter);
 
   // Wait for EV6
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
 
   // Send register address
   I2C_SendData(HMC5883L_I2C, address);
 
   // Wait for EV8
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
 
   // Send new data
   I2C_SendData(HMC5883L_I2C, data);
 
   // Wait for EV8
-  while(!I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+  PT_WAIT_UNTIL(pt, I2C_CheckEvent(HMC5883L_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
 
   // Generate stop
   I2C_GenerateSTOP(HMC5883L_I2C, ENABLE);
+
+  TRACE_END(TRACE_I2C, address);
+
+  PT_END(pt);
 }
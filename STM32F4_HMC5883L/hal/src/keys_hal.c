@@ -17,6 +17,9 @@
 
 #include <keys_hal.h>
 #include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <irq.h>
 
 
 /*
@@ -38,6 +41,13 @@
 #define KEYS_COL_PORT   GPIOE
 #define KEYS_COL_CLOCK  RCC_AHB1Periph_GPIOE
 
+#define KEYS_ROW_EXTI_PORT  EXTI_PortSourceGPIOE  ///< EXTI source port of rows
+#define KEYS_ROW_EXTI_LINES (EXTI_Line11 | EXTI_Line12 | \
+    EXTI_Line13 | EXTI_Line14)                    ///< EXTI lines of rows
+#define KEYS_ROW_IRQ        EXTI15_10_IRQn        ///< EXTI interrupt of rows
+
+static void (*pressCallback)(void); ///< Callback function for key press interrupt
+
 /**
  * @brief Initialize 4x4 matrix keyboard
  */
@@ -99,6 +109,82 @@ void KEYS_HAL_SelectColumn(uint8_t col) {
   }
 
 }
+/**
+ * @brief Select all columns
+ * @details With all columns low, pressing any key pulls its
+ * row low, which can trigger an interrupt.
+ */
+void KEYS_HAL_SelectAll(void) {
+
+  GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL0_PIN | KEYS_COL1_PIN |
+      KEYS_COL2_PIN | KEYS_COL3_PIN);
+}
+/**
+ * @brief Initialize key press interrupts on row lines.
+ * @details Interrupts are disabled after initialization.
+ * @param pressCb Function called (in interrupt context) when
+ * any row goes low
+ */
+void KEYS_HAL_IrqInit(void (*pressCb)(void)) {
+
+  pressCallback = pressCb;
+
+  RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+
+  // Connect row pins to EXTI lines
+  SYSCFG_EXTILineConfig(KEYS_ROW_EXTI_PORT, EXTI_PinSource11);
+  SYSCFG_EXTILineConfig(KEYS_ROW_EXTI_PORT, EXTI_PinSource12);
+  SYSCFG_EXTILineConfig(KEYS_ROW_EXTI_PORT, EXTI_PinSource13);
+  SYSCFG_EXTILineConfig(KEYS_ROW_EXTI_PORT, EXTI_PinSource14);
+
+  // Falling edge - keypress pulls the row low
+  EXTI_InitTypeDef EXTI_InitStructure;
+  EXTI_InitStructure.EXTI_Line    = KEYS_ROW_EXTI_LINES;
+  EXTI_InitStructure.EXTI_Mode    = EXTI_Mode_Interrupt;
+  EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+  EXTI_InitStructure.EXTI_LineCmd = DISABLE;
+  EXTI_Init(&EXTI_InitStructure);
+
+  NVIC_SetPriority(KEYS_ROW_IRQ, IRQ_PRIO_EXTI);
+  NVIC_EnableIRQ(KEYS_ROW_IRQ);
+}
+/**
+ * @brief Enable key press interrupts.
+ */
+void KEYS_HAL_IrqEnable(void) {
+
+  EXTI_ClearITPendingBit(KEYS_ROW_EXTI_LINES); // ignore old edges
+  EXTI->IMR |= KEYS_ROW_EXTI_LINES;
+}
+/**
+ * @brief Disable key press interrupts.
+ */
+void KEYS_HAL_IrqDisable(void) {
+  EXTI->IMR &= ~KEYS_ROW_EXTI_LINES;
+}
+/**
+ * @brief IRQ handler for EXTI lines 10 to 15 (keyboard rows).
+ * @details Interrupts are disabled after the first edge, the
+ * higher layer enables them again after it finishes scanning.
+ */
+void EXTI15_10_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_EXTI);
+  TRACE_BEGIN(TRACE_EXTI, 0);
+
+  if (EXTI->PR & KEYS_ROW_EXTI_LINES) {
+
+    KEYS_HAL_IrqDisable();
+    EXTI_ClearITPendingBit(KEYS_ROW_EXTI_LINES);
+
+    if (pressCallback) { // if not NULL
+      pressCallback();
+    }
+  }
+
+  TRACE_END(TRACE_EXTI, 0);
+  IRQSTAT_EXIT(IRQSTAT_EXTI);
+}
 /**
  * @brief Read keyboard row.
  * @return Row value
@@ -119,3 +205,23 @@ int8_t KEYS_HAL_ReadRow(void) {
 
   return -1;
 }
+/**
+ * @brief Read all keyboard rows.
+ * @return Bitmap of active rows (bit 0 - row 0)
+ */
+uint8_t KEYS_HAL_ReadRows(void) {
+
+  uint16_t row = ~GPIO_ReadInputData(KEYS_ROW_PORT); // low level for keypress
+  uint8_t result = 0;
+
+  if (row & KEYS_ROW0_PIN)
+    result |= (1<<0);
+  if (row & KEYS_ROW1_PIN)
+    result |= (1<<1);
+  if (row & KEYS_ROW2_PIN)
+    result |= (1<<2);
+  if (row & KEYS_ROW3_PIN)
+    result |= (1<<3);
+
+  return result;
+}
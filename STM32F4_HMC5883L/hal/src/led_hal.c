@@ -23,76 +23,296 @@
  * @{
  */
 
-/**
- * @brief LED GPIO ports
+/*
+ * Sequencer: TIM8 update events trigger DMA2 Stream1 Channel 7
+ * transfers from memory to a TIM4 compare register or GPIO BSRR.
+ * DMA2 has to be used - the peripheral port of DMA1 reaches
+ * only APB1, so it can't write GPIO registers.
  */
-static GPIO_TypeDef* ledPort[MAX_LEDS] = {
-    GPIOD,
-    GPIOD,
-    GPIOD,
-    GPIOD};
+#define LED_SEQ_TIM         TIM8                  ///< Sequencer step timer
+#define LED_SEQ_TIM_CLK     RCC_APB2Periph_TIM8   ///< Sequencer step timer clock
+#define LED_SEQ_TIM_FREQ    10000                 ///< Sequencer step timer counter frequency
+#define LED_SEQ_DMA_STREAM  DMA2_Stream1          ///< DMA stream with TIM8_UP request
+#define LED_SEQ_DMA_CHANNEL DMA_Channel_7         ///< DMA channel of TIM8_UP
+#define LED_SEQ_DMA_CLK     RCC_AHB1Periph_DMA2   ///< DMA clock
+
+static uint32_t LED_HAL_TimerClock(uint8_t apb2);
+
 /**
- * @brief LED pin numbers
+ * @brief LED PWM compare registers (TIM4 CH1-CH4)
  */
-static uint32_t ledPin[MAX_LEDS] = {
-    GPIO_Pin_12,
-    GPIO_Pin_13,
-    GPIO_Pin_14,
-    GPIO_Pin_15};
-/**
- * @brief LED clocks
- */
-static uint32_t ledClk[MAX_LEDS] = {
-    RCC_AHB1Periph_GPIOD,
-    RCC_AHB1Periph_GPIOD,
-    RCC_AHB1Periph_GPIOD,
-    RCC_AHB1Periph_GPIOD};
-
+static volatile uint32_t* const ledCompare[MAX_LEDS] = {
+    &TIM4->CCR1,
+    &TIM4->CCR2,
+    &TIM4->CCR3,
+    &TIM4->CCR4};
 /**
  * @brief Add an LED.
  * @param led LED number.
  */
 void LED_HAL_Init(uint8_t led) {
 
-  RCC_AHB1PeriphClockCmd(ledClk[led], ENABLE);
+  RCC_AHB1PeriphClockCmd(LED_HAL_CLK, ENABLE);
 
   GPIO_InitTypeDef GPIO_InitStructure;
 
   // Configure pin in output push/pull mode
-  GPIO_InitStructure.GPIO_Pin   = ledPin[led];
+  GPIO_InitStructure.GPIO_Pin   = LED_HAL_PIN(led);
   GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;    // output pin
   GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;    // push-pull output
   GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;  // less interference
   GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL; // no pull-up
 
-  GPIO_Init(ledPort[led], &GPIO_InitStructure);
+  GPIO_Init(LED_HAL_PORT, &GPIO_InitStructure);
 
-  GPIO_WriteBit(ledPort[led], ledPin[led], Bit_RESET); // turn LED off
+  GPIO_WriteBit(LED_HAL_PORT, LED_HAL_PIN(led), Bit_RESET); // turn LED off
 
 }
 
 /**
- * @brief Toggle an LED.
+ * @brief Add an LED driven by TIM4 PWM.
+ * @details The LED is off after initialization. All PWM LEDs
+ * share the TIM4 period (see LED_HAL_SetPeriod).
+ * @param led LED number.
+ */
+void LED_HAL_InitPWM(uint8_t led) {
+
+  static uint8_t timerInitialized;
+
+  RCC_AHB1PeriphClockCmd(LED_HAL_CLK, ENABLE);
+
+  GPIO_InitTypeDef GPIO_InitStructure;
+
+  // Configure pin as TIM4 output
+  GPIO_InitStructure.GPIO_Pin   = LED_HAL_PIN(led);
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;     // timer output
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;    // push-pull output
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;  // less interference
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL; // no pull-up
+
+  GPIO_Init(LED_HAL_PORT, &GPIO_InitStructure);
+  GPIO_PinAFConfig(LED_HAL_PORT, LED_HAL_PIN_SOURCE(led), GPIO_AF_TIM4);
+
+  if (!timerInitialized) {
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM4, ENABLE);
+    LED_HAL_SetPeriod(1000); // 1kHz for dimming by default
+    TIM_Cmd(TIM4, ENABLE);
+    timerInitialized = 1;
+  }
+
+  TIM_OCInitTypeDef TIM_OCInitStructure;
+  TIM_OCStructInit(&TIM_OCInitStructure);
+  TIM_OCInitStructure.TIM_OCMode      = TIM_OCMode_PWM1;  // high while counter < compare
+  TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
+  TIM_OCInitStructure.TIM_Pulse       = 0;                // LED off
+  TIM_OCInitStructure.TIM_OCPolarity  = TIM_OCPolarity_High;
+
+  // Compare preload is disabled, so that new values
+  // work immediately, not after the (possibly long) period
+  switch (led) {
+  case 0:
+    TIM_OC1Init(TIM4, &TIM_OCInitStructure);
+    TIM_OC1PreloadConfig(TIM4, TIM_OCPreload_Disable);
+    break;
+  case 1:
+    TIM_OC2Init(TIM4, &TIM_OCInitStructure);
+    TIM_OC2PreloadConfig(TIM4, TIM_OCPreload_Disable);
+    break;
+  case 2:
+    TIM_OC3Init(TIM4, &TIM_OCInitStructure);
+    TIM_OC3PreloadConfig(TIM4, TIM_OCPreload_Disable);
+    break;
+  case 3:
+    TIM_OC4Init(TIM4, &TIM_OCInitStructure);
+    TIM_OC4PreloadConfig(TIM4, TIM_OCPreload_Disable);
+    break;
+  default:
+    break;
+  }
+}
+/**
+ * @brief Set period of the LED PWM.
+ * @details Short periods (about 1ms) are used for dimming,
+ * long ones (hundreds of ms) for blinking done by hardware.
+ * @param periodUs Period in microseconds (max about 50s)
+ * @return Number of timer ticks in period (compare value for 100% duty)
+ */
+uint32_t LED_HAL_SetPeriod(uint32_t periodUs) {
+
+  uint32_t timerClock = LED_HAL_TimerClock(0);
+
+  // smallest prescaler which fits the period in the 16-bit counter
+  // (leaving room for a compare value above the auto-reload value)
+  uint32_t ticks = periodUs * (timerClock / 1000000);
+  uint32_t prescaler = (ticks + 0xfffe) / 0xffff;
+
+  if (prescaler == 0) {
+    prescaler = 1;
+    ticks = 1;
+  }
+
+  ticks /= prescaler;
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = prescaler - 1;
+  TIM_TimeBaseStructure.TIM_Period            = ticks - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM4, &TIM_TimeBaseStructure);
+
+  return ticks;
+}
+/**
+ * @brief Set PWM compare value of an LED.
+ * @details 0 turns the LED off, value equal to the number of
+ * ticks in period turns it on permanently.
  * @param led LED number.
+ * @param value Compare value.
  */
-void LED_HAL_Toggle(uint8_t led) {
+void LED_HAL_SetCompare(uint8_t led, uint16_t value) {
 
-  ledPort[led]->ODR ^= ledPin[led]; // toggle bit
+  *ledCompare[led] = value;
 }
 
 /**
- * @brief Change the state of an LED.
+ * @brief Value written by the sequencer to turn an LED on or off.
+ * @details Used only for LEDs in GPIO mode - the value is written
+ * to BSRR, so other pins of the port are not affected.
  * @param led LED number.
- * @param state New state.
+ * @param state 1 - LED on, 0 - LED off
+ * @return BSRR value
  */
-void LED_HAL_ChangeState(uint8_t led, uint8_t state) {
+uint32_t LED_HAL_SequenceWord(uint8_t led, uint8_t state) {
+
+  if (state) {
+    return LED_HAL_PIN(led);       // set bit
+  } else {
+    return (uint32_t)LED_HAL_PIN(led) << 16; // reset bit
+  }
+}
+/**
+ * @brief Start playing a sequence of output values.
+ * @details Every tick the DMA writes the next value from buffer
+ * to the compare register (PWM LED) or BSRR (GPIO LED). No CPU
+ * is used until the sequence is stopped.
+ * @param led LED number.
+ * @param pwm Nonzero for PWM LEDs (buffer holds compare values),
+ * zero for GPIO LEDs (buffer holds BSRR values)
+ * @param buf Sequence buffer (has to stay valid while playing)
+ * @param len Number of values in buffer
+ * @param loop Nonzero - repeat sequence, zero - play once
+ * @param tickUs Duration of one value in microseconds (multiple of 100,
+ * up to 1677 s). Ticks longer than the 16 bit counter (6.5 s) are split
+ * into equal periods with the repetition counter and may come out up
+ * to 100 us per period shorter.
+ */
+void LED_HAL_StartSequence(uint8_t led, uint8_t pwm, const uint32_t* buf,
+    uint16_t len, uint8_t loop, uint32_t tickUs) {
+
+  static uint8_t initialized;
+
+  if (!initialized) {
+    RCC_AHB1PeriphClockCmd(LED_SEQ_DMA_CLK, ENABLE);
+    RCC_APB2PeriphClockCmd(LED_SEQ_TIM_CLK, ENABLE);
+    initialized = 1;
+  }
+
+  LED_HAL_StopSequence();
+
+  // Update event (DMA request) every repeat counter periods
+  uint32_t ticks = tickUs / (1000000 / LED_SEQ_TIM_FREQ);
+  if (ticks == 0) {
+    ticks = 1;
+  }
+  uint32_t repeat = (ticks + 0xffff) / 0x10000;
+  if (repeat > 0x100) {
+    repeat = 0x100;
+    ticks = 0x100 * 0x10000;
+  }
+
+  // Step timer
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = LED_HAL_TimerClock(1) / LED_SEQ_TIM_FREQ - 1;
+  TIM_TimeBaseStructure.TIM_Period            = ticks / repeat - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = repeat - 1;
+  TIM_TimeBaseInit(LED_SEQ_TIM, &TIM_TimeBaseStructure);
+  TIM_DMACmd(LED_SEQ_TIM, TIM_DMA_Update, ENABLE);
+
+  // DMA from buffer to LED output
+  DMA_InitTypeDef DMA_InitStructure;
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel             = LED_SEQ_DMA_CHANNEL;
+  DMA_InitStructure.DMA_PeripheralBaseAddr  = pwm ?
+      (uint32_t)ledCompare[led] : (uint32_t)&LED_HAL_PORT->BSRRL;
+  DMA_InitStructure.DMA_Memory0BaseAddr     = (uint32_t)buf;
+  DMA_InitStructure.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_BufferSize          = len;
+  DMA_InitStructure.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+  DMA_InitStructure.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+  DMA_InitStructure.DMA_Mode                = loop ? DMA_Mode_Circular : DMA_Mode_Normal;
+  DMA_InitStructure.DMA_Priority            = DMA_Priority_Low;
+  DMA_InitStructure.DMA_FIFOMode            = DMA_FIFOMode_Disable;
+  DMA_Init(LED_SEQ_DMA_STREAM, &DMA_InitStructure);
+
+  DMA_Cmd(LED_SEQ_DMA_STREAM, ENABLE);
+
+  TIM_SetCounter(LED_SEQ_TIM, 0);
+  TIM_Cmd(LED_SEQ_TIM, ENABLE);
+}
+/**
+ * @brief Stop playing the sequence.
+ * @details The LED keeps the last written value.
+ */
+void LED_HAL_StopSequence(void) {
+
+  TIM_Cmd(LED_SEQ_TIM, DISABLE);
+  DMA_Cmd(LED_SEQ_DMA_STREAM, DISABLE);
+
+  while (DMA_GetCmdStatus(LED_SEQ_DMA_STREAM) == ENABLE); // wait until stream stops
+
+  TIM_DMACmd(LED_SEQ_TIM, TIM_DMA_Update, DISABLE);
+  DMA_ClearFlag(LED_SEQ_DMA_STREAM, DMA_FLAG_TCIF1 | DMA_FLAG_HTIF1 |
+      DMA_FLAG_TEIF1 | DMA_FLAG_DMEIF1 | DMA_FLAG_FEIF1);
+}
+/**
+ * @brief Checks whether a sequence is playing.
+ * @retval 1 Sequence playing (one-shot sequences stop by themselves)
+ * @retval 0 No sequence
+ */
+uint8_t LED_HAL_SequenceBusy(void) {
+
+  return (DMA_GetCmdStatus(LED_SEQ_DMA_STREAM) == ENABLE) ? 1 : 0;
+}
+/**
+ * @brief Clock frequency of timers.
+ * @param apb2 Nonzero for APB2 timers, zero for APB1 timers
+ * @return Frequency in Hz
+ */
+static uint32_t LED_HAL_TimerClock(uint8_t apb2) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+  RCC_GetClocksFreq(&RCC_Clocks);
 
-  if (state == 1) {
-    ledPort[led]->BSRRL = ledPin[led]; // set bit
+  // timers run at twice the bus clock if APB prescaler is not 1
+  uint32_t timerClock;
+  if (apb2) {
+    timerClock = RCC_Clocks.PCLK2_Frequency;
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) {
+      timerClock *= 2;
+    }
   } else {
-    ledPort[led]->BSRRH = ledPin[led]; // reset bit
+    timerClock = RCC_Clocks.PCLK1_Frequency;
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+      timerClock *= 2;
+    }
   }
 
+  return timerClock;
 }
 
 /**
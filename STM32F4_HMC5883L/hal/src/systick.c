@@ -17,6 +17,9 @@
 
 #include <systick.h>
 #include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <irq.h>
 
 /**
  * @defgroup  SYSTICK SYSTICK
@@ -42,6 +45,11 @@ void SYSTICK_Init(uint32_t freq) {
 
   SysTick_Config(RCC_Clocks.HCLK_Frequency / freq); // Set SysTick frequency
 
+  // SysTick_Config sets the lowest priority - raise it, so that
+  // long interrupt handlers (e.g. sampling) don't stop system time
+  // and critical sections (except the strictest) don't delay it
+  NVIC_SetPriority(SysTick_IRQn, IRQ_PRIO_SYSTICK);
+
 }
 /**
  * @brief Get the system time
@@ -56,8 +64,15 @@ uint32_t SYSTICK_GetTime(void) {
  */
 void SysTick_Handler(void) {
 
+  IRQSTAT_ENTER(IRQSTAT_SYSTICK);
+  // counter reloaded at the event and counting down since
+  IRQSTAT_LATENCY(IRQSTAT_SYSTICK, SysTick->LOAD - SysTick->VAL);
+  TRACE_BEGIN(TRACE_SYSTICK, 0);
+
   sysTicks++; // Update system time
 
+  TRACE_END(TRACE_SYSTICK, 0);
+  IRQSTAT_EXIT(IRQSTAT_SYSTICK);
 }
 
 /**
@@ -0,0 +1,113 @@
+/**
+ * @file:   tim2.c
+ * @brief:  Periodic interrupt from TIM2.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details TIM2 counts at 1MHz and generates an update
+ * interrupt with the requested frequency, independently
+ * of the main loop.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim2.h>
+#include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
+
+/**
+ * @addtogroup TIM2
+ * @{
+ */
+
+#define TIM2_COUNTER_FREQ 1000000 ///< Frequency of the TIM2 counter
+
+static void (*updateCallback)(void); ///< Callback function for update event
+
+/**
+ * @brief Initialize TIM2 update interrupt.
+ * @details The timer is stopped after initialization.
+ * @param freq Frequency of update interrupt in Hz
+ * @param updateCb Function called on every update event
+ */
+void TIM2_Init(uint32_t freq, void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+
+  RCC_ClocksTypeDef RCC_Clocks;
+  RCC_GetClocksFreq(&RCC_Clocks);
+
+  // APB1 timers run at twice the bus clock if APB1 prescaler is not 1
+  uint32_t timerClock = RCC_Clocks.PCLK1_Frequency;
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    timerClock *= 2;
+  }
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = timerClock / TIM2_COUNTER_FREQ - 1;
+  TIM_TimeBaseStructure.TIM_Period            = TIM2_COUNTER_FREQ / freq - 1; // 32-bit counter
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM2, &TIM_TimeBaseStructure);
+
+  TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+  TIM_ITConfig(TIM2, TIM_IT_Update, ENABLE);
+
+  // Lowest priority - the callback only requests a
+  // compass read, nothing waits for it
+  NVIC_SetPriority(TIM2_IRQn, IRQ_PRIO_TIM2);
+  NVIC_EnableIRQ(TIM2_IRQn);
+}
+/**
+ * @brief Start generating update interrupts.
+ */
+void TIM2_Start(void) {
+
+  TIM_SetCounter(TIM2, 0);
+  TIM_Cmd(TIM2, ENABLE);
+}
+/**
+ * @brief Stop generating update interrupts.
+ */
+void TIM2_Stop(void) {
+  TIM_Cmd(TIM2, DISABLE);
+}
+/**
+ * @brief IRQ handler for TIM2
+ */
+void TIM2_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM2);
+  TRACE_BEGIN(TRACE_TIM2, 0);
+
+  if (TIM_GetITStatus(TIM2, TIM_IT_Update) != RESET) {
+
+    // counter restarted at the update event
+    IRQSTAT_LATENCY(IRQSTAT_TIM2, TIM2->CNT * (SystemCoreClock / TIM2_COUNTER_FREQ));
+
+    TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
+
+    if (updateCallback) { // if not NULL
+      updateCallback();
+    }
+  }
+
+  TRACE_END(TRACE_TIM2, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM2);
+}
+
+/**
+ * @}
+ */
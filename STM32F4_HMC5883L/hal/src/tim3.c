@@ -0,0 +1,115 @@
+/**
+ * @file:   tim3.c
+ * @brief:  One-shot delay interrupts from TIM3.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details TIM3 counts at 1MHz in one pulse mode. Every
+ * call to TIM3_Schedule generates a single update interrupt
+ * after the given delay, so the callback can pace itself
+ * with a different delay after each step.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim3.h>
+#include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
+
+/**
+ * @addtogroup TIM3
+ * @{
+ */
+
+#define TIM3_COUNTER_FREQ 1000000 ///< Frequency of the TIM3 counter
+
+static void (*updateCallback)(void); ///< Callback function for update event
+
+/**
+ * @brief Initialize TIM3 in one pulse mode.
+ * @details No interrupt is generated until TIM3_Schedule is called.
+ * @param updateCb Function called when a scheduled delay passes
+ */
+void TIM3_Init(void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+
+  RCC_ClocksTypeDef RCC_Clocks;
+  RCC_GetClocksFreq(&RCC_Clocks);
+
+  // APB1 timers run at twice the bus clock if APB1 prescaler is not 1
+  uint32_t timerClock = RCC_Clocks.PCLK1_Frequency;
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    timerClock *= 2;
+  }
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = timerClock / TIM3_COUNTER_FREQ - 1;
+  TIM_TimeBaseStructure.TIM_Period            = TIM3_MAX_DELAY;
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM3, &TIM_TimeBaseStructure);
+
+  // Counter stops by itself after the update event
+  TIM_SelectOnePulseMode(TIM3, TIM_OPMode_Single);
+
+  TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+  TIM_ITConfig(TIM3, TIM_IT_Update, ENABLE);
+
+  // Low priority - a late nibble only slows the display down,
+  // the timing of the bus is kept by the engine (see irq.h)
+  NVIC_SetPriority(TIM3_IRQn, IRQ_PRIO_TIM3);
+  NVIC_EnableIRQ(TIM3_IRQn);
+}
+/**
+ * @brief Generate an update interrupt after given delay.
+ * @details A delay already running is restarted.
+ * @param delayUs Delay in microseconds (2 - TIM3_MAX_DELAY)
+ */
+void TIM3_Schedule(uint16_t delayUs) {
+
+  if (delayUs < 2) {
+    delayUs = 2; // ARR = 0 would never generate an update
+  }
+
+  TIM3->CR1 &= ~TIM_CR1_CEN;
+  TIM3->ARR = delayUs - 1;
+  TIM3->CNT = 0;
+  TIM3->CR1 |= TIM_CR1_CEN;
+}
+/**
+ * @brief IRQ handler for TIM3
+ */
+void TIM3_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM3);
+  TRACE_BEGIN(TRACE_TIM3, 0);
+
+  if (TIM_GetITStatus(TIM3, TIM_IT_Update) != RESET) {
+
+    TIM_ClearITPendingBit(TIM3, TIM_IT_Update);
+
+    if (updateCallback) { // if not NULL
+      updateCallback();
+    }
+  }
+
+  TRACE_END(TRACE_TIM3, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM3);
+}
+
+/**
+ * @}
+ */
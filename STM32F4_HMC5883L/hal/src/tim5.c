@@ -0,0 +1,135 @@
+/**
+ * @file:   tim5.c
+ * @brief:  PC sampling interrupt from TIM5.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details TIM5 counts at 1MHz and interrupts with the
+ * requested frequency. The interrupt has the highest
+ * priority, so it preempts the main loop and all other
+ * interrupts except SysTick (same priority). The handler
+ * reads the program counter of the interrupted code from
+ * the exception stack frame and passes it to the callback.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim5.h>
+#include <stm32f4xx.h>
+#include <irqstat.h>
+#include <irq.h>
+
+/**
+ * @addtogroup TIM5
+ * @{
+ */
+
+#define TIM5_COUNTER_FREQ 1000000 ///< Frequency of the TIM5 counter
+#define TIM5_FRAME_PC     6       ///< Word of the stacked PC in the exception frame
+
+static void (*sampleCallback)(uint32_t pc); ///< Callback function for samples
+
+void TIM5_IRQHandler(void);
+static void TIM5_Sample(uint32_t* frame) __attribute__((used));
+
+/**
+ * @brief Initialize TIM5 sampling interrupt.
+ * @details The timer is stopped after initialization.
+ * @param freq Sampling frequency in Hz
+ * @param sampleCb Function called with the interrupted PC
+ */
+void TIM5_Init(uint32_t freq, void (*sampleCb)(uint32_t pc)) {
+
+  sampleCallback = sampleCb;
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+
+  RCC_ClocksTypeDef RCC_Clocks;
+  RCC_GetClocksFreq(&RCC_Clocks);
+
+  // APB1 timers run at twice the bus clock if APB1 prescaler is not 1
+  uint32_t timerClock = RCC_Clocks.PCLK1_Frequency;
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    timerClock *= 2;
+  }
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = timerClock / TIM5_COUNTER_FREQ - 1;
+  TIM_TimeBaseStructure.TIM_Period            = TIM5_COUNTER_FREQ / freq - 1; // 32-bit counter
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM5, &TIM_TimeBaseStructure);
+
+  TIM_ClearITPendingBit(TIM5, TIM_IT_Update);
+  TIM_ITConfig(TIM5, TIM_IT_Update, ENABLE);
+
+  // Highest priority - samples are taken in other interrupts too
+  NVIC_SetPriority(TIM5_IRQn, IRQ_PRIO_TIM5);
+  NVIC_EnableIRQ(TIM5_IRQn);
+}
+/**
+ * @brief Start sampling.
+ */
+void TIM5_Start(void) {
+
+  TIM_SetCounter(TIM5, 0);
+  TIM_Cmd(TIM5, ENABLE);
+}
+/**
+ * @brief Stop sampling.
+ */
+void TIM5_Stop(void) {
+  TIM_Cmd(TIM5, DISABLE);
+}
+/**
+ * @brief IRQ handler for TIM5
+ * @details Bit 2 of EXC_RETURN (in LR) tells whether the
+ * interrupted code used the main or the process stack.
+ * The frame pointer is passed to TIM5_Sample, which
+ * returns from the exception.
+ */
+__attribute__((naked)) void TIM5_IRQHandler(void) {
+
+  __asm volatile (
+      "tst    lr, #4        \n"
+      "ite    eq            \n"
+      "mrseq  r0, msp       \n"
+      "mrsne  r0, psp       \n"
+      "b      TIM5_Sample   \n"
+  );
+}
+/**
+ * @brief Pass the interrupted PC to the callback.
+ * @param frame Exception stack frame (r0-r3, r12, lr, pc, xpsr)
+ */
+static void TIM5_Sample(uint32_t* frame) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM5);
+
+  if (TIM_GetITStatus(TIM5, TIM_IT_Update) != RESET) {
+
+    // counter restarted at the update event
+    IRQSTAT_LATENCY(IRQSTAT_TIM5, TIM5->CNT * (SystemCoreClock / TIM5_COUNTER_FREQ));
+
+    TIM_ClearITPendingBit(TIM5, TIM_IT_Update);
+
+    if (sampleCallback) { // if not NULL
+      sampleCallback(frame[TIM5_FRAME_PC]);
+    }
+  }
+
+  IRQSTAT_EXIT(IRQSTAT_TIM5);
+}
+
+/**
+ * @}
+ */
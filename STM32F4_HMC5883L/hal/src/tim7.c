@@ -0,0 +1,114 @@
+/**
+ * @file:   tim7.c
+ * @brief:  Periodic interrupt from TIM7.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details TIM7 is a basic timer counting at 1MHz. It runs
+ * only while started, so it costs nothing between key presses.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim7.h>
+#include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
+
+/**
+ * @addtogroup TIM7
+ * @{
+ */
+
+#define TIM7_COUNTER_FREQ 1000000 ///< Frequency of the TIM7 counter
+
+static void (*updateCallback)(void); ///< Callback function for update event
+
+/**
+ * @brief Initialize TIM7 update interrupt.
+ * @details The timer is stopped after initialization.
+ * @param freq Frequency of update interrupt in Hz (at least 16)
+ * @param updateCb Function called on every update event
+ */
+void TIM7_Init(uint32_t freq, void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM7, ENABLE);
+
+  RCC_ClocksTypeDef RCC_Clocks;
+  RCC_GetClocksFreq(&RCC_Clocks);
+
+  // APB1 timers run at twice the bus clock if APB1 prescaler is not 1
+  uint32_t timerClock = RCC_Clocks.PCLK1_Frequency;
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    timerClock *= 2;
+  }
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler         = timerClock / TIM7_COUNTER_FREQ - 1;
+  TIM_TimeBaseStructure.TIM_Period            = TIM7_COUNTER_FREQ / freq - 1; // 16-bit counter
+  TIM_TimeBaseStructure.TIM_ClockDivision     = TIM_CKD_DIV1;
+  TIM_TimeBaseStructure.TIM_CounterMode       = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM7, &TIM_TimeBaseStructure);
+
+  TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+  TIM_ITConfig(TIM7, TIM_IT_Update, ENABLE);
+
+  NVIC_SetPriority(TIM7_IRQn, IRQ_PRIO_TIM7);
+  NVIC_EnableIRQ(TIM7_IRQn);
+}
+/**
+ * @brief Start generating update interrupts.
+ * @details The first one comes after a whole period.
+ */
+void TIM7_Start(void) {
+
+  TIM_SetCounter(TIM7, 0);
+  TIM_Cmd(TIM7, ENABLE);
+}
+/**
+ * @brief Stop generating update interrupts.
+ * @details Can be called from the callback.
+ */
+void TIM7_Stop(void) {
+
+  TIM_Cmd(TIM7, DISABLE);
+  TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+}
+/**
+ * @brief IRQ handler for TIM7
+ */
+void TIM7_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM7);
+  TRACE_BEGIN(TRACE_TIM7, 0);
+
+  if (TIM_GetITStatus(TIM7, TIM_IT_Update) != RESET) {
+
+    // counter restarted at the update event
+    IRQSTAT_LATENCY(IRQSTAT_TIM7, TIM7->CNT * (SystemCoreClock / TIM7_COUNTER_FREQ));
+
+    TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+
+    if (updateCallback) { // if not NULL
+      updateCallback();
+    }
+  }
+
+  TRACE_END(TRACE_TIM7, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM7);
+}
+
+/**
+ * @}
+ */
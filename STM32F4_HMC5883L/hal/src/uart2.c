@@ -17,6 +17,8 @@
 
 #include <uart2.h>
 #include <stm32f4xx.h>
+#include <trace.h>
+#include <irqstat.h>
 
 /**
  * @addtogroup USART2
@@ -83,7 +85,9 @@ void UART2_Init(uint32_t baud, void(*rxCb)(uint8_t), uint8_t(*txCb)(uint8_t*) )
   // data to send
   USART_ITConfig(USART2, USART_IT_TXE, DISABLE);
 
-  // Enable USART2 global interrupt
+  // Enable USART2 global interrupt - above everything that may
+  // take longer than a byte time
+  NVIC_SetPriority(USART2_IRQn, IRQ_PRIO_USART2);
   NVIC_EnableIRQ(USART2_IRQn);
 
 }
@@ -101,6 +105,9 @@ void UART2_TxEnable(void) {
  */
 void USART2_IRQHandler(void) {
 
+  IRQSTAT_ENTER(IRQSTAT_USART2);
+  TRACE_BEGIN(TRACE_USART2, 0);
+
   // If transmit buffer empty interrupt
   if(USART_GetITStatus(USART2, USART_IT_TXE) != RESET) {
 
@@ -119,12 +126,21 @@ void USART2_IRQHandler(void) {
   // If RX buffer not empty interrupt
   if(USART_GetITStatus(USART2, USART_IT_RXNE) != RESET) {
 
+    // a byte was lost - this one waited too long (cleared by reading data)
+    if (USART_GetFlagStatus(USART2, USART_FLAG_ORE) != RESET) {
+      IRQSTAT_LATE(IRQSTAT_USART2);
+    }
+
     uint8_t c = USART_ReceiveData(USART2); // Get data from UART
+    TRACE_INSTANT(TRACE_RX_BYTE, c);
 
     if (rxCallback) { // if not NULL
       rxCallback(c); // send received data to higher layer
     }
   }
+
+  TRACE_END(TRACE_USART2, 0);
+  IRQSTAT_EXIT(IRQSTAT_USART2);
 }
 
 /**
@@ -0,0 +1,86 @@
+/**
+ * @file:   led_hal.h
+ * @brief:  HAL for using LEDs (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Replaces hal/inc/led_hal.h, whose inline functions
+ * write GPIO registers. The interface is the same - the inline
+ * functions pass the LED masks to the LED model instead.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LED_HAL_H_
+#define LED_HAL_H_
+
+#include <inttypes.h>
+#include <sim.h>
+
+/**
+ * @addtogroup LED_HAL
+ * @{
+ */
+
+#define MAX_LEDS    4 ///< Maximum number of LEDs available in design
+
+#define LED_HAL_ALL ((1 << MAX_LEDS) - 1) ///< Mask of all LEDs
+
+/**
+ * @brief Set and reset a group of LEDs in one atomic write.
+ * @param on Mask of LEDs to turn on (bit n - LEDn)
+ * @param off Mask of LEDs to turn off
+ */
+static inline void LED_HAL_SetMask(uint8_t on, uint8_t off) {
+
+  SIM_LedWrite(on & LED_HAL_ALL, off & LED_HAL_ALL);
+}
+/**
+ * @brief Change the state of an LED.
+ * @param led LED number.
+ * @param state New state.
+ */
+static inline void LED_HAL_ChangeState(uint8_t led, uint8_t state) {
+
+  if (state == 1) {
+    SIM_LedWrite(1 << led, 0);
+  } else {
+    SIM_LedWrite(0, 1 << led);
+  }
+}
+/**
+ * @brief Toggle an LED.
+ * @param led LED number.
+ */
+static inline void LED_HAL_Toggle(uint8_t led) {
+
+  if (SIM_LedRead() & (1 << led)) {
+    SIM_LedWrite(0, 1 << led);
+  } else {
+    SIM_LedWrite(1 << led, 0);
+  }
+}
+
+void      LED_HAL_Init         (uint8_t led);
+void      LED_HAL_InitPWM      (uint8_t led);
+uint32_t  LED_HAL_SetPeriod    (uint32_t periodUs);
+void      LED_HAL_SetCompare   (uint8_t led, uint16_t value);
+uint32_t  LED_HAL_SequenceWord (uint8_t led, uint8_t state);
+void      LED_HAL_StartSequence(uint8_t led, uint8_t pwm, const uint32_t* buf,
+                                uint16_t len, uint8_t loop, uint32_t tickUs);
+void      LED_HAL_StopSequence (void);
+uint8_t   LED_HAL_SequenceBusy (void);
+
+/**
+ * @}
+ */
+
+#endif /* LED_HAL_H_ */
@@ -0,0 +1,125 @@
+/**
+ * @file:   sim.h
+ * @brief:  Host simulation of the board.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The simulator runs the unchanged application
+ * sources on a PC. The HAL is replaced by models of the
+ * peripherals (sim/src), which share one virtual clock and
+ * one event queue. Hardware events (timer updates, received
+ * bytes, key presses) are dispatched in time order and set
+ * interrupts pending, and pending interrupts run according
+ * to NVIC enable bits and priorities - also nested in other
+ * interrupt handlers.
+ *
+ * Code never runs "in parallel" with an interrupt. Events
+ * and interrupts are delivered only at poll points: reading
+ * the time (SYSTICK_GetTime, DWT_GetCycles, peripheral
+ * status) or enabling an interrupt.
+ *
+ * The clock follows real time (scaled by --speed), or with
+ * --virtual only the firmware moves it: waiting skips to the
+ * next event, so hours of operation take seconds and every
+ * run with the same script gives the same output.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stm32f4xx.h>
+
+/**
+ * @defgroup  SIM SIM
+ * @brief     Host simulation of the board
+ */
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+#define SIM_NS_PER_US   1000ULL               ///< Nanoseconds in a microsecond
+#define SIM_NS_PER_MS   1000000ULL            ///< Nanoseconds in a millisecond
+#define SIM_US(us)      ((uint64_t)(us) * SIM_NS_PER_US) ///< Microseconds to simulation time
+#define SIM_MS(ms)      ((uint64_t)(ms) * SIM_NS_PER_MS) ///< Milliseconds to simulation time
+
+/**
+ * @brief Hardware event.
+ * @details Owned by the peripheral model, added to the queue
+ * by SIM_Schedule. Events due at the same time are dispatched
+ * in the order they were first scheduled.
+ */
+typedef struct SIM_Event {
+  const char* name;         ///< Name (for diagnostics)
+  void (*handler)(void);    ///< Called when the event is due
+  uint64_t due;             ///< Time of the event (ns)
+  uint8_t active;           ///< Nonzero when scheduled
+  struct SIM_Event* next;   ///< Next registered event
+} SIM_Event_TypeDef;
+
+/**
+ * @brief Initializer of an event.
+ */
+#define SIM_EVENT(name, handler) {(name), (handler), 0, 0, NULL}
+
+/**
+ * @brief Simulator options.
+ */
+typedef struct {
+  double speed;             ///< Virtual time per real time
+  uint8_t virtualTime;      ///< Time advances only with the firmware (deterministic)
+  uint8_t manualTime;       ///< Virtual time advances only in SIM_Advance (unit tests)
+  uint64_t duration;        ///< Stop after this time (0 - run forever)
+  uint8_t quiet;            ///< Don't render the LCD and LEDs
+  uint8_t raw;              ///< Pass UART output without decoding log frames
+  uint8_t pty;              ///< UART on a pseudo terminal instead of stdin/stdout
+  double heading;           ///< Initial compass heading in degrees
+  double rotation;          ///< Compass rotation speed in degrees per second
+  const char* record;       ///< File for samples recorded over COMM (NULL - none)
+} SIM_Options_TypeDef;
+
+extern SIM_Options_TypeDef simOptions;
+
+// Simulator core (sim.c)
+uint64_t  SIM_Now         (void);
+uint64_t  SIM_Clock       (void);
+void      SIM_Poll        (void);
+void      SIM_Advance     (uint64_t ns);
+void      SIM_Schedule    (SIM_Event_TypeDef* ev, uint64_t due);
+void      SIM_Cancel      (SIM_Event_TypeDef* ev);
+void      SIM_IrqHandler  (IRQn_Type irq, void (*handler)(void));
+void      SIM_Exit        (int code);
+
+// Peripheral models
+void      SIM_UartStart   (void);
+void      SIM_UartStop    (void);
+void      SIM_UartInject  (const char* text);
+void      SIM_KeysSet     (uint8_t key, uint8_t pressed);
+void      SIM_MagSetHeading(double heading, double rotation);
+void      SIM_LedRender   (char* buf, uint16_t size);
+void      SIM_LedWrite    (uint8_t on, uint8_t off);
+uint8_t   SIM_LedRead     (void);
+void      SIM_LcdText     (uint8_t row, char* buf);
+void      SIM_LcdGlyph    (uint8_t code, uint8_t* bitmap);
+void      SIM_LcdStats    (uint32_t* instructions, uint32_t* violations);
+void      SIM_LcdRender   (void);
+void      SIM_LcdReport   (void);
+
+/**
+ * @}
+ */
+
+#endif /* SIM_H_ */
@@ -0,0 +1,85 @@
+/**
+ * @file:   stm32f4xx.h
+ * @brief:  Host replacement of the device header.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Only the parts of CMSIS used by the application
+ * layer are provided: interrupt numbers, NVIC control and the
+ * core intrinsics. NVIC functions are implemented by the
+ * simulator (sim.c), which delivers interrupts according to
+ * their enable bits and priorities.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef STM32F4XX_H_
+#define STM32F4XX_H_
+
+#include <inttypes.h>
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+#define __NVIC_PRIO_BITS  4 ///< Priority bits implemented in NVIC
+
+/**
+ * @brief Interrupt numbers (same as in the device header).
+ */
+typedef enum {
+  SysTick_IRQn        = -1,
+  TIM2_IRQn           = 28,
+  TIM3_IRQn           = 29,
+  USART2_IRQn         = 38,
+  EXTI15_10_IRQn      = 40,
+  TIM7_IRQn           = 55,
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock; ///< Core clock frequency in Hz
+
+void      NVIC_EnableIRQ      (IRQn_Type irq);
+void      NVIC_DisableIRQ     (IRQn_Type irq);
+void      NVIC_SetPendingIRQ  (IRQn_Type irq);
+void      NVIC_SetPriority    (IRQn_Type irq, uint32_t priority);
+uint32_t  NVIC_GetPriority    (IRQn_Type irq);
+void      __disable_irq       (void);
+void      __enable_irq        (void);
+uint32_t  __get_PRIMASK       (void);
+void      __set_PRIMASK       (uint32_t value);
+uint32_t  __get_BASEPRI       (void);
+void      __set_BASEPRI       (uint32_t value);
+void      __WFI               (void);
+
+/*
+ * Exclusive access always succeeds - interrupts are only
+ * delivered at simulator poll points, never between LDREX
+ * and STREX.
+ */
+static inline uint32_t __LDREXW(volatile uint32_t* addr) {
+  return *addr;
+}
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t* addr) {
+  *addr = value;
+  return 0;
+}
+static inline void __CLREX(void) {
+}
+static inline void __DMB(void) {
+  __sync_synchronize();
+}
+
+/**
+ * @}
+ */
+
+#endif /* STM32F4XX_H_ */
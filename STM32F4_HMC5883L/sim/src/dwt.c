@@ -0,0 +1,60 @@
+/**
+ * @file:   dwt.c
+ * @brief:  Cycle counter (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The counter is derived from virtual time and
+ * SystemCoreClock, so cycle measurements give the time the
+ * code took in the simulation (not on the board).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <dwt.h>
+#include <sim.h>
+
+/**
+ * @addtogroup DWT
+ * @{
+ */
+
+/**
+ * @brief Enable the cycle counter.
+ */
+void DWT_Init(void) {
+}
+/**
+ * @brief Read the cycle counter.
+ * @return Number of core cycles (wraps around)
+ */
+uint32_t DWT_GetCycles(void) {
+  return (uint32_t)(SIM_Clock() * (SystemCoreClock / 1000000) / SIM_NS_PER_US);
+}
+/**
+ * @brief Wait given number of core cycles.
+ * @param cycles Number of cycles
+ */
+void DWT_DelayCycles(uint32_t cycles) {
+  SIM_Advance((uint64_t)cycles * SIM_NS_PER_US / (SystemCoreClock / 1000000));
+}
+/**
+ * @brief Convert cycles to microseconds.
+ * @param cycles Number of cycles
+ * @return Time in microseconds
+ */
+uint32_t DWT_CyclesToUs(uint32_t cycles) {
+  return cycles / (SystemCoreClock / 1000000);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,431 @@
+/**
+ * @file:   hd44780_hal.c
+ * @brief:  HD44780 display (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Model of the controller on the 4-bit bus: nibbles are
+ * latched on the falling edge of E, instructions change DDRAM,
+ * CGRAM and the address counter like in the datasheet. The busy
+ * flag is set for the execution time of every instruction and
+ * every write while the controller is busy (or sooner than one
+ * enable cycle after the previous nibble) is counted as a timing
+ * violation.
+ *
+ * When the contents change, the display (with the LEDs) is drawn
+ * on stderr. Custom characters are shown as their code (0-7).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780_hal.h>
+#include <sim.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+#define LCD_ROWS_SIM      2           ///< Rows of the display
+#define LCD_COLUMNS_SIM   16          ///< Columns of the display
+#define LCD_LINE_LEN      40          ///< DDRAM bytes per line
+#define LCD_LINE2         0x40        ///< DDRAM address of second line
+#define LCD_POWER_ON      SIM_MS(40)  ///< Time after power on before the first instruction
+#define LCD_INIT_FIRST    SIM_US(4100) ///< Execution time of first function set
+#define LCD_INIT          SIM_US(100) ///< Execution time of other 8-bit function sets
+#define LCD_EXEC          SIM_US(37)  ///< Execution time of most instructions
+#define LCD_EXEC_LONG     SIM_US(1520) ///< Execution time of clear and home
+#define LCD_CYCLE         SIM_US(1)   ///< Enable cycle time - shortest time between nibbles
+#define LCD_RENDER_DELAY  SIM_MS(50)  ///< Drawing is delayed to show complete updates
+
+static uint8_t lcdRs;             ///< RS line
+static uint8_t lcdRw;             ///< RW line
+static uint8_t lcdE;              ///< E line
+static uint8_t lcdData;           ///< Data lines D4-D7 (written by MCU)
+
+static uint8_t lcdFourBit;        ///< 4-bit interface selected
+static uint8_t lcdSecondNibble;   ///< Next nibble is the lower half
+static uint8_t lcdHighNibble;     ///< Upper half of the instruction
+static uint8_t lcdReadLow;        ///< Next read returns the lower half
+static uint8_t lcdWrites8;        ///< Number of 8-bit mode writes
+
+static uint8_t lcdDdram[2 * LCD_LINE2];  ///< Display data RAM
+static uint8_t lcdCgram[64];      ///< Character generator RAM
+static uint8_t lcdAc;             ///< Address counter
+static uint8_t lcdCgMode;         ///< Address counter points to CGRAM
+static uint8_t lcdIncrement = 1;  ///< Entry mode - increment address
+static uint8_t lcdDisplayOn;      ///< Display on
+static int8_t lcdShift;           ///< Display shift
+static uint64_t lcdBusyUntil;     ///< End of execution of last instruction
+static uint64_t lcdLastLatch;     ///< Time of last latched nibble
+
+static uint32_t lcdInstructions;  ///< Number of executed instructions and writes
+static uint32_t lcdViolations;    ///< Writes while busy
+static char lcdShown[LCD_ROWS_SIM + 1][80]; ///< Last drawn text
+
+static void LCD_HAL_Latch(uint8_t rs, uint8_t nibble);
+static void LCD_HAL_Execute(uint8_t rs, uint8_t byte);
+static void LCD_HAL_Changed(void);
+static void LCD_HAL_NextAddress(void);
+
+static SIM_Event_TypeDef lcdRenderEvent = SIM_EVENT("LCD render", SIM_LcdRender);
+
+/**
+ * @brief Initialize the display lines.
+ */
+void LCD_HAL_Init(void) {
+
+  memset(lcdDdram, ' ', sizeof(lcdDdram)); // contents after power on
+
+  lcdRs = 0;
+  lcdRw = 0;
+  lcdE = 0;
+}
+
+void LCD_HAL_LowRS(void) {
+  lcdRs = 0;
+}
+
+void LCD_HAL_HighRS(void) {
+  lcdRs = 1;
+}
+
+void LCD_HAL_LowRW(void) {
+  lcdRw = 0;
+}
+
+void LCD_HAL_HighRW(void) {
+  lcdRw = 1;
+}
+
+void LCD_HAL_HighE(void) {
+  lcdE = 1;
+}
+/**
+ * @brief E falling edge - the display latches the data lines.
+ */
+void LCD_HAL_LowE(void) {
+
+  if (lcdE && !lcdRw) {
+    LCD_HAL_Latch(lcdRs, lcdData);
+  }
+  lcdE = 0;
+}
+
+void LCD_HAL_DataOut(void) {
+}
+
+void LCD_HAL_DataIn(void) {
+}
+/**
+ * @brief Put a nibble on the data lines.
+ * @param data Nibble (4 LSB)
+ */
+void LCD_HAL_Write(uint8_t data) {
+  lcdData = data & 0x0f;
+}
+/**
+ * @brief Write a nibble to the display (whole bus cycle).
+ * @param rs RS line level
+ * @param nibble Nibble (4 LSB)
+ */
+void LCD_HAL_WriteNibble(uint8_t rs, uint8_t nibble) {
+
+  lcdRs = rs;
+  lcdRw = 0;
+  lcdData = nibble & 0x0f;
+  LCD_HAL_Latch(rs, lcdData);
+}
+/**
+ * @brief Read a nibble (E strobe with RW high).
+ * @details With RS low the busy flag and address counter are
+ * read - upper half first.
+ * @return Nibble (4 LSB)
+ */
+uint8_t LCD_HAL_Read(void) {
+
+  uint8_t value = (SIM_Now() < lcdBusyUntil ? 0x80 : 0) | (lcdAc & 0x7f);
+
+  if (lcdRs) {
+    value = lcdCgMode ? lcdCgram[lcdAc & 0x3f] : lcdDdram[lcdAc & 0x7f];
+  }
+
+  lcdReadLow = !lcdReadLow;
+  return lcdReadLow ? (value >> 4) : (value & 0x0f);
+}
+/**
+ * @brief Compare the bus operations with the StdPeriph path.
+ * @details There is no bus to measure in the simulation -
+ * all results are zero.
+ * @param fast Returns cycles of the HAL
+ * @param std Returns cycles of the StdPeriph path
+ */
+void LCD_HAL_Benchmark(LCD_HAL_Bench_TypeDef* fast, LCD_HAL_Bench_TypeDef* std) {
+
+  memset(fast, 0, sizeof(*fast));
+  memset(std, 0, sizeof(*std));
+}
+/**
+ * @brief Describe a visible row of the display.
+ * @details Custom characters are shown as their code (0-7),
+ * other characters outside ASCII as ?.
+ * @param row Row number
+ * @param buf Buffer for text (at least LCD_COLUMNS_SIM + 1 bytes)
+ */
+void SIM_LcdText(uint8_t row, char* buf) {
+
+  uint8_t col;
+
+  for (col = 0; col < LCD_COLUMNS_SIM; col++) {
+
+    uint8_t pos = (uint8_t)(col + lcdShift + LCD_LINE_LEN) % LCD_LINE_LEN;
+    uint8_t c = lcdDisplayOn ? lcdDdram[row * LCD_LINE2 + pos] : ' ';
+
+    if (c < 0x10) {
+      c = '0' + (c & 0x07); // custom character
+    } else if (c < ' ' || c > '~') {
+      c = '?';
+    }
+    buf[col] = c;
+  }
+  buf[col] = 0;
+}
+/**
+ * @brief Get the bitmap of a custom character.
+ * @param code Character code (0-15, codes 8-15 mirror 0-7)
+ * @param bitmap Buffer for 8 rows of 5 pixels
+ */
+void SIM_LcdGlyph(uint8_t code, uint8_t* bitmap) {
+
+  uint8_t i;
+
+  for (i = 0; i < 8; i++) {
+    bitmap[i] = lcdCgram[(code & 0x07) * 8 + i] & 0x1f;
+  }
+}
+/**
+ * @brief Get display statistics.
+ * @param instructions Number of executed instructions and writes
+ * @param violations Number of writes breaking the timing
+ */
+void SIM_LcdStats(uint32_t* instructions, uint32_t* violations) {
+
+  *instructions = lcdInstructions;
+  *violations = lcdViolations;
+}
+/**
+ * @brief Draw the display and LEDs on stderr.
+ */
+void SIM_LcdRender(void) {
+
+  char text[LCD_ROWS_SIM + 1][80];
+  uint8_t row;
+
+  memset(text, 0, sizeof(text)); // compared whole
+
+  for (row = 0; row < LCD_ROWS_SIM; row++) {
+    text[row][0] = '|';
+    SIM_LcdText(row, text[row] + 1);
+    strcat(text[row], "|");
+  }
+
+  SIM_LedRender(text[LCD_ROWS_SIM], sizeof(text[LCD_ROWS_SIM]));
+
+  if (!memcmp(text, lcdShown, sizeof(text))) {
+    return; // nothing changed
+  }
+  memcpy(lcdShown, text, sizeof(text));
+
+  uint64_t now = SIM_Now();
+  fflush(stdout);
+  fprintf(stderr, "+----------------+ %llu.%03llu s\n",
+      (unsigned long long)(now / SIM_MS(1000)),
+      (unsigned long long)(now / SIM_MS(1) % 1000));
+  fprintf(stderr, "%s\n%s\n", text[0], text[1]);
+  fprintf(stderr, "+----------------+ %s\n", text[LCD_ROWS_SIM]);
+}
+/**
+ * @brief Print display statistics.
+ */
+void SIM_LcdReport(void) {
+
+  fprintf(stderr, "SIM--> LCD: %u instructions, %u written while busy\n",
+      lcdInstructions, lcdViolations);
+}
+/**
+ * @brief Nibble latched by the display.
+ * @param rs RS line level
+ * @param nibble Nibble (4 LSB)
+ */
+static void LCD_HAL_Latch(uint8_t rs, uint8_t nibble) {
+
+  uint64_t now = SIM_Now();
+
+  if (now - lcdLastLatch < LCD_CYCLE) {
+    lcdViolations++;
+  }
+  lcdLastLatch = now;
+
+  if (!lcdFourBit) {
+
+    // 8-bit interface after power on - D0-D3 are not connected (low)
+    if (now < LCD_POWER_ON || (lcdWrites8 && now < lcdBusyUntil)) {
+      lcdViolations++;
+    }
+    lcdBusyUntil = now + (lcdWrites8 ? LCD_INIT : LCD_INIT_FIRST);
+    lcdWrites8++;
+
+    if (!rs && (nibble & 0x0e) == 0x02) {
+      // function set
+      lcdFourBit = !(nibble & 0x01);
+      lcdSecondNibble = 0;
+    }
+    lcdInstructions++;
+    return;
+  }
+
+  if (!lcdSecondNibble) {
+
+    if (now < lcdBusyUntil) {
+      lcdViolations++;
+    }
+    lcdHighNibble = nibble & 0x0f;
+    lcdSecondNibble = 1;
+
+  } else {
+
+    lcdSecondNibble = 0;
+    LCD_HAL_Execute(rs, (lcdHighNibble << 4) | (nibble & 0x0f));
+  }
+}
+/**
+ * @brief Execute an instruction or write data.
+ * @param rs RS line level (1 - data)
+ * @param byte Instruction or data
+ */
+static void LCD_HAL_Execute(uint8_t rs, uint8_t byte) {
+
+  uint64_t exec = LCD_EXEC;
+
+  lcdInstructions++;
+
+  if (rs) {
+
+    if (lcdCgMode) {
+      lcdCgram[lcdAc & 0x3f] = byte;
+    } else {
+      lcdDdram[lcdAc & 0x7f] = byte;
+    }
+    LCD_HAL_NextAddress();
+    LCD_HAL_Changed();
+
+  } else if (byte & 0x80) {           // set DDRAM address
+
+    lcdAc = byte & 0x7f;
+    lcdCgMode = 0;
+
+  } else if (byte & 0x40) {           // set CGRAM address
+
+    lcdAc = byte & 0x3f;
+    lcdCgMode = 1;
+
+  } else if (byte & 0x20) {           // function set
+
+    lcdFourBit = !(byte & 0x10);
+
+  } else if (byte & 0x10) {           // cursor or display shift
+
+    if (byte & 0x08) {
+      lcdShift += (byte & 0x04) ? -1 : 1;
+      lcdShift = (lcdShift + LCD_LINE_LEN) % LCD_LINE_LEN;
+      LCD_HAL_Changed();
+    } else {
+      uint8_t increment = lcdIncrement;
+      lcdIncrement = (byte & 0x04) ? 1 : 0;
+      LCD_HAL_NextAddress();
+      lcdIncrement = increment;
+    }
+
+  } else if (byte & 0x08) {           // display on/off control
+
+    lcdDisplayOn = (byte & 0x04) ? 1 : 0;
+    LCD_HAL_Changed();
+
+  } else if (byte & 0x04) {           // entry mode set
+
+    lcdIncrement = (byte & 0x02) ? 1 : 0;
+
+  } else if (byte & 0x02) {           // return home
+
+    lcdAc = 0;
+    lcdCgMode = 0;
+    lcdShift = 0;
+    exec = LCD_EXEC_LONG;
+    LCD_HAL_Changed();
+
+  } else if (byte & 0x01) {           // clear display
+
+    memset(lcdDdram, ' ', sizeof(lcdDdram));
+    lcdAc = 0;
+    lcdCgMode = 0;
+    lcdShift = 0;
+    lcdIncrement = 1;
+    exec = LCD_EXEC_LONG;
+    LCD_HAL_Changed();
+  }
+
+  lcdBusyUntil = SIM_Now() + exec;
+}
+/**
+ * @brief Move the address counter after a data access.
+ * @details DDRAM addresses wrap from the end of the first
+ * line to the second line and from the second to the first.
+ */
+static void LCD_HAL_NextAddress(void) {
+
+  if (lcdCgMode) {
+    lcdAc = (lcdAc + (lcdIncrement ? 1 : -1)) & 0x3f;
+    return;
+  }
+
+  if (lcdIncrement) {
+    if (lcdAc == LCD_LINE_LEN - 1) {
+      lcdAc = LCD_LINE2;
+    } else if (lcdAc == LCD_LINE2 + LCD_LINE_LEN - 1) {
+      lcdAc = 0;
+    } else {
+      lcdAc++;
+    }
+  } else {
+    if (lcdAc == 0) {
+      lcdAc = LCD_LINE2 + LCD_LINE_LEN - 1;
+    } else if (lcdAc == LCD_LINE2) {
+      lcdAc = LCD_LINE_LEN - 1;
+    } else {
+      lcdAc--;
+    }
+  }
+}
+/**
+ * @brief Schedule drawing of the display.
+ */
+static void LCD_HAL_Changed(void) {
+
+  if (!simOptions.quiet && !lcdRenderEvent.active) {
+    SIM_Schedule(&lcdRenderEvent, SIM_Now() + LCD_RENDER_DELAY);
+  }
+}
+
+/**
+ * @}
+ */
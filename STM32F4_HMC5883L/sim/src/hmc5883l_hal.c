@@ -0,0 +1,216 @@
+/**
+ * @file:   hmc5883l_hal.c
+ * @brief:  HMC5883L compass (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The sensor measures a horizontal field rotated by the
+ * heading set with --heading/--rotate or a script, so that
+ * HMC5883L_CalcAngle gives back the heading. Transfers take as
+ * long as on the 1kHz I2C bus of the board. Like in the sensor,
+ * data registers are locked after the first one is read, until
+ * all six are read.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hmc5883l_hal.h>
+#include <sim.h>
+#include <trace.h>
+#include <math.h>
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+#define HMC5883L_I2C_FREQ   1000  ///< I2C clock frequency (same as on the board)
+#define HMC5883L_READ_BITS  39    ///< Bus clocks of a register read (4 bytes with ACK, start, repeated start, stop)
+#define HMC5883L_WRITE_BITS 29    ///< Bus clocks of a register write (3 bytes with ACK, start, stop)
+#define HMC5883L_READ_US    (HMC5883L_READ_BITS * 1000000 / HMC5883L_I2C_FREQ)  ///< Duration of a read
+#define HMC5883L_WRITE_US   (HMC5883L_WRITE_BITS * 1000000 / HMC5883L_I2C_FREQ) ///< Duration of a write
+
+#define HMC5883L_FIELD      500   ///< Horizontal field in LSB (about 0.46Ga with default gain)
+#define HMC5883L_FIELD_Z    (-300) ///< Vertical field in LSB
+
+#define HMC5883L_REGS       13    ///< Number of registers
+#define HMC5883L_DATA_FIRST 0x03  ///< First data output register
+#define HMC5883L_DATA_LAST  0x08  ///< Last data output register
+#define HMC5883L_STATUS     0x09  ///< Status register
+#define HMC5883L_STATUS_RDY 0x01  ///< Data ready
+#define HMC5883L_STATUS_LOCK 0x02 ///< Data registers locked
+
+/**
+ * @brief Register values after reset.
+ */
+static uint8_t hmcRegs[HMC5883L_REGS] = {
+    0x10, 0x20, 0x01, 0, 0, 0, 0, 0, 0, 0, 'H', '4', '3'
+};
+
+static uint8_t hmcReadMask;   ///< Data registers read since the lock (bit n - register 3 + n)
+static double hmcHeading;     ///< Heading at hmcHeadingTime in degrees
+static double hmcRotation;    ///< Rotation speed in degrees per second
+static uint64_t hmcHeadingTime; ///< Time the heading was set
+
+static uint8_t HMC5883L_HAL_Register(uint8_t address);
+static void HMC5883L_HAL_Measure(void);
+static uint32_t HMC5883L_HAL_Micros(void);
+
+/**
+ * @brief Initialize the I2C bus.
+ */
+void HMC5883L_HAL_Init(void) {
+}
+/**
+ * @brief Read a register (blocking).
+ * @param address Register address
+ * @return Register value
+ */
+uint8_t HMC5883L_HAL_Read(uint8_t address) {
+
+  PT_TypeDef pt;
+  uint8_t ret;
+
+  PT_INIT(&pt);
+  while (PT_SCHEDULE(HMC5883L_HAL_ReadThread(&pt, address, &ret)));
+
+  return ret;
+}
+/**
+ * @brief Write a register (blocking).
+ * @param address Register address
+ * @param data Value
+ */
+void HMC5883L_HAL_Write(uint8_t address, uint8_t data) {
+
+  PT_TypeDef pt;
+
+  PT_INIT(&pt);
+  while (PT_SCHEDULE(HMC5883L_HAL_WriteThread(&pt, address, data)));
+}
+/**
+ * @brief Read a register (protothread).
+ * @param pt Thread control structure
+ * @param address Register address
+ * @param data Register value
+ */
+PT_THREAD(HMC5883L_HAL_ReadThread(PT_TypeDef* pt, uint8_t address, uint8_t* data)) {
+
+  PT_BEGIN(pt);
+
+  TRACE_BEGIN(TRACE_I2C, address);
+
+  pt->timer = HMC5883L_HAL_Micros();
+  PT_WAIT_UNTIL(pt, HMC5883L_HAL_Micros() - pt->timer >= HMC5883L_READ_US);
+
+  *data = HMC5883L_HAL_Register(address);
+
+  TRACE_END(TRACE_I2C, address);
+
+  PT_END(pt);
+}
+/**
+ * @brief Write a register (protothread).
+ * @param pt Thread control structure
+ * @param address Register address
+ * @param data Value
+ */
+PT_THREAD(HMC5883L_HAL_WriteThread(PT_TypeDef* pt, uint8_t address, uint8_t data)) {
+
+  PT_BEGIN(pt);
+
+  TRACE_BEGIN(TRACE_I2C, address);
+
+  pt->timer = HMC5883L_HAL_Micros();
+  PT_WAIT_UNTIL(pt, HMC5883L_HAL_Micros() - pt->timer >= HMC5883L_WRITE_US);
+
+  if (address < HMC5883L_DATA_FIRST) {
+    hmcRegs[address] = data;
+  }
+
+  TRACE_END(TRACE_I2C, address);
+
+  PT_END(pt);
+}
+/**
+ * @brief Set the heading of the simulated sensor.
+ * @param heading Heading in degrees
+ * @param rotation Rotation speed in degrees per second
+ */
+void SIM_MagSetHeading(double heading, double rotation) {
+
+  hmcHeading = heading;
+  hmcRotation = rotation;
+  hmcHeadingTime = SIM_Now();
+}
+/**
+ * @brief Register value seen by a read transfer.
+ * @param address Register address
+ * @return Register value
+ */
+static uint8_t HMC5883L_HAL_Register(uint8_t address) {
+
+  if (address >= HMC5883L_REGS) {
+    return 0;
+  }
+
+  if (address >= HMC5883L_DATA_FIRST && address <= HMC5883L_DATA_LAST) {
+
+    if (hmcReadMask == 0) {
+      HMC5883L_HAL_Measure(); // latest measurement is locked
+    }
+
+    hmcReadMask |= 1 << (address - HMC5883L_DATA_FIRST);
+    uint8_t value = hmcRegs[address];
+
+    if (hmcReadMask == 0x3f) {
+      hmcReadMask = 0; // all read - unlocked
+    }
+    return value;
+  }
+
+  if (address == HMC5883L_STATUS) {
+    return HMC5883L_STATUS_RDY | (hmcReadMask ? HMC5883L_STATUS_LOCK : 0);
+  }
+
+  return hmcRegs[address];
+}
+/**
+ * @brief Store current field in data registers.
+ * @details Order of registers is X, Z, Y (MSB first).
+ */
+static void HMC5883L_HAL_Measure(void) {
+
+  double t = (double)(SIM_Now() - hmcHeadingTime) / SIM_MS(1000);
+  double heading = (hmcHeading + hmcRotation * t) * M_PI / 180.0;
+
+  int16_t values[3];
+  values[0] = (int16_t)lround(HMC5883L_FIELD * cos(heading)); // X
+  values[1] = HMC5883L_FIELD_Z;                               // Z
+  values[2] = (int16_t)lround(HMC5883L_FIELD * sin(heading)); // Y
+
+  uint8_t i;
+  for (i = 0; i < 3; i++) {
+    hmcRegs[HMC5883L_DATA_FIRST + 2 * i] = (uint16_t)values[i] >> 8;
+    hmcRegs[HMC5883L_DATA_FIRST + 2 * i + 1] = (uint16_t)values[i] & 0xff;
+  }
+}
+/**
+ * @brief Time for measuring transfers.
+ * @return Virtual time in microseconds (wraps around)
+ */
+static uint32_t HMC5883L_HAL_Micros(void) {
+  return (uint32_t)(SIM_Now() / SIM_NS_PER_US);
+}
+
+/**
+ * @}
+ */
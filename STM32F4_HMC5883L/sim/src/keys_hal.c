@@ -0,0 +1,185 @@
+/**
+ * @file:   keys_hal.c
+ * @brief:  Matrix keyboard (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Keys are pressed and released by script commands.
+ * A pressed key connects its column to its row, so a row reads
+ * low when the key is pressed and its column is selected (low).
+ * A falling edge on a row line generates the EXTI interrupt
+ * if it is enabled.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <keys_hal.h>
+#include <keys.h>
+#include <sim.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <irq.h>
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+static void (*pressCallback)(void); ///< Callback function for key press interrupt
+
+static uint16_t keysPressed;  ///< Pressed keys (bit KEYS_INDEX(column, row))
+static uint8_t keysColumns;   ///< Selected (low) columns
+static uint8_t keysRows;      ///< Rows pulled low
+static uint8_t keysExtiMask;  ///< EXTI interrupt enabled
+static uint8_t keysExtiPending; ///< EXTI pending bit
+
+static void KEYS_HAL_UpdateRows(void);
+void EXTI15_10_IRQHandler(void);
+
+/**
+ * @brief Initialize keyboard lines.
+ */
+void KEYS_HAL_Init(void) {
+}
+/**
+ * @brief Select a column (low level), deselect the others.
+ * @param col Column number
+ */
+void KEYS_HAL_SelectColumn(uint8_t col) {
+
+  keysColumns = (col < KEYS_COLUMNS) ? (1 << col) : 0;
+  KEYS_HAL_UpdateRows();
+}
+/**
+ * @brief Select all columns (any key press pulls its row low).
+ */
+void KEYS_HAL_SelectAll(void) {
+
+  keysColumns = (1 << KEYS_COLUMNS) - 1;
+  KEYS_HAL_UpdateRows();
+}
+/**
+ * @brief Initialize key press interrupt (disabled until KEYS_HAL_IrqEnable).
+ * @param pressCb Function called on key press
+ */
+void KEYS_HAL_IrqInit(void (*pressCb)(void)) {
+
+  pressCallback = pressCb;
+
+  SIM_IrqHandler(EXTI15_10_IRQn, EXTI15_10_IRQHandler);
+  NVIC_SetPriority(EXTI15_10_IRQn, IRQ_PRIO_EXTI);
+  NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+/**
+ * @brief Enable key press interrupt.
+ */
+void KEYS_HAL_IrqEnable(void) {
+
+  keysExtiPending = 0; // ignore old edges
+  keysExtiMask = 1;
+}
+/**
+ * @brief Disable key press interrupt.
+ */
+void KEYS_HAL_IrqDisable(void) {
+  keysExtiMask = 0;
+}
+/**
+ * @brief EXTI interrupt handler.
+ */
+void EXTI15_10_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_EXTI);
+  TRACE_BEGIN(TRACE_EXTI, 0);
+
+  if (keysExtiPending) {
+
+    KEYS_HAL_IrqDisable();
+    keysExtiPending = 0;
+
+    if (pressCallback) { // if not NULL
+      pressCallback();
+    }
+  }
+
+  TRACE_END(TRACE_EXTI, 0);
+  IRQSTAT_EXIT(IRQSTAT_EXTI);
+}
+/**
+ * @brief Read the first row with a pressed key.
+ * @return Row number or -1 if no row is low
+ */
+int8_t KEYS_HAL_ReadRow(void) {
+
+  int8_t row;
+
+  SIM_Poll();
+
+  for (row = 0; row < KEYS_ROWS; row++) {
+    if (keysRows & (1 << row)) {
+      return row;
+    }
+  }
+  return -1;
+}
+/**
+ * @brief Read all rows.
+ * @return Bitmap of rows with a pressed key (bit n - row n)
+ */
+uint8_t KEYS_HAL_ReadRows(void) {
+
+  SIM_Poll();
+  return keysRows;
+}
+/**
+ * @brief Press or release a key.
+ * @param key Key number (KEYS_INDEX)
+ * @param pressed Nonzero - press, zero - release
+ */
+void SIM_KeysSet(uint8_t key, uint8_t pressed) {
+
+  if (key >= KEYS_COUNT) {
+    return;
+  }
+
+  if (pressed) {
+    keysPressed |= 1 << key;
+  } else {
+    keysPressed &= ~(1 << key);
+  }
+  KEYS_HAL_UpdateRows();
+}
+/**
+ * @brief Compute row levels, detect falling edges.
+ */
+static void KEYS_HAL_UpdateRows(void) {
+
+  uint8_t rows = 0;
+  uint8_t col;
+
+  for (col = 0; col < KEYS_COLUMNS; col++) {
+    if (keysColumns & (1 << col)) {
+      rows |= (keysPressed >> KEYS_INDEX(col, 0)) & ((1 << KEYS_ROWS) - 1);
+    }
+  }
+
+  uint8_t falling = rows & ~keysRows;
+  keysRows = rows;
+
+  if (falling && keysExtiMask) {
+    keysExtiPending = 1;
+    NVIC_SetPendingIRQ(EXTI15_10_IRQn);
+  }
+}
+
+/**
+ * @}
+ */
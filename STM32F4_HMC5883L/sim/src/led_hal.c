@@ -0,0 +1,275 @@
+/**
+ * @file:   led_hal.c
+ * @brief:  LEDs (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Keeps the state of the LED pins, the PWM timer and
+ * the DMA sequencer. Sequencer steps are evaluated from the
+ * virtual time when the state is needed, like the DMA they
+ * don't use any events.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <led_hal.h>
+#include <stdio.h>
+
+/**
+ * @addtogroup LED_HAL
+ * @{
+ */
+
+#define LED_HAL_FIRST_PIN   12        ///< Pin number of LED0 (BSRR values are the same as on the board)
+#define LED_HAL_TIMER_CLOCK 84000000  ///< Clock of the PWM timer
+#define LED_HAL_BLINK       SIM_MS(20) ///< Shortest PWM period shown as blinking
+
+static uint8_t ledOdr;                  ///< Output levels (bit n - LEDn)
+static uint8_t ledUsed;                 ///< Initialized LEDs
+static uint8_t ledPwmMask;              ///< LEDs driven by the PWM timer
+static uint16_t ledCompare[MAX_LEDS];   ///< PWM compare values
+static uint32_t ledTicks = 1;           ///< PWM period in timer ticks
+static uint64_t ledPeriod;              ///< PWM period in ns
+
+static const uint32_t* seqBuf;          ///< Sequence buffer (NULL - not playing)
+static uint16_t seqLen;                 ///< Number of values
+static uint8_t seqLed;                  ///< LED of the sequence
+static uint8_t seqPwm;                  ///< Values are compare values
+static uint8_t seqLoop;                 ///< Sequence repeats
+static uint64_t seqTick;                ///< Duration of one value in ns
+static uint64_t seqStart;               ///< Start time of the sequence
+static uint64_t seqSteps;               ///< Number of update events already applied
+
+static void LED_HAL_SequenceUpdate(void);
+
+/**
+ * @brief Initialize an LED in GPIO mode (off).
+ * @param led LED number.
+ */
+void LED_HAL_Init(uint8_t led) {
+
+  ledUsed |= 1 << led;
+  ledPwmMask &= ~(1 << led);
+  ledOdr &= ~(1 << led);
+}
+/**
+ * @brief Initialize an LED driven by the PWM timer (off).
+ * @param led LED number.
+ */
+void LED_HAL_InitPWM(uint8_t led) {
+
+  if (ledPeriod == 0) {
+    LED_HAL_SetPeriod(1000); // 1kHz for dimming by default
+  }
+
+  ledUsed |= 1 << led;
+  ledPwmMask |= 1 << led;
+  ledCompare[led] = 0;
+}
+/**
+ * @brief Set period of the PWM timer.
+ * @param periodUs Period in microseconds
+ * @return Number of timer ticks in period (compare value for 100%)
+ */
+uint32_t LED_HAL_SetPeriod(uint32_t periodUs) {
+
+  // same resolution as the 16-bit timer of the board
+  uint32_t ticks = periodUs * (LED_HAL_TIMER_CLOCK / 1000000);
+  uint32_t prescaler = (ticks + 0xfffe) / 0xffff;
+  if (prescaler == 0) {
+    prescaler = 1;
+    ticks = 1;
+  }
+
+  ledTicks = ticks / prescaler;
+  ledPeriod = SIM_US(periodUs);
+
+  return ledTicks;
+}
+/**
+ * @brief Set PWM compare value of an LED.
+ * @param led LED number.
+ * @param value Compare value.
+ */
+void LED_HAL_SetCompare(uint8_t led, uint16_t value) {
+
+  LED_HAL_SequenceUpdate();
+  ledCompare[led] = value;
+}
+/**
+ * @brief Value written by the sequencer to turn an LED on or off.
+ * @param led LED number.
+ * @param state 1 - LED on, 0 - LED off
+ * @return BSRR value
+ */
+uint32_t LED_HAL_SequenceWord(uint8_t led, uint8_t state) {
+
+  if (state) {
+    return 1UL << (LED_HAL_FIRST_PIN + led);        // set bit
+  } else {
+    return 1UL << (LED_HAL_FIRST_PIN + led + 16);   // reset bit
+  }
+}
+/**
+ * @brief Start playing a sequence of output values.
+ * @param led LED number.
+ * @param pwm Nonzero - buffer holds compare values, zero - BSRR values
+ * @param buf Sequence buffer (has to stay valid while playing)
+ * @param len Number of values in buffer
+ * @param loop Nonzero - repeat sequence, zero - play once
+ * @param tickUs Duration of one value in microseconds (rounded like
+ * the TIM8 period and repetition counter on the target)
+ */
+void LED_HAL_StartSequence(uint8_t led, uint8_t pwm, const uint32_t* buf,
+    uint16_t len, uint8_t loop, uint32_t tickUs) {
+
+  LED_HAL_StopSequence();
+
+  seqLed = led;
+  seqPwm = pwm;
+  seqLen = len;
+  seqLoop = loop;
+  uint32_t ticks = tickUs / 100; // 10 kHz step timer
+  if (ticks == 0) {
+    ticks = 1;
+  }
+  uint32_t repeat = (ticks + 0xffff) / 0x10000;
+  if (repeat > 0x100) {
+    repeat = 0x100;
+    ticks = 0x100 * 0x10000;
+  }
+  seqTick = SIM_US((uint64_t)ticks / repeat * repeat * 100);
+  seqStart = SIM_Now();
+  seqSteps = 0;
+  seqBuf = len ? buf : NULL;
+}
+/**
+ * @brief Stop playing the sequence.
+ * @details The LED keeps the last written value.
+ */
+void LED_HAL_StopSequence(void) {
+
+  LED_HAL_SequenceUpdate();
+  seqBuf = NULL;
+}
+/**
+ * @brief Checks whether a sequence is playing.
+ * @retval 1 Sequence playing (one-shot sequences stop by themselves)
+ * @retval 0 No sequence
+ */
+uint8_t LED_HAL_SequenceBusy(void) {
+
+  LED_HAL_SequenceUpdate();
+  return seqBuf ? 1 : 0;
+}
+/**
+ * @brief Write LED outputs (BSRR).
+ * @param on Mask of LEDs to turn on
+ * @param off Mask of LEDs to turn off
+ */
+void SIM_LedWrite(uint8_t on, uint8_t off) {
+
+  LED_HAL_SequenceUpdate();
+  ledOdr = (ledOdr & ~off) | on; // set has priority
+}
+/**
+ * @brief Read LED outputs (ODR).
+ * @return Output levels (bit n - LEDn)
+ */
+uint8_t SIM_LedRead(void) {
+
+  LED_HAL_SequenceUpdate();
+  return ledOdr;
+}
+/**
+ * @brief Describe current state of LEDs.
+ * @details Every LED is shown as * (on), . (off), - (not used)
+ * or 1-9 (PWM brightness in tens of percent). Long PWM periods
+ * are shown as blinking.
+ * @param buf Buffer for text
+ * @param size Size of buffer
+ */
+void SIM_LedRender(char* buf, uint16_t size) {
+
+  uint8_t led;
+  uint16_t len = 0;
+  uint64_t now = SIM_Now();
+
+  LED_HAL_SequenceUpdate();
+
+  buf[0] = 0;
+
+  for (led = 0; led < MAX_LEDS && len < size; led++) {
+
+    char c;
+
+    if (!(ledUsed & (1 << led))) {
+      c = '-';
+    } else if (!(ledPwmMask & (1 << led))) {
+      c = (ledOdr & (1 << led)) ? '*' : '.';
+    } else if (ledCompare[led] == 0) {
+      c = '.';
+    } else if (ledCompare[led] >= ledTicks) {
+      c = '*';
+    } else if (ledPeriod >= LED_HAL_BLINK) {
+      uint64_t phase = now % ledPeriod;
+      c = (phase < ledPeriod * ledCompare[led] / ledTicks) ? '*' : '.';
+    } else {
+      c = '0' + ledCompare[led] * 10 / ledTicks;
+      if (c == '0') {
+        c = '1';
+      }
+    }
+
+    len += snprintf(buf + len, size - len, "%sLED%d %c", led ? "  " : "", led, c);
+  }
+}
+/**
+ * @brief Apply the sequencer writes up to now.
+ */
+static void LED_HAL_SequenceUpdate(void) {
+
+  if (seqBuf == NULL) {
+    return;
+  }
+
+  // first value is written at the first update event
+  uint64_t steps = (SIM_Now() - seqStart) / seqTick;
+  if (steps == seqSteps) {
+    return; // no DMA write since the last update
+  }
+  seqSteps = steps;
+
+  uint32_t index;
+  if (steps >= seqLen && !seqLoop) {
+    index = seqLen - 1;
+  } else {
+    index = (steps - 1) % seqLen;
+  }
+
+  uint32_t value = seqBuf[index];
+
+  if (seqPwm) {
+    ledCompare[seqLed] = value;
+  } else {
+    uint8_t on = (value >> LED_HAL_FIRST_PIN) & LED_HAL_ALL;
+    uint8_t off = (value >> (LED_HAL_FIRST_PIN + 16)) & LED_HAL_ALL;
+    ledOdr = (ledOdr & ~off) | on;
+  }
+
+  if (steps >= seqLen && !seqLoop) {
+    seqBuf = NULL; // normal mode DMA stops after the last value
+  }
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,836 @@
+/**
+ * @file:   sim.c
+ * @brief:  Host simulation of the board - clock, events and NVIC.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Virtual time runs with real time multiplied by
+ * the speed option. Every poll point dispatches the hardware
+ * events which became due (in time order) and then runs the
+ * pending interrupts which have higher priority than the
+ * code currently executing - the same rules as the NVIC,
+ * only evaluated at poll points.
+ *
+ * With --virtual the clock doesn't follow real time at all,
+ * so runs are repeatable and as fast as the host allows. Every
+ * poll point costs SIM_POLL_COST of virtual time and when the
+ * firmware keeps polling without anything happening (waiting
+ * for a timer, a delay loop) the clock jumps to the next event.
+ * A firmware which stops reaching poll points (a loop on a
+ * flag without reading the time) is caught by a watchdog on
+ * real time.
+ *
+ * Unit tests set the manualTime option on top of it - then
+ * the clock stands still between SIM_Advance calls, so a test
+ * can read the models at an exact time.
+ *
+ * The firmware main function is compiled as APP_Main. The
+ * simulator parses its own options, starts the peripheral
+ * models and calls it.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <sim.h>
+#include <recorder.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/**
+ * @addtogroup SIM
+ * @{
+ */
+
+#define SIM_IRQ_OFFSET    16    ///< Number of system exceptions before IRQ0
+#define SIM_IRQ_COUNT     (SIM_IRQ_OFFSET + 82) ///< Number of exception numbers
+#define SIM_THREAD_PRIO   256   ///< Execution priority of thread mode (lower than any interrupt)
+#define SIM_IDLE_POLLS    1000  ///< Polls without activity before the simulator sleeps
+#define SIM_MAX_SLEEP     SIM_MS(1) ///< Longest sleep of the simulator
+#define SIM_LINE_LEN      256   ///< Maximum length of a script line
+#define SIM_POLL_COST     100   ///< Virtual time of a poll point in virtual mode (ns)
+#define SIM_IDLE_JUMP     4     ///< Idle polls before the virtual clock jumps to the next event
+#define SIM_WATCHDOG      2     ///< Real seconds without a poll point before the watchdog stops the simulation
+#define SIM_MANUAL_STALL  1000000 ///< Idle polls in manual time taken as a wait which never ends
+
+int APP_Main(void);
+
+/**
+ * @brief Vector table entry with NVIC state.
+ */
+typedef struct {
+  void (*handler)(void);  ///< Interrupt handler
+  uint8_t enabled;        ///< Enable bit
+  uint8_t pending;        ///< Pending bit
+  uint8_t priority;       ///< Priority (0 - highest)
+} SIM_Irq_TypeDef;
+
+SIM_Options_TypeDef simOptions = {
+    .speed = 1.0,
+    .heading = 0.0,
+    .rotation = 6.0,
+};
+
+uint32_t SystemCoreClock = 168000000; ///< Core clock of the simulated board
+
+static SIM_Irq_TypeDef simIrq[SIM_IRQ_COUNT]; ///< Exceptions and interrupts
+static uint16_t simPriority = SIM_THREAD_PRIO; ///< Current execution priority
+static uint8_t simPendingCount;       ///< Number of pending interrupts
+static uint8_t simPrimask;            ///< Interrupts masked (PRIMASK)
+static uint32_t simBasepri;           ///< Priority mask (BASEPRI, 0 - none)
+
+static SIM_Event_TypeDef* simEvents;  ///< List of registered events
+static uint64_t simTime;              ///< Current virtual time (ns)
+static uint64_t simRealStart;         ///< Real time of start (ns)
+static uint8_t simInEvent;            ///< Nonzero while an event handler runs
+static uint32_t simIdlePolls;         ///< Polls without any event or interrupt
+static volatile uint32_t simPolls;    ///< Number of poll points (for the watchdog)
+static volatile sig_atomic_t simStop; ///< Set by signal handlers
+
+static FILE* simScript;               ///< Script file (NULL - no script)
+static uint64_t simScriptTime;        ///< Time of the last script line
+static char simScriptLine[SIM_LINE_LEN]; ///< Next script command
+static uint32_t simScriptLineNo;      ///< Number of the script line
+
+static uint64_t SIM_RealTime(void);
+static void SIM_Run(uint64_t target);
+static uint8_t SIM_RunIrqs(void);
+static uint8_t SIM_IrqWaiting(void);
+static SIM_Event_TypeDef* SIM_NextEvent(void);
+static void SIM_Idle(void);
+static void SIM_ScriptRead(void);
+static void SIM_ScriptRun(void);
+static void SIM_ScriptCommand(char* line);
+static void SIM_StopHandler(void);
+static void SIM_Signal(int sig);
+static void SIM_Watchdog(int sig);
+static uint8_t SIM_LoadRecording(const char* path);
+static void SIM_Usage(const char* name);
+
+static SIM_Event_TypeDef scriptEvent = SIM_EVENT("script", SIM_ScriptRun);
+static SIM_Event_TypeDef stopEvent = SIM_EVENT("stop", SIM_StopHandler);
+
+/**
+ * @brief Current virtual time.
+ * @details This is a poll point - due events and pending
+ * interrupts are handled before returning.
+ * @return Time in nanoseconds
+ */
+uint64_t SIM_Now(void) {
+
+  SIM_Poll();
+  return simTime;
+}
+/**
+ * @brief Current virtual time for measurements.
+ * @details Like SIM_Now, but the read does not count as
+ * an idle poll. Code reading the cycle counter around a region
+ * is not waiting, so the clock must not skip to the next event
+ * (e.g. in an interrupt handler, where the next byte would
+ * overrun the one being handled).
+ * @return Time in nanoseconds
+ */
+uint64_t SIM_Clock(void) {
+
+  uint32_t idlePolls = simIdlePolls;
+
+  SIM_Poll();
+
+  if (simIdlePolls > idlePolls) { // nothing happened - not a wait
+    simIdlePolls = idlePolls;
+  }
+  return simTime;
+}
+/**
+ * @brief Dispatch due events and run pending interrupts.
+ * @details Does nothing when called from an event handler
+ * (hardware events are instantaneous).
+ */
+void SIM_Poll(void) {
+
+  if (simInEvent) {
+    return;
+  }
+
+  simPolls++;
+
+  if (!simOptions.virtualTime) {
+    SIM_Run((uint64_t)((SIM_RealTime() - simRealStart) * simOptions.speed));
+    return;
+  }
+
+  if (simOptions.manualTime) {
+
+    if (simIdlePolls >= SIM_MANUAL_STALL) {
+      fprintf(stderr, "SIM--> Busy wait in manual time\n");
+      SIM_Exit(1);
+    }
+    SIM_Run(simTime); // only what is due now
+    return;
+  }
+
+  uint64_t target = simTime + SIM_POLL_COST;
+
+  if (simIdlePolls >= SIM_IDLE_JUMP) {
+
+    // firmware is waiting - skip to the next event
+    SIM_Event_TypeDef* ev = SIM_NextEvent();
+
+    if (ev == NULL) {
+      fprintf(stderr, "SIM--> Busy wait with no events scheduled\n");
+      SIM_Exit(1);
+    }
+    if (ev->due > target) {
+      target = ev->due;
+    }
+  }
+
+  SIM_Run(target);
+}
+/**
+ * @brief Let a given time pass.
+ * @details Events and interrupts are handled as they become
+ * due. In virtual mode time advances right away, otherwise
+ * this waits in a poll loop.
+ * @param ns Time in nanoseconds
+ */
+void SIM_Advance(uint64_t ns) {
+
+  uint64_t end = SIM_Now() + ns;
+
+  if (simOptions.virtualTime && !simInEvent) {
+    SIM_Run(end);
+  }
+
+  while (SIM_Now() < end);
+}
+/**
+ * @brief Move the clock to the target time.
+ * @details Dispatches events due up to the target and runs
+ * the pending interrupts.
+ * @param target New virtual time (ns)
+ */
+static void SIM_Run(uint64_t target) {
+
+  uint8_t busy = 0;
+  SIM_Event_TypeDef* ev;
+
+  while ((ev = SIM_NextEvent()) != NULL && ev->due <= target) {
+
+    if (ev->due > simTime) {
+      simTime = ev->due;
+    }
+    ev->active = 0;
+    simIdlePolls = 0; // handlers run by a jump start counting anew
+
+    simInEvent = 1;
+    ev->handler();
+    simInEvent = 0;
+    busy = 1;
+
+    // interrupts triggered by the event run before the next event
+    SIM_RunIrqs();
+  }
+
+  if (target > simTime) {
+    simTime = target;
+  }
+
+  busy |= SIM_RunIrqs();
+
+  if (simStop) {
+    SIM_Exit(simStop == 2 ? 0 : 1);
+  }
+
+  if (busy) {
+    simIdlePolls = 0;
+  } else if (simOptions.virtualTime) {
+    simIdlePolls++; // SIM_Poll jumps to the next event
+  } else if (++simIdlePolls >= SIM_IDLE_POLLS) {
+    simIdlePolls = 0;
+    SIM_Idle();
+  }
+}
+/**
+ * @brief Schedule an event.
+ * @details The event is registered on first use. An already
+ * scheduled event is moved to the new time.
+ * @param ev Event
+ * @param due Time of the event (not earlier than now)
+ */
+void SIM_Schedule(SIM_Event_TypeDef* ev, uint64_t due) {
+
+  // register at the end - keeps order of simultaneous events
+  SIM_Event_TypeDef** last = &simEvents;
+  while (*last && *last != ev) {
+    last = &(*last)->next;
+  }
+  *last = ev;
+
+  ev->due = (due < simTime) ? simTime : due;
+  ev->active = 1;
+}
+/**
+ * @brief Cancel a scheduled event.
+ * @param ev Event
+ */
+void SIM_Cancel(SIM_Event_TypeDef* ev) {
+  ev->active = 0;
+}
+/**
+ * @brief Set the handler of an interrupt (vector table entry).
+ * @param irq Interrupt number
+ * @param handler Interrupt handler
+ */
+void SIM_IrqHandler(IRQn_Type irq, void (*handler)(void)) {
+
+  simIrq[irq + SIM_IRQ_OFFSET].handler = handler;
+
+  if (irq < 0) {
+    simIrq[irq + SIM_IRQ_OFFSET].enabled = 1; // system exceptions are always enabled
+  }
+}
+/**
+ * @brief Stop the simulation.
+ * @details Prints the final state of the models and restores
+ * the terminal.
+ * @param code Exit code of the process
+ */
+void SIM_Exit(int code) {
+
+  static uint8_t exiting;
+
+  if (exiting) {
+    return;
+  }
+  exiting = 1;
+
+  SIM_UartStop();
+
+  if (!simOptions.quiet) {
+    SIM_LcdRender();
+  }
+  fprintf(stderr, "SIM--> Stopped at %llu.%03llu s\n",
+      (unsigned long long)(simTime / SIM_MS(1000)),
+      (unsigned long long)(simTime / SIM_MS(1) % 1000));
+  SIM_LcdReport();
+
+  fflush(stdout);
+  exit(code);
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+
+  simIrq[irq + SIM_IRQ_OFFSET].enabled = 1;
+  SIM_RunIrqs(); // pending interrupt is taken right away
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+  simIrq[irq + SIM_IRQ_OFFSET].enabled = 0;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq) {
+
+  if (!simIrq[irq + SIM_IRQ_OFFSET].pending) {
+    simIrq[irq + SIM_IRQ_OFFSET].pending = 1;
+    simPendingCount++;
+  }
+  SIM_RunIrqs();
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+  simIrq[irq + SIM_IRQ_OFFSET].priority = priority & ((1 << __NVIC_PRIO_BITS) - 1);
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq) {
+  return simIrq[irq + SIM_IRQ_OFFSET].priority;
+}
+
+void __disable_irq(void) {
+  simPrimask = 1;
+}
+
+void __enable_irq(void) {
+
+  simPrimask = 0;
+  SIM_RunIrqs(); // pending interrupt is taken right away
+}
+
+uint32_t __get_PRIMASK(void) {
+  return simPrimask;
+}
+
+void __set_PRIMASK(uint32_t value) {
+
+  simPrimask = value & 1;
+  if (!simPrimask) {
+    SIM_RunIrqs(); // pending interrupt is taken right away
+  }
+}
+
+uint32_t __get_BASEPRI(void) {
+  return simBasepri;
+}
+
+void __set_BASEPRI(uint32_t value) {
+
+  simBasepri = value & 0xff;
+  SIM_RunIrqs(); // interrupts unmasked by a lower value are taken right away
+}
+void __WFI(void) {
+
+  // a pending interrupt wakes the core also with PRIMASK set
+  while (!SIM_IrqWaiting()) {
+    SIM_Poll();
+  }
+}
+/**
+ * @brief Check for an interrupt which would wake the core.
+ * @return Nonzero if an enabled interrupt with priority over the
+ * current one (and BASEPRI) is pending, regardless of PRIMASK
+ */
+static uint8_t SIM_IrqWaiting(void) {
+
+  uint16_t limit = simPriority;
+  uint16_t i;
+
+  if (simBasepri && (simBasepri >> (8 - __NVIC_PRIO_BITS)) < limit) {
+    limit = simBasepri >> (8 - __NVIC_PRIO_BITS);
+  }
+
+  for (i = 0; i < SIM_IRQ_COUNT; i++) {
+    if (simIrq[i].pending && simIrq[i].enabled && simIrq[i].handler &&
+        simIrq[i].priority < limit) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/**
+ * @brief Run pending interrupts which can preempt the current code.
+ * @details Highest priority first, lower exception number first
+ * if priorities are equal. Interrupts run nested - an interrupt
+ * handler which polls can be preempted by a higher priority one.
+ * @return Nonzero if any interrupt ran
+ */
+static uint8_t SIM_RunIrqs(void) {
+
+  uint8_t ran = 0;
+
+  if (simInEvent || simPrimask) {
+    return 0;
+  }
+
+  while (simPendingCount) {
+
+    int16_t best = -1;
+    uint16_t bestPriority = simPriority;
+    uint16_t i;
+
+    // BASEPRI holds the priority in its upper bits
+    if (simBasepri && (simBasepri >> (8 - __NVIC_PRIO_BITS)) < bestPriority) {
+      bestPriority = simBasepri >> (8 - __NVIC_PRIO_BITS);
+    }
+
+    for (i = 0; i < SIM_IRQ_COUNT; i++) {
+      if (simIrq[i].pending && simIrq[i].enabled && simIrq[i].handler &&
+          simIrq[i].priority < bestPriority) {
+        best = i;
+        bestPriority = simIrq[i].priority;
+      }
+    }
+
+    if (best < 0) {
+      break;
+    }
+
+    uint16_t saved = simPriority;
+    simIrq[best].pending = 0;
+    simPendingCount--;
+    simPriority = bestPriority;
+    simIdlePolls = 0;
+    simIrq[best].handler();
+    simPriority = saved;
+    ran = 1;
+  }
+
+  return ran;
+}
+/**
+ * @brief Find the next scheduled event.
+ * @return Event with the earliest time (NULL if none)
+ */
+static SIM_Event_TypeDef* SIM_NextEvent(void) {
+
+  SIM_Event_TypeDef* ev;
+  SIM_Event_TypeDef* next = NULL;
+
+  for (ev = simEvents; ev; ev = ev->next) {
+    if (ev->active && (next == NULL || ev->due < next->due)) {
+      next = ev;
+    }
+  }
+  return next;
+}
+/**
+ * @brief Sleep until the next event.
+ * @details Called when the firmware keeps polling and nothing
+ * happens, so that waiting in the main loop doesn't use a whole
+ * CPU core.
+ */
+static void SIM_Idle(void) {
+
+  SIM_Event_TypeDef* ev = SIM_NextEvent();
+  uint64_t wait = SIM_MAX_SLEEP;
+
+  if (ev && ev->due > simTime && ev->due - simTime < wait) {
+    wait = ev->due - simTime;
+  }
+
+  uint64_t real = (uint64_t)(wait / simOptions.speed);
+  if (real > SIM_MAX_SLEEP) {
+    real = SIM_MAX_SLEEP;
+  }
+
+  struct timespec ts = {0, (long)real};
+  nanosleep(&ts, NULL);
+}
+/**
+ * @brief Real monotonic time.
+ * @return Time in nanoseconds
+ */
+static uint64_t SIM_RealTime(void) {
+
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * SIM_MS(1000) + ts.tv_nsec;
+}
+/**
+ * @brief Read the next command from the script and schedule it.
+ * @details Lines are "<time in ms> <command> [arguments]", where
+ * the time is counted from start, or from the previous command
+ * when preceded by "+". Empty lines and lines starting with #
+ * are skipped.
+ */
+static void SIM_ScriptRead(void) {
+
+  char line[SIM_LINE_LEN];
+
+  while (fgets(line, sizeof(line), simScript)) {
+
+    simScriptLineNo++;
+    line[strcspn(line, "\r\n")] = 0;
+
+    char* p = line + strspn(line, " \t");
+    if (*p == 0 || *p == '#') {
+      continue;
+    }
+
+    uint8_t relative = 0;
+    if (*p == '+') {
+      relative = 1;
+      p++;
+    }
+
+    char* end;
+    double ms = strtod(p, &end);
+    if (end == p) {
+      fprintf(stderr, "SIM--> Script line %u: missing time\n", simScriptLineNo);
+      continue;
+    }
+
+    uint64_t t = (uint64_t)(ms * SIM_NS_PER_MS);
+    simScriptTime = relative ? simScriptTime + t : t;
+
+    strncpy(simScriptLine, end + strspn(end, " \t"), sizeof(simScriptLine) - 1);
+    SIM_Schedule(&scriptEvent, simScriptTime);
+    return;
+  }
+
+  fclose(simScript);
+  simScript = NULL;
+}
+/**
+ * @brief Script event - run the command and schedule the next one.
+ */
+static void SIM_ScriptRun(void) {
+
+  SIM_ScriptCommand(simScriptLine);
+
+  if (simScript) {
+    SIM_ScriptRead();
+  }
+}
+/**
+ * @brief Execute one script command.
+ * @details Commands:
+ * - rx TEXT - send TEXT and the frame terminator to the UART
+ * - rxn N TEXT - send TEXT N times without the terminator (long lines)
+ * - key N down|up - press or release key N (KEYS_INDEX)
+ * - heading DEG [DEG/S] - set compass heading and rotation speed
+ * - quit - stop the simulation
+ * @param line Command with arguments
+ */
+static void SIM_ScriptCommand(char* line) {
+
+  char* cmd = strtok(line, " \t");
+  char* arg = strtok(NULL, "");
+
+  if (cmd == NULL) {
+    return;
+  }
+
+  if (!strcmp(cmd, "rx")) {
+
+    SIM_UartInject(arg ? arg : "");
+    SIM_UartInject("\r");
+
+  } else if (!strcmp(cmd, "rxn") && arg) {
+
+    unsigned int count;
+    int text;
+    if (sscanf(arg, "%u %n", &count, &text) == 1 && arg[text]) {
+      while (count--) {
+        SIM_UartInject(arg + text);
+      }
+      return;
+    }
+    fprintf(stderr, "SIM--> Script line %u: rxn N TEXT\n", simScriptLineNo);
+
+  } else if (!strcmp(cmd, "key") && arg) {
+
+    char state[8] = "";
+    unsigned int key;
+    if (sscanf(arg, "%u %7s", &key, state) == 2 &&
+        (!strcmp(state, "down") || !strcmp(state, "up"))) {
+      SIM_KeysSet(key, !strcmp(state, "down"));
+      return;
+    }
+    fprintf(stderr, "SIM--> Script line %u: key N down|up\n", simScriptLineNo);
+
+  } else if (!strcmp(cmd, "heading") && arg) {
+
+    double heading, rotation = 0.0;
+    if (sscanf(arg, "%lf %lf", &heading, &rotation) >= 1) {
+      SIM_MagSetHeading(heading, rotation);
+      return;
+    }
+    fprintf(stderr, "SIM--> Script line %u: heading DEG [DEG/S]\n", simScriptLineNo);
+
+  } else if (!strcmp(cmd, "quit")) {
+
+    simStop = 2;
+
+  } else {
+
+    fprintf(stderr, "SIM--> Script line %u: unknown command %s\n",
+        simScriptLineNo, cmd);
+  }
+}
+/**
+ * @brief End of simulation time (--duration).
+ */
+static void SIM_StopHandler(void) {
+  simStop = 2;
+}
+/**
+ * @brief Interrupted by user - exit at the next poll point.
+ */
+static void SIM_Signal(int sig) {
+  simStop = 1;
+}
+/**
+ * @brief Check that the firmware reaches poll points.
+ * @details Runs every second of real time in virtual mode.
+ * A firmware spinning without reading the time or a peripheral
+ * would never let the virtual clock advance, so it is stopped.
+ */
+static void SIM_Watchdog(int sig) {
+
+  static uint32_t lastPolls;
+  static uint8_t stuck;
+
+  if (simPolls != lastPolls) {
+    lastPolls = simPolls;
+    stuck = 0;
+    return;
+  }
+
+  if (++stuck >= SIM_WATCHDOG) {
+    static const char msg[] = "SIM--> Firmware stopped polling (loop without a time source?)\n";
+    if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0) {
+      // nothing more to do
+    }
+    SIM_UartStop(); // restore the terminal
+    _exit(3);
+  }
+}
+
+/**
+ * @brief Load a recording into the buffer of the sample recorder.
+ * @param path Recording file
+ * @retval 0 Loaded
+ * @retval 1 Error
+ */
+static uint8_t SIM_LoadRecording(const char* path) {
+
+  static uint8_t data[REC_BUF_LEN + 1];
+
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    return 1;
+  }
+  size_t len = fread(data, 1, sizeof(data), f);
+  fclose(f);
+
+  uint32_t loaded = REC_Load(data, len);
+  if (loaded < len) {
+    fprintf(stderr, "SIM--> Recording truncated to %u bytes\n", loaded);
+  }
+  return 0;
+}
+
+static void SIM_Usage(const char* name) {
+
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  -s, --speed X       run X times faster than real time (default 1)\n"
+      "  -d, --duration MS   stop after MS milliseconds of virtual time\n"
+      "  -V, --virtual       deterministic virtual time, as fast as possible\n"
+      "  -f, --script FILE   run commands from FILE (see sim.c)\n"
+      "  -H, --heading DEG   initial compass heading (default 0)\n"
+      "  -r, --rotate DEG/S  compass rotation speed (default 6)\n"
+      "  -p, --pty           UART on a pseudo terminal\n"
+      "  -o, --record FILE   save samples recorded over COMM (:REC COMM)\n"
+      "  -i, --replay FILE   load a recording for :REC PLAY\n"
+      "  -R, --raw           don't decode log frames\n"
+      "  -q, --quiet         don't render the LCD and LEDs\n",
+      name);
+}
+/**
+ * @brief Start the simulator and run the firmware.
+ */
+int main(int argc, char** argv) {
+
+  static const struct option options[] = {
+      {"speed",    required_argument, NULL, 's'},
+      {"duration", required_argument, NULL, 'd'},
+      {"virtual",  no_argument,       NULL, 'V'},
+      {"script",   required_argument, NULL, 'f'},
+      {"heading",  required_argument, NULL, 'H'},
+      {"rotate",   required_argument, NULL, 'r'},
+      {"pty",      no_argument,       NULL, 'p'},
+      {"record",   required_argument, NULL, 'o'},
+      {"replay",   required_argument, NULL, 'i'},
+      {"raw",      no_argument,       NULL, 'R'},
+      {"quiet",    no_argument,       NULL, 'q'},
+      {"help",     no_argument,       NULL, 'h'},
+      {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  const char* script = NULL;
+  const char* replay = NULL;
+
+  while ((opt = getopt_long(argc, argv, "s:d:Vf:H:r:po:i:Rqh", options, NULL)) != -1) {
+    switch (opt) {
+    case 's':
+      simOptions.speed = atof(optarg);
+      break;
+    case 'd':
+      simOptions.duration = (uint64_t)(atof(optarg) * SIM_NS_PER_MS);
+      break;
+    case 'V':
+      simOptions.virtualTime = 1;
+      break;
+    case 'f':
+      script = optarg;
+      break;
+    case 'H':
+      simOptions.heading = atof(optarg);
+      break;
+    case 'r':
+      simOptions.rotation = atof(optarg);
+      break;
+    case 'p':
+      simOptions.pty = 1;
+      break;
+    case 'o':
+      simOptions.record = optarg;
+      break;
+    case 'i':
+      replay = optarg;
+      break;
+    case 'R':
+      simOptions.raw = 1;
+      break;
+    case 'q':
+      simOptions.quiet = 1;
+      break;
+    default:
+      SIM_Usage(argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (simOptions.speed <= 0.0) {
+    fprintf(stderr, "SIM--> Speed has to be positive\n");
+    return 2;
+  }
+
+  simRealStart = SIM_RealTime();
+
+  if (script) {
+    simScript = fopen(script, "r");
+    if (simScript == NULL) {
+      perror(script);
+      return 2;
+    }
+    SIM_ScriptRead();
+  }
+
+  if (replay && SIM_LoadRecording(replay)) {
+    return 2;
+  }
+
+  if (simOptions.duration) {
+    SIM_Schedule(&stopEvent, simOptions.duration);
+  }
+
+  signal(SIGINT, SIM_Signal);
+  signal(SIGTERM, SIM_Signal);
+
+  if (simOptions.virtualTime) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIM_Watchdog;
+    sa.sa_flags = SA_RESTART; // don't break UART reads
+    sigaction(SIGALRM, &sa, NULL);
+
+    struct itimerval period = {{1, 0}, {1, 0}};
+    setitimer(ITIMER_REAL, &period, NULL);
+  }
+
+  SIM_MagSetHeading(simOptions.heading, simOptions.rotation);
+  SIM_UartStart();
+
+  return APP_Main();
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,91 @@
+/**
+ * @file:   systick.c
+ * @brief:  Managing the SysTick (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details SysTick is a periodic event of the simulator. Its
+ * interrupt has the highest priority, like on the board, so
+ * system time runs also during long interrupt handlers.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <systick.h>
+#include <sim.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <irq.h>
+#include <dwt.h>
+
+/**
+ * @addtogroup SYSTICK
+ * @{
+ */
+
+static volatile uint32_t sysTicks;  ///< Delay timer.
+static uint64_t sysTickPeriod;      ///< Period of SysTick in ns
+static uint32_t sysTickRaised;      ///< Cycle counter at the last reload
+
+static void SYSTICK_Event(void);
+void SysTick_Handler(void);
+
+static SIM_Event_TypeDef sysTickEvent = SIM_EVENT("SysTick", SYSTICK_Event);
+
+/**
+ * @brief Initialize the SysTick with a given frequency
+ * @param freq SysTick frequency
+ */
+void SYSTICK_Init(uint32_t freq) {
+
+  sysTickPeriod = SIM_MS(1000) / freq;
+
+  SIM_IrqHandler(SysTick_IRQn, SysTick_Handler);
+  NVIC_SetPriority(SysTick_IRQn, IRQ_PRIO_SYSTICK);
+
+  SIM_Schedule(&sysTickEvent, SIM_Now() + sysTickPeriod);
+}
+/**
+ * @brief Get the system time
+ * @return System time.
+ */
+uint32_t SYSTICK_GetTime(void) {
+
+  SIM_Poll();
+  return sysTicks;
+}
+/**
+ * @brief Counter reload - SysTick exception becomes pending.
+ */
+static void SYSTICK_Event(void) {
+
+  SIM_Schedule(&sysTickEvent, sysTickEvent.due + sysTickPeriod);
+  sysTickRaised = DWT_GetCycles();
+  NVIC_SetPendingIRQ(SysTick_IRQn);
+}
+/**
+ * @brief Interrupt handler for SysTick.
+ */
+void SysTick_Handler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_SYSTICK);
+  IRQSTAT_LATENCY(IRQSTAT_SYSTICK, DWT_GetCycles() - sysTickRaised);
+  TRACE_BEGIN(TRACE_SYSTICK, 0);
+
+  sysTicks++; // Update system time
+
+  TRACE_END(TRACE_SYSTICK, 0);
+  IRQSTAT_EXIT(IRQSTAT_SYSTICK);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,97 @@
+/**
+ * @file:   tim2.c
+ * @brief:  Periodic update interrupts from TIM2 (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The update event repeats with the period set in
+ * TIM2_Init while the counter is enabled.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim2.h>
+#include <sim.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <dwt.h>
+
+/**
+ * @addtogroup TIM2
+ * @{
+ */
+
+static void (*updateCallback)(void); ///< Callback function for update event
+static uint64_t tim2Period;          ///< Update period in ns
+static uint32_t tim2Raised;          ///< Cycle counter at the last update
+
+static void TIM2_Event(void);
+void TIM2_IRQHandler(void);
+
+static SIM_Event_TypeDef tim2Event = SIM_EVENT("TIM2", TIM2_Event);
+
+/**
+ * @brief Initialize TIM2 update interrupts.
+ * @param freq Frequency of the update event in Hz
+ * @param updateCb Function called on every update event
+ */
+void TIM2_Init(uint32_t freq, void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  // period is a whole number of 1MHz counter ticks
+  tim2Period = SIM_US(1000000 / freq);
+
+  SIM_IrqHandler(TIM2_IRQn, TIM2_IRQHandler);
+  NVIC_SetPriority(TIM2_IRQn, IRQ_PRIO_TIM2);
+  NVIC_EnableIRQ(TIM2_IRQn);
+}
+/**
+ * @brief Start the timer.
+ */
+void TIM2_Start(void) {
+  SIM_Schedule(&tim2Event, SIM_Now() + tim2Period);
+}
+/**
+ * @brief Stop the timer.
+ */
+void TIM2_Stop(void) {
+  SIM_Cancel(&tim2Event);
+}
+/**
+ * @brief Counter overflow.
+ */
+static void TIM2_Event(void) {
+
+  SIM_Schedule(&tim2Event, tim2Event.due + tim2Period);
+  tim2Raised = DWT_GetCycles();
+  NVIC_SetPendingIRQ(TIM2_IRQn);
+}
+/**
+ * @brief TIM2 interrupt handler.
+ */
+void TIM2_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM2);
+  IRQSTAT_LATENCY(IRQSTAT_TIM2, DWT_GetCycles() - tim2Raised);
+  TRACE_BEGIN(TRACE_TIM2, 0);
+
+  if (updateCallback) { // if not NULL
+    updateCallback();
+  }
+
+  TRACE_END(TRACE_TIM2, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM2);
+}
+
+/**
+ * @}
+ */
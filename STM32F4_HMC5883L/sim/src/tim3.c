@@ -0,0 +1,91 @@
+/**
+ * @file:   tim3.c
+ * @brief:  One-shot delay interrupts from TIM3 (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Every call to TIM3_Schedule generates a single
+ * update interrupt after the given delay. Scheduling again
+ * before the delay passes restarts the delay.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim3.h>
+#include <sim.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <dwt.h>
+
+/**
+ * @addtogroup TIM3
+ * @{
+ */
+
+static void (*updateCallback)(void); ///< Callback function for update event
+static uint32_t tim3Raised;          ///< Cycle counter at the last update
+
+static void TIM3_Event(void);
+void TIM3_IRQHandler(void);
+
+static SIM_Event_TypeDef tim3Event = SIM_EVENT("TIM3", TIM3_Event);
+
+/**
+ * @brief Initialize TIM3 in one pulse mode.
+ * @param updateCb Function called when a scheduled delay passes
+ */
+void TIM3_Init(void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  SIM_IrqHandler(TIM3_IRQn, TIM3_IRQHandler);
+  NVIC_SetPriority(TIM3_IRQn, IRQ_PRIO_TIM3);
+  NVIC_EnableIRQ(TIM3_IRQn);
+}
+/**
+ * @brief Generate an update interrupt after given time.
+ * @param delayUs Delay in microseconds (2 - TIM3_MAX_DELAY)
+ */
+void TIM3_Schedule(uint16_t delayUs) {
+
+  if (delayUs < 2) {
+    delayUs = 2; // same limit as the hardware
+  }
+  SIM_Schedule(&tim3Event, SIM_Now() + SIM_US(delayUs));
+}
+/**
+ * @brief Delay passed - counter stops, update interrupt pending.
+ */
+static void TIM3_Event(void) {
+  tim3Raised = DWT_GetCycles();
+  NVIC_SetPendingIRQ(TIM3_IRQn);
+}
+/**
+ * @brief TIM3 interrupt handler.
+ */
+void TIM3_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM3);
+  // the real counter stops at zero, the model knows the time
+  IRQSTAT_LATENCY(IRQSTAT_TIM3, DWT_GetCycles() - tim3Raised);
+  TRACE_BEGIN(TRACE_TIM3, 0);
+
+  if (updateCallback) { // if not NULL
+    updateCallback();
+  }
+
+  TRACE_END(TRACE_TIM3, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM3);
+}
+
+/**
+ * @}
+ */
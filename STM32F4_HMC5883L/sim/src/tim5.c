@@ -0,0 +1,108 @@
+/**
+ * @file:   tim5.c
+ * @brief:  PC sampling interrupt from TIM5 (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details There is no simulated CPU to sample, so the
+ * samples come from the host: a SIGPROF timer interrupts
+ * the simulator process every period of its CPU time and
+ * the host program counter is passed to the callback. The
+ * simulator is linked without PIE, so addresses fit in
+ * 32 bits and tools/pcprof.py maps them with the symbols
+ * of build/sim.
+ *
+ * Unlike the other models this interrupt is asynchronous -
+ * it is not delivered at poll points and it is not masked
+ * by __disable_irq.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#define _GNU_SOURCE
+
+#include <tim5.h>
+#include <sim.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+/**
+ * @addtogroup TIM5
+ * @{
+ */
+
+static void (*sampleCallback)(uint32_t pc); ///< Callback function for samples
+static struct itimerval tim5Period;         ///< Sampling period (CPU time)
+
+static void TIM5_Signal(int sig, siginfo_t* info, void* context);
+
+/**
+ * @brief Initialize TIM5 sampling interrupt.
+ * @param freq Sampling frequency in Hz
+ * @param sampleCb Function called with the interrupted PC
+ */
+void TIM5_Init(uint32_t freq, void (*sampleCb)(uint32_t pc)) {
+
+  sampleCallback = sampleCb;
+
+  tim5Period.it_interval.tv_usec = 1000000 / freq;
+  tim5Period.it_value = tim5Period.it_interval;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = TIM5_Signal;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART; // don't break UART reads
+  sigaction(SIGPROF, &sa, NULL);
+}
+/**
+ * @brief Start sampling.
+ */
+void TIM5_Start(void) {
+  setitimer(ITIMER_PROF, &tim5Period, NULL);
+}
+/**
+ * @brief Stop sampling.
+ */
+void TIM5_Stop(void) {
+
+  struct itimerval off;
+  memset(&off, 0, sizeof(off));
+  setitimer(ITIMER_PROF, &off, NULL);
+}
+/**
+ * @brief Pass the interrupted host PC to the callback.
+ * @param sig Signal number
+ * @param info Signal information
+ * @param context Interrupted machine state (ucontext_t)
+ */
+static void TIM5_Signal(int sig, siginfo_t* info, void* context) {
+
+  ucontext_t* uc = context;
+  uint32_t pc = 0;
+
+#if defined(__x86_64__)
+  pc = uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+  pc = uc->uc_mcontext.pc;
+#else
+  (void)uc; // unknown host - all samples at address 0
+#endif
+
+  if (sampleCallback) { // if not NULL
+    sampleCallback(pc);
+  }
+}
+
+/**
+ * @}
+ */
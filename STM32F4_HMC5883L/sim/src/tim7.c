@@ -0,0 +1,97 @@
+/**
+ * @file:   tim7.c
+ * @brief:  Periodic update interrupts from TIM7 (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The update event repeats with the period set in
+ * TIM7_Init while the counter is enabled.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tim7.h>
+#include <sim.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <dwt.h>
+
+/**
+ * @addtogroup TIM7
+ * @{
+ */
+
+static void (*updateCallback)(void); ///< Callback function for update event
+static uint64_t tim7Period;          ///< Update period in ns
+static uint32_t tim7Raised;          ///< Cycle counter at the last update
+
+static void TIM7_Event(void);
+void TIM7_IRQHandler(void);
+
+static SIM_Event_TypeDef tim7Event = SIM_EVENT("TIM7", TIM7_Event);
+
+/**
+ * @brief Initialize TIM7 update interrupts.
+ * @param freq Frequency of the update event in Hz
+ * @param updateCb Function called on every update event
+ */
+void TIM7_Init(uint32_t freq, void (*updateCb)(void)) {
+
+  updateCallback = updateCb;
+
+  // period is a whole number of 1MHz counter ticks
+  tim7Period = SIM_US(1000000 / freq);
+
+  SIM_IrqHandler(TIM7_IRQn, TIM7_IRQHandler);
+  NVIC_SetPriority(TIM7_IRQn, IRQ_PRIO_TIM7);
+  NVIC_EnableIRQ(TIM7_IRQn);
+}
+/**
+ * @brief Start the timer.
+ */
+void TIM7_Start(void) {
+  SIM_Schedule(&tim7Event, SIM_Now() + tim7Period);
+}
+/**
+ * @brief Stop the timer.
+ */
+void TIM7_Stop(void) {
+  SIM_Cancel(&tim7Event);
+}
+/**
+ * @brief Counter overflow.
+ */
+static void TIM7_Event(void) {
+
+  SIM_Schedule(&tim7Event, tim7Event.due + tim7Period);
+  tim7Raised = DWT_GetCycles();
+  NVIC_SetPendingIRQ(TIM7_IRQn);
+}
+/**
+ * @brief TIM7 interrupt handler.
+ */
+void TIM7_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_TIM7);
+  IRQSTAT_LATENCY(IRQSTAT_TIM7, DWT_GetCycles() - tim7Raised);
+  TRACE_BEGIN(TRACE_TIM7, 0);
+
+  if (updateCallback) { // if not NULL
+    updateCallback();
+  }
+
+  TRACE_END(TRACE_TIM7, 0);
+  IRQSTAT_EXIT(IRQSTAT_TIM7);
+}
+
+/**
+ * @}
+ */
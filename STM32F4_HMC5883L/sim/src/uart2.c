@@ -0,0 +1,577 @@
+/**
+ * @file:   uart2.c
+ * @brief:  USART2 (host simulation).
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The UART is connected to stdin/stdout, or to a pseudo
+ * terminal with the --pty option. Bytes are transferred at the
+ * configured baud rate, with the same TXE/RXNE interrupt logic
+ * as the hardware (a byte received while the previous one was
+ * not read is lost and counted as an overrun).
+ *
+ * Log frames sent by the firmware are decoded like by
+ * tools/logdecode.py - the string ID is simply the address
+ * of the format string in the simulator process. Sample
+ * recorder frames are saved to the file given with --record.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#define _GNU_SOURCE
+
+#include <uart2.h>
+#include <sim.h>
+#include <log.h>
+#include <recorder.h>
+#include <trace.h>
+#include <irqstat.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @addtogroup USART2
+ * @{
+ */
+
+#define UART_INPUT_PERIOD   SIM_MS(1) ///< Period of checking for input
+#define UART_QUEUE_LEN      4096      ///< Length of the input queue (power of 2)
+#define UART_LOG_SYNC1      0xa5      ///< First log frame sync byte
+#define UART_LOG_SYNC2      0x5a      ///< Second log frame sync byte
+#define UART_LOG_MAX        (8 + 4 * 4) ///< Maximum log frame payload
+#define UART_FMT_LEN        32        ///< Maximum length of a conversion
+
+void    (*rxCallback)(uint8_t);   ///< Callback function for receiving data
+uint8_t (*txCallback)(uint8_t*);  ///< Callback function for transmitting data
+
+static uint64_t uartByteTime;     ///< Time of one character on the line
+static uint8_t  uartRdr;          ///< Receive data register
+static uint8_t  uartRxne;         ///< Receive data register not empty
+static uint8_t  uartTxe = 1;      ///< Transmit data register empty
+static uint8_t  uartTxeie;        ///< TXE interrupt enable
+static uint8_t  uartTdr;          ///< Byte being transmitted
+static uint32_t uartOverruns;     ///< Number of lost received bytes
+
+static int uartIn = -1;           ///< Input file descriptor
+static int uartOut = -1;          ///< Output file descriptor
+static int uartSlave = -1;        ///< Pseudo terminal slave (kept open)
+static uint8_t uartTermSaved;     ///< Nonzero when terminal settings have to be restored
+static struct termios uartTerm;   ///< Original terminal settings
+
+static uint8_t uartQueue[UART_QUEUE_LEN]; ///< Bytes waiting to be received
+static uint32_t uartQueueHead;
+static uint32_t uartQueueTail;
+
+static uint8_t uartFrame[4 + UART_LOG_MAX]; ///< Log frame being received
+static uint8_t uartFrameLen;                ///< Number of bytes in uartFrame
+static char uartLine[256];                  ///< Decoded log message
+static uint16_t uartLineLen;                ///< Length of uartLine
+static FILE* uartRecord;                    ///< Recorder output file (NULL - none)
+
+static void UART2_InputEvent(void);
+static void UART2_RxEvent(void);
+static void UART2_TxEvent(void);
+static void UART2_UpdateIrq(void);
+static void UART2_Output(uint8_t c);
+static void UART2_Decode(uint8_t c);
+static void UART2_PrintFrame(void);
+static void UART2_PrintRecord(const uint32_t* words);
+static void UART2_PrintTrace(const uint32_t* words);
+static void UART2_PrintSamples(const uint32_t* words, uint8_t n);
+static void UART2_Format(const char* fmt, const uint32_t* args, uint8_t nargs);
+static void UART2_Append(const char* fmt, ...);
+static void UART2_Write(const void* buf, size_t len);
+void USART2_IRQHandler(void);
+
+static SIM_Event_TypeDef uartInputEvent = SIM_EVENT("UART input", UART2_InputEvent);
+static SIM_Event_TypeDef uartRxEvent = SIM_EVENT("USART2 RX", UART2_RxEvent);
+static SIM_Event_TypeDef uartTxEvent = SIM_EVENT("USART2 TX", UART2_TxEvent);
+
+/**
+ * @brief Initialize USART2.
+ * @param baud Baud rate
+ * @param rxCb Callback for received bytes
+ * @param txCb Callback for bytes to transmit
+ */
+void UART2_Init(uint32_t baud, void(*rxCb)(uint8_t), uint8_t(*txCb)(uint8_t*) ) {
+
+  // assign the callbacks
+  rxCallback = rxCb;
+  txCallback = txCb;
+
+  uartByteTime = SIM_MS(1000) * 10 / baud; // 8n1 - 10 bits per byte
+
+  SIM_Schedule(&uartInputEvent, SIM_Now() + UART_INPUT_PERIOD);
+
+  SIM_IrqHandler(USART2_IRQn, USART2_IRQHandler);
+  NVIC_SetPriority(USART2_IRQn, IRQ_PRIO_USART2);
+  NVIC_EnableIRQ(USART2_IRQn);
+}
+/**
+ * @brief Enable the TXE interrupt.
+ */
+void UART2_TxEnable(void) {
+
+  uartTxeie = 1;
+  UART2_UpdateIrq();
+}
+/**
+ * @brief USART2 interrupt handler.
+ */
+void USART2_IRQHandler(void) {
+
+  IRQSTAT_ENTER(IRQSTAT_USART2);
+  TRACE_BEGIN(TRACE_USART2, 0);
+
+  // If transmit buffer empty interrupt
+  if (uartTxe && uartTxeie) {
+
+    uint8_t c;
+
+    if (txCallback) { // if not NULL
+      // get data from higher layer using callback
+      if (txCallback(&c)) {
+        uartTdr = c;
+        uartTxe = 0;
+        SIM_Schedule(&uartTxEvent, SIM_Now() + uartByteTime);
+      } else { // if no more data to send disable the transmitter
+        uartTxeie = 0;
+      }
+    }
+  }
+
+  // If RX buffer not empty interrupt
+  if (uartRxne) {
+
+    uint8_t c = uartRdr;
+    uartRxne = 0;
+    TRACE_INSTANT(TRACE_RX_BYTE, c);
+
+    if (rxCallback) { // if not NULL
+      rxCallback(c); // send received data to higher layer
+    }
+  }
+
+  UART2_UpdateIrq();
+
+  TRACE_END(TRACE_USART2, 0);
+  IRQSTAT_EXIT(IRQSTAT_USART2);
+}
+/**
+ * @brief Connect the UART to the terminal.
+ */
+void SIM_UartStart(void) {
+
+  if (simOptions.pty) {
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) {
+      perror("pty");
+      exit(2);
+    }
+
+    // keep the slave open, so the master doesn't
+    // report errors while no terminal is connected
+    uartSlave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (uartSlave >= 0) {
+      struct termios t;
+      tcgetattr(uartSlave, &t);
+      cfmakeraw(&t);
+      tcsetattr(uartSlave, TCSANOW, &t);
+    }
+
+    fprintf(stderr, "SIM--> UART on %s\n", ptsname(master));
+    uartIn = master;
+    uartOut = master;
+
+  } else {
+
+    uartIn = STDIN_FILENO;
+    uartOut = STDOUT_FILENO;
+
+    if (isatty(uartIn) && tcgetattr(uartIn, &uartTerm) == 0) {
+      // characters are sent right away, Enter gives '\r'
+      struct termios t = uartTerm;
+      t.c_lflag &= ~ICANON;
+      t.c_iflag &= ~ICRNL;
+      t.c_cc[VMIN] = 1;
+      t.c_cc[VTIME] = 0;
+      tcsetattr(uartIn, TCSANOW, &t);
+      uartTermSaved = 1;
+    }
+  }
+
+  if (simOptions.record) {
+    uartRecord = fopen(simOptions.record, "wb");
+    if (uartRecord == NULL) {
+      perror(simOptions.record);
+      exit(2);
+    }
+  }
+}
+/**
+ * @brief Restore the terminal and print UART statistics.
+ */
+void SIM_UartStop(void) {
+
+  if (uartTermSaved) {
+    tcsetattr(uartIn, TCSANOW, &uartTerm);
+    uartTermSaved = 0;
+  }
+  if (uartOverruns) {
+    fprintf(stderr, "SIM--> USART2 overruns: %u\n", uartOverruns);
+  }
+  if (uartRecord) {
+    fclose(uartRecord);
+    uartRecord = NULL;
+  }
+}
+/**
+ * @brief Queue bytes to be received by the UART.
+ * @param text Bytes to send (null terminated)
+ */
+void SIM_UartInject(const char* text) {
+
+  while (*text && uartQueueHead - uartQueueTail < UART_QUEUE_LEN) {
+    uartQueue[uartQueueHead++ & (UART_QUEUE_LEN - 1)] = *text++;
+  }
+
+  if (!uartRxEvent.active && uartQueueHead != uartQueueTail) {
+    SIM_Schedule(&uartRxEvent, SIM_Now() + uartByteTime);
+  }
+}
+/**
+ * @brief Check for input from the terminal.
+ */
+static void UART2_InputEvent(void) {
+
+  SIM_Schedule(&uartInputEvent, uartInputEvent.due + UART_INPUT_PERIOD);
+
+  if (uartIn < 0) {
+    return;
+  }
+
+  struct pollfd pfd = {uartIn, POLLIN, 0};
+  if (poll(&pfd, 1, 0) <= 0) {
+    return;
+  }
+
+  char buf[256];
+  ssize_t len = read(uartIn, buf, sizeof(buf) - 1);
+
+  if (len <= 0) {
+    if (uartIn != uartOut) {
+      uartIn = -1; // end of piped input
+    }
+    return;
+  }
+
+  ssize_t i;
+  for (i = 0; i < len; i++) {
+    if (buf[i] == '\n' && !simOptions.pty) {
+      buf[i] = '\r'; // frame terminator
+    }
+  }
+  buf[len] = 0;
+
+  SIM_UartInject(buf);
+}
+/**
+ * @brief Byte received from the line.
+ */
+static void UART2_RxEvent(void) {
+
+  uint8_t c = uartQueue[uartQueueTail++ & (UART_QUEUE_LEN - 1)];
+
+  if (uartRxne) {
+    uartOverruns++; // previous byte not read yet
+    IRQSTAT_LATE(IRQSTAT_USART2);
+  } else {
+    uartRdr = c;
+    uartRxne = 1;
+    UART2_UpdateIrq();
+  }
+
+  if (uartQueueHead != uartQueueTail) {
+    SIM_Schedule(&uartRxEvent, uartRxEvent.due + uartByteTime);
+  }
+}
+/**
+ * @brief Byte transmitted to the line.
+ */
+static void UART2_TxEvent(void) {
+
+  UART2_Output(uartTdr);
+  uartTxe = 1;
+  UART2_UpdateIrq();
+}
+/**
+ * @brief Set the interrupt pending while its conditions hold.
+ */
+static void UART2_UpdateIrq(void) {
+
+  if ((uartTxe && uartTxeie) || uartRxne) {
+    NVIC_SetPendingIRQ(USART2_IRQn);
+  }
+}
+/**
+ * @brief Write a transmitted byte to the terminal.
+ * @param c Byte
+ */
+static void UART2_Output(uint8_t c) {
+
+  if (simOptions.raw) {
+    UART2_Write(&c, 1);
+  } else {
+    UART2_Decode(c);
+  }
+}
+/**
+ * @brief Separate log frames from text.
+ * @param c Next byte of output
+ */
+static void UART2_Decode(uint8_t c) {
+
+  uartFrame[uartFrameLen++] = c;
+
+  while (uartFrameLen) {
+
+    uint8_t text = 0;
+
+    if (uartFrame[0] != UART_LOG_SYNC1) {
+      text = 1;
+    } else if (uartFrameLen >= 2 && uartFrame[1] != UART_LOG_SYNC2) {
+      text = 1;
+    } else if (uartFrameLen >= 3 && (uartFrame[2] < 8 ||
+        uartFrame[2] > UART_LOG_MAX || (uartFrame[2] - 8) % 4)) {
+      text = 1;
+    } else if (uartFrameLen >= 3 && uartFrameLen == 4 + uartFrame[2]) {
+
+      uint8_t checksum = 0;
+      uint8_t i;
+      for (i = 2; i < uartFrameLen - 1; i++) {
+        checksum ^= uartFrame[i];
+      }
+
+      if (checksum == uartFrame[uartFrameLen - 1]) {
+        UART2_PrintFrame();
+        uartFrameLen = 0;
+        break;
+      }
+      text = 1;
+    }
+
+    if (!text) {
+      break; // frame incomplete
+    }
+
+    // not a frame - first byte is text, check the rest again
+    UART2_Write(uartFrame, 1);
+    uartFrameLen--;
+    memmove(uartFrame, uartFrame + 1, uartFrameLen);
+  }
+}
+/**
+ * @brief Print a complete log frame.
+ */
+static void UART2_PrintFrame(void) {
+
+  uint32_t words[UART_LOG_MAX / 4];
+  uint8_t n = uartFrame[2] / 4;
+  uint8_t i;
+
+  for (i = 0; i < n; i++) {
+    const uint8_t* p = &uartFrame[3 + 4 * i];
+    words[i] = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  uartLineLen = 0;
+  UART2_Append("[%10u] ", words[1]);
+
+  if (words[0] == 0) {
+    UART2_Append("LOG--> %u records lost", words[2]);
+  } else if (words[0] == LOG_ID_REC && n == 4) {
+    UART2_PrintRecord(&words[2]);
+  } else if (words[0] == LOG_ID_TRACE && n == 4) {
+    UART2_PrintTrace(&words[2]);
+  } else if (words[0] == LOG_ID_PCPROF) {
+    UART2_PrintSamples(&words[2], n - 2);
+  } else {
+    UART2_Format((const char*)(uintptr_t)words[0], &words[2], n - 2);
+  }
+
+  UART2_Append("\r\n");
+  UART2_Write(uartLine, uartLineLen);
+}
+/**
+ * @brief Print and save a sample recorder record.
+ * @param words Record (2 words)
+ */
+static void UART2_PrintRecord(const uint32_t* words) {
+
+  uint8_t rec[REC_RECORD_LEN];
+  uint8_t i;
+
+  for (i = 0; i < REC_RECORD_LEN; i++) {
+    rec[i] = words[i / 4] >> (8 * (i % 4));
+  }
+
+  if (rec[0] == REC_MAGIC1 && rec[1] == REC_MAGIC2) {
+    UART2_Append("REC--> Header version %u config %02x %02x %02x",
+        rec[2], rec[3], rec[4], rec[5]);
+  } else {
+    UART2_Append("REC--> dt %u x %d y %d z %d", rec[0] | (rec[1] << 8),
+        (int16_t)(rec[2] | (rec[3] << 8)), (int16_t)(rec[4] | (rec[5] << 8)),
+        (int16_t)(rec[6] | (rec[7] << 8)));
+  }
+
+  if (uartRecord) {
+    fwrite(rec, 1, sizeof(rec), uartRecord);
+  }
+}
+/**
+ * @brief Print a trace event.
+ * @param words Cycle counter and info word
+ */
+static void UART2_PrintTrace(const uint32_t* words) {
+
+  uint8_t type = words[1] >> 24;
+  uint8_t id = words[1] >> 16;
+  uint16_t arg = words[1];
+
+  if (type == TRACE_TYPE_HEADER) {
+    UART2_Append("TRACE--> Header clock %u ids %u overhead %u", words[0], id, arg);
+  } else {
+    UART2_Append("TRACE--> %10u %c id %u arg %u", words[0],
+        "BEI?"[type < 3 ? type : 3], id, arg);
+  }
+}
+/**
+ * @brief Print PC sample counts.
+ * @param words Header (0, frequency, samples, dropped) or address and count
+ * @param n Number of words
+ */
+static void UART2_PrintSamples(const uint32_t* words, uint8_t n) {
+
+  if (n == 4 && words[0] == 0) {
+    UART2_Append("PCPROF--> Header %u Hz, %u samples, %u dropped",
+        words[1], words[2], words[3]);
+  } else if (n == 2) {
+    UART2_Append("PCPROF--> 0x%08x %u", words[0], words[1]);
+  }
+}
+/**
+ * @brief Format a string with 32-bit arguments.
+ * @details Length modifiers are dropped - every argument
+ * is printed as a 32-bit value.
+ * @param fmt Format string
+ * @param args Arguments
+ * @param nargs Number of arguments
+ */
+static void UART2_Format(const char* fmt, const uint32_t* args, uint8_t nargs) {
+
+  while (*fmt) {
+
+    if (*fmt != '%') {
+      UART2_Append("%c", *fmt++);
+      continue;
+    }
+
+    // copy flags, width and precision
+    char spec[UART_FMT_LEN];
+    uint8_t len = 0;
+    spec[len++] = *fmt++;
+    while (*fmt && strchr("-+ #0123456789.", *fmt) && len < UART_FMT_LEN - 2) {
+      spec[len++] = *fmt++;
+    }
+    // skip length modifiers
+    while (*fmt && strchr("hlzjt", *fmt)) {
+      fmt++;
+    }
+
+    char conv = *fmt;
+    if (conv == 0) {
+      break;
+    }
+    fmt++;
+
+    if (conv == '%') {
+      UART2_Append("%%");
+      continue;
+    }
+    if (nargs == 0) {
+      UART2_Append("<?>");
+      continue;
+    }
+
+    uint32_t value = *args++;
+    nargs--;
+
+    spec[len++] = conv;
+    spec[len] = 0;
+
+    if (conv == 'd' || conv == 'i') {
+      UART2_Append(spec, (int)(int32_t)value);
+    } else if (conv == 'u' || conv == 'x' || conv == 'X' || conv == 'o' || conv == 'c') {
+      UART2_Append(spec, (unsigned int)value);
+    } else if (conv == 'p') {
+      UART2_Append("0x%08x", value);
+    } else {
+      UART2_Append("<str@0x%08x>", value);
+    }
+  }
+}
+/**
+ * @brief Append formatted text to the decoded line.
+ * @param fmt Format string
+ */
+static void UART2_Append(const char* fmt, ...) {
+
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf((char*)uartLine + uartLineLen,
+      sizeof(uartLine) - uartLineLen, fmt, ap);
+  va_end(ap);
+
+  if (len > 0) {
+    uartLineLen += len;
+    if (uartLineLen > sizeof(uartLine) - 1) {
+      uartLineLen = sizeof(uartLine) - 1;
+    }
+  }
+}
+/**
+ * @brief Write UART output to the terminal.
+ * @param buf Data
+ * @param len Number of bytes
+ */
+static void UART2_Write(const void* buf, size_t len) {
+
+  if (uartOut < 0) {
+    return;
+  }
+  if (uartOut == STDOUT_FILENO) {
+    fflush(stdout); // keep order with printf of the firmware
+  }
+  if (write(uartOut, buf, len) < 0) {
+    uartOut = -1;
+  }
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,215 @@
+/**
+ * @file:   bounce.c
+ * @brief:  Debouncing test of the keypad with bouncy contacts.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Keys are pressed and released with random contact
+ * bounce in interrupt mode. Every press and release must give
+ * exactly one event within the debounce time after the contact
+ * settles, and glitches shorter than a scan sweep none.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <keys.h>
+#include <timers.h>
+
+#define PRESSES       200   ///< Number of random presses
+#define MAX_BOUNCE_US 5000  ///< Longest bounce of a contact
+#define MAX_LATENCY   12    ///< Longest event delay after the contact settles (ms)
+#define STEP_US       100   ///< Time step of the waveforms
+
+/**
+ * @brief Events of a key.
+ */
+typedef struct {
+  uint32_t presses;   ///< Number of press events
+  uint32_t releases;  ///< Number of release events
+  uint32_t lastTime;  ///< Time of the last press or release event
+} Key_TypeDef;
+
+static Key_TypeDef keyEvents[KEYS_COUNT]; ///< Events of keys
+
+/**
+ * @brief Handler of press and release events.
+ */
+static void KeyHandler(KEYS_Event_TypeDef* event) {
+
+  if (event->type == KEYS_EVENT_PRESS) {
+    keyEvents[event->key].presses++;
+  } else {
+    keyEvents[event->key].releases++;
+  }
+  keyEvents[event->key].lastTime = event->time;
+}
+/**
+ * @brief Advance time, dispatching events every millisecond
+ * like the main loop.
+ * @param us Time to advance
+ */
+static void Run(uint32_t us) {
+
+  while (us >= STEP_US) {
+    uint32_t now = TIMER_GetTime();
+
+    SIM_Advance(SIM_US(STEP_US));
+    us -= STEP_US;
+    if (TIMER_GetTime() != now) {
+      KEYS_Update();
+    }
+  }
+}
+/**
+ * @brief Move contacts of keys with bounce.
+ * @details Each key toggles randomly until its own bounce time
+ * ends, then stays at the given level.
+ * @param mask Keys to move
+ * @param pressed New level
+ * @return Time the last contact settled (ms)
+ */
+static uint32_t Bounce(uint16_t mask, uint8_t pressed) {
+
+  uint32_t bounce[KEYS_COUNT];
+  uint32_t longest = 0;
+  uint32_t t;
+  uint8_t i;
+
+  for (i = 0; i < KEYS_COUNT; i++) {
+    bounce[i] = TEST_Random() % MAX_BOUNCE_US;
+    if ((mask & (1 << i)) && bounce[i] > longest) {
+      longest = bounce[i];
+    }
+  }
+
+  for (t = 0; t < longest; t += STEP_US) {
+    for (i = 0; i < KEYS_COUNT; i++) {
+      if ((mask & (1 << i)) && t < bounce[i]) {
+        SIM_KeysSet(i, TEST_Random() & 1);
+      }
+    }
+    Run(STEP_US);
+  }
+  for (i = 0; i < KEYS_COUNT; i++) {
+    if (mask & (1 << i)) {
+      SIM_KeysSet(i, pressed);
+    }
+  }
+  return TIMER_GetTime();
+}
+/**
+ * @brief Check events of keys after a move.
+ * @param mask Keys moved
+ * @param presses Expected number of presses of moved keys
+ * @param releases Expected number of releases of moved keys
+ * @param settled Time the contacts settled (ms)
+ * @return Number of keys with wrong events
+ */
+static uint32_t CheckKeys(uint16_t mask, uint32_t presses,
+    uint32_t releases, uint32_t settled) {
+
+  uint32_t errors = 0;
+  uint8_t i;
+
+  for (i = 0; i < KEYS_COUNT; i++) {
+    if ((mask & (1 << i)) == 0) {
+      continue;
+    }
+    if (keyEvents[i].presses != presses ||
+        keyEvents[i].releases != releases ||
+        keyEvents[i].lastTime > settled + MAX_LATENCY) {
+      printf("key %u: %lu presses, %lu releases, last at %lu ms, "
+          "settled at %lu ms\n", i, (unsigned long)keyEvents[i].presses,
+          (unsigned long)keyEvents[i].releases,
+          (unsigned long)keyEvents[i].lastTime, (unsigned long)settled);
+      errors++;
+    }
+  }
+  return errors;
+}
+
+int main(void) {
+
+  uint32_t errors = 0;
+  uint32_t settled;
+  uint32_t n;
+  uint8_t i;
+
+  TEST_Start();
+
+  TIMER_Init(1000);
+  KEYS_Init(KEYS_MODE_IRQ);
+
+  for (i = 0; i < KEYS_COUNT; i++) {
+    KEYS_RegisterHandler(i, KEYS_EVENT_PRESS, KeyHandler);
+    KEYS_RegisterHandler(i, KEYS_EVENT_RELEASE, KeyHandler);
+  }
+
+  Run(100000);
+
+  // Single keys - one event per move, wherever the bounce ends
+  for (n = 1; n <= PRESSES; n++) {
+
+    uint8_t key = TEST_Random() % KEYS_COUNT;
+    uint16_t mask = 1 << key;
+    uint32_t before = keyEvents[key].presses;
+
+    settled = Bounce(mask, 1);
+    Run(50000);
+    errors += CheckKeys(mask, before + 1, before, settled);
+
+    settled = Bounce(mask, 0);
+    Run(50000);
+    errors += CheckKeys(mask, before + 1, before + 1, settled);
+  }
+  TEST_CHECK(errors == 0);
+
+  // Chords - keys in the same and in different columns
+  static const uint16_t chords[] = {
+      (1 << KEYS_INDEX(0, 0)) | (1 << KEYS_INDEX(3, 3)),
+      (1 << KEYS_INDEX(1, 0)) | (1 << KEYS_INDEX(1, 2)),
+      (1 << KEYS_INDEX(2, 1)) | (1 << KEYS_INDEX(0, 1)) | (1 << KEYS_INDEX(2, 3)),
+  };
+
+  errors = 0;
+  for (n = 0; n < sizeof(chords) / sizeof(chords[0]); n++) {
+
+    memset(keyEvents, 0, sizeof(keyEvents));
+
+    settled = Bounce(chords[n], 1);
+    Run(50000);
+    errors += CheckKeys(chords[n], 1, 0, settled);
+    TEST_CHECK(KEYS_GetState() == chords[n]);
+
+    settled = Bounce(chords[n], 0);
+    Run(50000);
+    errors += CheckKeys(chords[n], 1, 1, settled);
+    errors += CheckKeys((uint16_t)~chords[n], 0, 0, 0);
+    TEST_CHECK(KEYS_GetState() == 0);
+  }
+  TEST_CHECK(errors == 0);
+
+  // Glitches shorter than a sweep (one sample of the key) are ignored
+  memset(keyEvents, 0, sizeof(keyEvents));
+  for (n = 0; n < 100; n++) {
+    i = TEST_Random() % KEYS_COUNT;
+    SIM_KeysSet(i, 1);
+    Run(STEP_US * (1 + TEST_Random() % 30));
+    SIM_KeysSet(i, 0);
+    Run(20000);
+  }
+  TEST_CHECK(CheckKeys(0xffff, 0, 0, 0) == 0);
+
+  TEST_CHECK(KEYS_GetLostEvents() == 0);
+
+  return TEST_Done();
+}
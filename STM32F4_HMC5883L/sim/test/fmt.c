@@ -0,0 +1,246 @@
+/**
+ * @file:   fmt.c
+ * @brief:  Comparison of FMT with snprintf.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Every value up to 2^20 and pseudo random values over
+ * the whole range are formatted with every number of decimals,
+ * values around every power of ten and some of the random ones
+ * also with every width and padding. Results are compared with
+ * the host snprintf (fixed point values are
+ * split into integer and fraction for it). Buffers one byte
+ * too short have to give an empty string and guard bytes after
+ * the buffer must stay untouched. At the end the time per call
+ * is printed next to snprintf (host timing - only a hint for
+ * the board).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <fmt.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BUF_LEN     40      ///< Output buffer (longer than any result)
+#define GUARD       0x5a    ///< Fill of unused buffer bytes
+#define MAX_WIDTH   24      ///< Widths tested with every value
+#define RANDOM      200000  ///< Number of pseudo random values
+#define RANDOM_FULL 2000    ///< Random values checked with all widths
+#define BENCH_CALLS 1000000 ///< Calls of every benchmarked function
+#define MAX_ERRORS  10      ///< Mismatches printed before giving up
+
+static unsigned errors; ///< Mismatches found
+
+/**
+ * @brief Reference fixed point formatting with snprintf.
+ */
+static int Reference(char* buf, int32_t value, uint8_t decimals,
+    uint8_t width, char pad) {
+
+  char body[BUF_LEN];
+  uint64_t abs = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+  uint64_t scale = 1;
+  uint8_t i;
+
+  for (i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+
+  if (decimals) {
+    snprintf(body, sizeof(body), "%llu.%0*llu", (unsigned long long)(abs / scale),
+        decimals % 11, (unsigned long long)(abs % scale));
+  } else {
+    snprintf(body, sizeof(body), "%llu", (unsigned long long)abs);
+  }
+
+  if (pad == '0') { // zeros go after the sign
+    int zeros = width - (int)strlen(body) - (value < 0);
+    char* p = buf;
+    if (value < 0) {
+      *p++ = '-';
+    }
+    while (zeros-- > 0) {
+      *p++ = '0';
+    }
+    return (p - buf) + snprintf(p, BUF_LEN - (p - buf), "%s", body);
+  }
+  char sign[BUF_LEN + 1];
+  snprintf(sign, sizeof(sign), "%s%s", (value < 0) ? "-" : "", body);
+  return snprintf(buf, BUF_LEN, "%*s", width, sign);
+}
+/**
+ * @brief Check one result against the reference.
+ */
+static void Compare(const char* what, int32_t value, uint8_t decimals,
+    uint8_t width, char pad, const char* result, uint8_t len,
+    const char* expected, int expectedLen) {
+
+  if (errors >= MAX_ERRORS) {
+    return;
+  }
+  if (strcmp(result, expected) != 0 || len != expectedLen) {
+    printf("%s(%ld, %u, %u, '%c') is \"%s\" (%u), expected \"%s\" (%d)\n",
+        what, (long)value, decimals, width, pad, result, len, expected,
+        expectedLen);
+    errors++;
+  }
+}
+/**
+ * @brief Check FMT_Fixed (and FMT_Int, FMT_Uint) for one value.
+ * @param value Value
+ * @param full Nonzero - all widths and paddings, zero - no padding
+ */
+static void CheckValue(int32_t value, uint8_t full) {
+
+  char buf[BUF_LEN];
+  char expected[BUF_LEN];
+  uint8_t decimals, width;
+  uint8_t p;
+
+  for (p = 0; p < (full ? 2 : 1); p++) {
+
+    char pad = p ? '0' : ' ';
+
+    for (width = 0; width <= (full ? MAX_WIDTH : 0); width += (width < 12) ? 1 : 4) {
+
+      for (decimals = 0; decimals <= 10; decimals++) {
+
+        int len = Reference(expected, value, decimals, width, pad);
+        Compare("FMT_Fixed", value, decimals, width, pad, buf,
+            FMT_Fixed(buf, sizeof(buf), value, decimals, width, pad),
+            expected, len);
+      }
+
+      // plain integers directly against printf conversions
+      int len = snprintf(expected, sizeof(expected), p ? "%0*ld" : "%*ld",
+          width, (long)value);
+      Compare("FMT_Int", value, 0, width, pad, buf,
+          FMT_Int(buf, sizeof(buf), value, width, pad), expected, len);
+
+      len = snprintf(expected, sizeof(expected), p ? "%0*lu" : "%*lu",
+          width, (unsigned long)(uint32_t)value);
+      Compare("FMT_Uint", value, 0, width, pad, buf,
+          FMT_Uint(buf, sizeof(buf), (uint32_t)value, width, pad), expected, len);
+    }
+  }
+
+  // hex against %x
+  int len = snprintf(expected, sizeof(expected), "%0*lx", 8, (unsigned long)(uint32_t)value);
+  Compare("FMT_Hex", value, 0, 8, '0', buf,
+      FMT_Hex(buf, sizeof(buf), (uint32_t)value, 8), expected, len);
+  len = snprintf(expected, sizeof(expected), "%lx", (unsigned long)(uint32_t)value);
+  Compare("FMT_Hex", value, 0, 0, '0', buf,
+      FMT_Hex(buf, sizeof(buf), (uint32_t)value, 0), expected, len);
+}
+/**
+ * @brief Check that a result which doesn't fit writes nothing.
+ */
+static void CheckSize(int32_t value, uint8_t decimals, uint8_t width) {
+
+  char buf[BUF_LEN];
+  char expected[BUF_LEN];
+  int len = Reference(expected, value, decimals, width, ' ');
+
+  memset(buf, GUARD, sizeof(buf));
+  TEST_CHECK(FMT_Fixed(buf, len + 1, value, decimals, width, ' ') == len);
+  TEST_CHECK_STR(buf, expected);
+
+  memset(buf, GUARD, sizeof(buf));
+  TEST_CHECK(FMT_Fixed(buf, len, value, decimals, width, ' ') == 0);
+  TEST_CHECK(buf[0] == 0 && (uint8_t)buf[1] == GUARD);
+}
+/**
+ * @brief Print time per call of a formatting loop.
+ */
+static void Bench(const char* name, struct timespec* start) {
+
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+  printf("%-28s %6.1f ns/call\n", name, ns / BENCH_CALLS);
+  clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+int main(void) {
+
+  static const int32_t edges[] = {INT32_MIN, INT32_MIN + 1, INT32_MAX, -1, 0};
+  char buf[BUF_LEN];
+  uint32_t i;
+  uint8_t d;
+
+  TEST_Start();
+
+  for (i = 0; i < (1u << 20); i++) {
+    CheckValue((int32_t)i, 0);
+    CheckValue(-(int32_t)i, 0);
+  }
+
+  uint32_t power;
+  for (power = 10; power <= 1000000000; power *= 10) {
+    for (i = power - 100; i < power + 100; i++) {
+      CheckValue((int32_t)i, 1);
+      CheckValue(-(int32_t)i, 1);
+    }
+  }
+  for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+    CheckValue(edges[i], 1);
+  }
+  for (i = 0; i < RANDOM; i++) {
+    CheckValue((int32_t)TEST_Random(), i < RANDOM_FULL);
+  }
+  TEST_CHECK(errors == 0);
+
+  // sizes, every length of output
+  for (d = 0; d <= 10; d++) {
+    CheckSize(-123456789, d, 0);
+    CheckSize(5, d, 0);
+    CheckSize(5, d, 30);
+  }
+
+  // out of range arguments
+  memset(buf, GUARD, sizeof(buf));
+  TEST_CHECK(FMT_Fixed(buf, 8, 5, 254, 0, ' ') == 0);
+  TEST_CHECK(buf[0] == 0 && (uint8_t)buf[1] == GUARD);
+  TEST_CHECK(FMT_Fixed(buf, sizeof(buf), 5, 11, 0, ' ') == 0);
+  TEST_CHECK(FMT_Fixed(buf, 255, 5, 10, 255, ' ') == 0);
+  TEST_CHECK(FMT_Uint(buf, 0, 5, 0, ' ') == 0 && buf[0] == 0);
+
+  // benchmark - heading format of the application
+  struct timespec start;
+  volatile int32_t value = 12345;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    FMT_Fixed(buf, sizeof(buf), value + i, 2, 7, ' ');
+  }
+  Bench("FMT_Fixed(x, 2, 7, ' ')", &start);
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    snprintf(buf, sizeof(buf), "%4ld.%02ld", (long)((value + i) / 100),
+        (long)((value + i) % 100));
+  }
+  Bench("snprintf(\"%4ld.%02ld\")", &start);
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    FMT_Uint(buf, sizeof(buf), value + i, 0, ' ');
+  }
+  Bench("FMT_Uint(x, 0, ' ')", &start);
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)(value + i));
+  }
+  Bench("snprintf(\"%lu\")", &start);
+
+  return TEST_Done();
+}
@@ -0,0 +1,209 @@
+/**
+ * @file:   glyphs.c
+ * @brief:  Test of the custom glyph cache against the display model.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Glyphs are printed and the cells showing them are
+ * checked against the CGRAM of the model - a glyph on the
+ * screen must never lose its slot while at most 8 glyphs are
+ * visible.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <hd44780.h>
+
+#define SLOTS       8     ///< CGRAM slots of the display
+#define PUTS        3000  ///< Number of random prints
+#define WORKING_SET 6     ///< Glyphs printed in a phase of the workload
+#define PHASE       100   ///< Prints in a phase
+#define NO_GLYPH    -1    ///< Cell shows a character
+
+static uint8_t glyphs[LCD_MAX_GLYPHS][8];   ///< Bitmaps of glyphs
+static int8_t cells[LCD_ROWS][LCD_COLUMNS]; ///< Glyph shown in cells
+
+/**
+ * @brief Print a glyph or a space and remember it.
+ * @param x Column
+ * @param y Row
+ * @param id Glyph ID (NO_GLYPH - space)
+ */
+static void Put(uint8_t x, uint8_t y, int8_t id) {
+
+  LCD_Position(x, y);
+  if (id == NO_GLYPH) {
+    LCD_Putc(' ');
+  } else {
+    LCD_PutGlyph(id);
+  }
+  cells[y][x] = id;
+}
+/**
+ * @brief Count distinct glyphs shown.
+ */
+static uint8_t Visible(void) {
+
+  uint8_t shown[LCD_MAX_GLYPHS] = {0};
+  uint8_t count = 0;
+  uint8_t x, y;
+
+  for (y = 0; y < LCD_ROWS; y++) {
+    for (x = 0; x < LCD_COLUMNS; x++) {
+      if (cells[y][x] != NO_GLYPH && !shown[cells[y][x]]) {
+        shown[cells[y][x]] = 1;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+/**
+ * @brief Check that the display shows the remembered cells.
+ * @return Number of wrong cells
+ */
+static uint32_t WrongCells(void) {
+
+  uint32_t wrong = 0;
+  uint8_t x, y;
+
+  for (y = 0; y < LCD_ROWS; y++) {
+
+    char text[LCD_COLUMNS + 1];
+    SIM_LcdText(y, text);
+
+    for (x = 0; x < LCD_COLUMNS; x++) {
+
+      uint8_t bitmap[8];
+
+      if (cells[y][x] == NO_GLYPH) {
+        wrong += (text[x] != ' ');
+        continue;
+      }
+      if (text[x] < '0' || text[x] > '7') {
+        wrong++;
+        continue;
+      }
+      SIM_LcdGlyph(text[x] - '0', bitmap);
+      wrong += (memcmp(bitmap, glyphs[cells[y][x]], 8) != 0);
+    }
+  }
+  return wrong;
+}
+
+int main(void) {
+
+  uint32_t hits, misses;
+  uint32_t count;
+  uint8_t i;
+
+  TEST_Start();
+
+  for (i = 0; i < LCD_MAX_GLYPHS; i++) {
+    glyphs[i][0] = i; // unique
+    uint8_t row;
+    for (row = 1; row < 8; row++) {
+      glyphs[i][row] = (i * 7 + row * 11) & 0x1f;
+    }
+    LCD_RegisterGlyph(i, glyphs[i]);
+  }
+  memset(cells, NO_GLYPH, sizeof(cells));
+
+  LCD_Init();
+  SIM_Advance(SIM_MS(100));
+
+  // A glyph is uploaded once
+  for (i = 0; i < SLOTS; i++) {
+    Put(i, 0, i);
+  }
+  SIM_Advance(SIM_MS(10));
+  LCD_GetGlyphStats(&hits, &misses);
+  TEST_CHECK(hits == 0 && misses == SLOTS);
+  TEST_CHECK(WrongCells() == 0);
+
+  count = TEST_LcdInstructions();
+  for (i = 0; i < SLOTS; i++) {
+    Put(i, 1, i);
+  }
+  SIM_Advance(SIM_MS(10));
+  LCD_GetGlyphStats(&hits, &misses);
+  TEST_CHECK(hits == SLOTS && misses == SLOTS);
+  TEST_CHECK(TEST_LcdInstructions() - count == 1 + SLOTS); // address and data only
+  TEST_CHECK(WrongCells() == 0);
+
+  // A new glyph takes the slot of one not shown
+  for (i = 0; i < 4; i++) {
+    Put(i, 0, NO_GLYPH);
+    Put(i, 1, NO_GLYPH);
+  }
+  Put(15, 0, 8);
+  Put(15, 1, 9);
+  SIM_Advance(SIM_MS(10));
+  TEST_CHECK(WrongCells() == 0);
+
+  // A registered again bitmap is uploaded again, the cells
+  // showing the old one change
+  static uint8_t newBitmap[8] = {0x1f, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1f};
+  LCD_RegisterGlyph(4, newBitmap);
+  memcpy(glyphs[4], newBitmap, 8);
+  Put(14, 0, 4);
+  SIM_Advance(SIM_MS(10));
+  LCD_GetGlyphStats(&hits, &misses);
+  TEST_CHECK(misses == SLOTS + 3);
+  TEST_CHECK(WrongCells() == 0);
+
+  // Random prints of a moving working set - a glyph shown never
+  // loses its slot if at most 8 are shown
+  uint32_t wrong = 0;
+  uint32_t base = 0;
+  uint32_t n;
+
+  LCD_GetGlyphStats(&hits, &misses);
+  uint32_t puts = hits + misses;
+
+  for (n = 0; n < PUTS; n++) {
+
+    uint8_t x = TEST_Random() % LCD_COLUMNS;
+    uint8_t y = TEST_Random() % LCD_ROWS;
+    int8_t old = cells[y][x];
+    int8_t id = (base + TEST_Random() % WORKING_SET) % LCD_MAX_GLYPHS;
+
+    if (n % PHASE == PHASE - 1) {
+      base++;
+    }
+    if (TEST_Random() % 4 == 0) {
+      id = NO_GLYPH;
+    }
+
+    cells[y][x] = id;
+    if (Visible() > SLOTS) {
+      id = NO_GLYPH;
+    }
+    cells[y][x] = old;
+
+    Put(x, y, id);
+    puts += (id != NO_GLYPH);
+    SIM_Advance(SIM_MS(1));
+
+    if (WrongCells()) {
+      printf("print %lu: glyph %d at %u,%u\n", (unsigned long)n, id, x, y);
+      wrong++;
+    }
+  }
+  TEST_CHECK(wrong == 0);
+
+  LCD_GetGlyphStats(&hits, &misses);
+  TEST_CHECK(hits + misses == puts);
+  printf("%lu hits, %lu misses\n", (unsigned long)hits, (unsigned long)misses);
+
+  return TEST_Done();
+}
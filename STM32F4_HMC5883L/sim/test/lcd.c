@@ -0,0 +1,205 @@
+/**
+ * @file:   lcd.c
+ * @brief:  Test of the LCD engine against the HD44780 model.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details The engine runs from the simulated TIM3 interrupt
+ * and writes the model of the controller, which checks the
+ * timing of every nibble (execution times and the enable cycle).
+ * The test checks the display contents, that no write broke the
+ * timing and the time every update takes in the known-time mode.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <hd44780.h>
+#include <hd44780_hal.h>
+
+#define BYTE_US     42    ///< Two nibbles 2us apart and 40us of execution
+#define TIMEOUT_US  10000 ///< Longest wait for an update
+#define FRAMES      500   ///< Number of random frames
+
+/**
+ * @brief Wait until the display executed given instructions.
+ * @param count Number of instructions since the call
+ * @return Time of the last one since the call in us (TIMEOUT_US - never)
+ */
+static uint32_t WaitInstructions(uint32_t count) {
+
+  uint32_t end = TEST_LcdInstructions() + count;
+  uint32_t us;
+
+  for (us = 0; us < TIMEOUT_US; us++) {
+    if (TEST_LcdInstructions() >= end) {
+      return us;
+    }
+    SIM_Advance(SIM_US(1));
+  }
+  return TIMEOUT_US;
+}
+/**
+ * @brief Get a visible row of the display.
+ * @return Row text (valid until the next call)
+ */
+static const char* Row(uint8_t row) {
+
+  static char text[LCD_COLUMNS + 1];
+
+  SIM_LcdText(row, text);
+  return text;
+}
+
+int main(void) {
+
+  TEST_Start();
+
+  // Initialization: 4 nibbles in 8-bit mode, then 3 commands
+  LCD_Init();
+  SIM_Advance(SIM_MS(49));
+  TEST_CHECK(TEST_LcdInstructions() == 0); // power on wait
+  TEST_CHECK(WaitInstructions(7) < SIM_MS(10) / SIM_US(1));
+  SIM_Advance(SIM_MS(2)); // clear executes
+  TEST_CHECK_STR(Row(0), "                ");
+  TEST_CHECK(TEST_LcdViolations() == 0);
+
+  // Text from the home position - data writes only, one nibble per tick
+  LCD_Puts("Hello, world!");
+  TEST_CHECK(WaitInstructions(13) == 2 + 12 * BYTE_US + 2);
+  TEST_CHECK_STR(Row(0), "Hello, world!   ");
+
+  // Unchanged cells are not sent
+  SIM_Advance(SIM_MS(1));
+  uint32_t count = TEST_LcdInstructions();
+  LCD_Position(0, 0);
+  LCD_Puts("Hello, world!");
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK(TEST_LcdInstructions() == count);
+
+  // Single cell - address set and data
+  LCD_Position(7, 0);
+  LCD_Puts("W");
+  TEST_CHECK(WaitInstructions(2) == 2 + BYTE_US + 2);
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK(TEST_LcdInstructions() == count + 2);
+  TEST_CHECK_STR(Row(0), "Hello, World!   ");
+
+  // Whole screen - 32 characters and at most two address sets
+  LCD_Clear();
+  LCD_Puts("0123456789abcdef");
+  LCD_Position(0, 1);
+  LCD_Puts("ABCDEFGHIJKLMNOP");
+  count = TEST_LcdInstructions();
+  SIM_Advance(SIM_US(34 * BYTE_US + 4));
+  TEST_CHECK(TEST_LcdInstructions() - count >= 32);
+  TEST_CHECK_STR(Row(0), "0123456789abcdef");
+  TEST_CHECK_STR(Row(1), "ABCDEFGHIJKLMNOP");
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK(TEST_LcdInstructions() - count <= 34);
+
+  TEST_CHECK(TEST_LcdViolations() == 0);
+
+  // Random frames - the display ends up showing the framebuffer,
+  // sending changed cells and one address set per run of them
+  // (plus one if the engine starts in the middle of a run)
+  char frame[LCD_ROWS][LCD_COLUMNS + 1] = {
+      "0123456789abcdef", "ABCDEFGHIJKLMNOP",
+  };
+  uint32_t wrong = 0;
+  uint32_t extra = 0;
+  uint32_t n;
+
+  for (n = 0; n < FRAMES; n++) {
+
+    uint8_t changed[LCD_ROWS][LCD_COLUMNS] = {{0}};
+    uint32_t writes = TEST_Random() % 40;
+    uint32_t cells = 0;
+    uint32_t runs = 0;
+    uint8_t x, y;
+
+    while (writes--) {
+      x = TEST_Random() % LCD_COLUMNS;
+      y = TEST_Random() % LCD_ROWS;
+      uint8_t len = 1 + TEST_Random() % 4;
+
+      LCD_Position(x, y);
+      for (; len && x < LCD_COLUMNS; len--, x++) {
+        char c = ' ' + TEST_Random() % ('~' - ' ' + 1);
+        LCD_Putc(c);
+        if (frame[y][x] != c) {
+          frame[y][x] = c;
+          changed[y][x] = 1;
+        }
+      }
+    }
+
+    for (y = 0; y < LCD_ROWS; y++) {
+      for (x = 0; x < LCD_COLUMNS; x++) {
+        if (changed[y][x]) { // may be changed back, still at most one write
+          cells++;
+          if (x == 0 || !changed[y][x - 1]) {
+            runs++;
+          }
+        }
+      }
+    }
+
+    count = TEST_LcdInstructions();
+    SIM_Advance(SIM_US((cells + runs + 1) * BYTE_US + 4));
+
+    if (strcmp(Row(0), frame[0]) || strcmp(Row(1), frame[1])) {
+      printf("frame %lu: \"%s\" \"%s\"\n", (unsigned long)n,
+          frame[0], frame[1]);
+      wrong++;
+    }
+    if (TEST_LcdInstructions() - count > cells + runs + 1) {
+      extra++;
+    }
+  }
+  TEST_CHECK(wrong == 0);
+  TEST_CHECK(extra == 0);
+  TEST_CHECK(TEST_LcdViolations() == 0);
+
+  // Held frame - nothing is sent until it's committed, then only
+  // the cells which differ from the last frame
+  LCD_Clear();
+  LCD_Puts("0123456789abcdef");
+  LCD_Position(0, 1);
+  LCD_Puts("ABCDEFGHIJKLMNOP");
+  SIM_Advance(SIM_MS(5));
+
+  LCD_BeginFrame();
+  LCD_Clear();
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK_STR(Row(0), "0123456789abcdef");
+  LCD_Puts("0123456789ABCDEF");
+  LCD_Position(0, 1);
+  LCD_Puts("ABCDEFGHIJKLMNOP");
+  count = TEST_LcdInstructions();
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK(TEST_LcdInstructions() == count);
+  LCD_CommitFrame();
+  SIM_Advance(SIM_MS(1));
+  TEST_CHECK(TEST_LcdInstructions() - count == 1 + 6);
+  TEST_CHECK_STR(Row(0), "0123456789ABCDEF");
+  TEST_CHECK_STR(Row(1), "ABCDEFGHIJKLMNOP");
+
+  // The model catches writes breaking the timing
+  LCD_HAL_WriteNibble(1, 'x' >> 4);
+  LCD_HAL_WriteNibble(1, 'x'); // same time - enable cycle too short
+  TEST_CHECK(TEST_LcdViolations() == 1);
+  SIM_Advance(SIM_US(10));
+  LCD_HAL_WriteNibble(1, 'y' >> 4); // display still busy
+  TEST_CHECK(TEST_LcdViolations() == 2);
+
+  return TEST_Done();
+}
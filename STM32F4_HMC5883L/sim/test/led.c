@@ -0,0 +1,127 @@
+/**
+ * @file:   led.c
+ * @brief:  Timeline test of LED patterns.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Patterns are played on the simulated DMA sequencer
+ * and the LED is sampled in the middle of every pattern tick.
+ * A timeline shows one sample per tick like the simulator
+ * shows the LED: * (on), . (off), 1-9 (PWM brightness).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <led.h>
+
+#define TIMELINE_LEN 32 ///< Longest timeline
+
+/**
+ * @brief Record how an LED looks over time.
+ * @details Starts half a tick after now, one sample per tick.
+ * @param led LED number.
+ * @param tickMs Sampling period in milliseconds
+ * @param samples Number of samples
+ * @return Timeline (valid until the next call)
+ */
+static const char* Timeline(LED_Number_TypeDef led, uint32_t tickMs,
+    uint8_t samples) {
+
+  static char line[TIMELINE_LEN + 1];
+  char render[64];
+  uint8_t i;
+
+  SIM_Advance(SIM_MS(tickMs) / 2);
+
+  for (i = 0; i < samples && i < TIMELINE_LEN; i++) {
+    SIM_LedRender(render, sizeof(render));
+    line[i] = render[5 + 8 * led]; // "LED0 x  LED1 x..."
+    SIM_Advance(SIM_MS(tickMs));
+  }
+  line[i] = 0;
+
+  SIM_Advance(SIM_MS(tickMs) / 2); // back on a tick boundary
+  return line;
+}
+
+static const LED_Step_TypeDef blinkSteps[] = {
+    {100, 3}, {0, 2}, {100, 1},
+};
+static const LED_Step_TypeDef dimSteps[] = {
+    {100, 1}, {30, 2},
+};
+static const LED_Step_TypeDef longSteps[] = {
+    {100, 1}, {0, 1},
+};
+
+int main(void) {
+
+  TEST_Start();
+
+  LED_Init(LED0);
+  LED_Init(LED1);
+  LED_InitPWM(LED2);
+
+  // One-shot - first value at the first tick, then the last step stays
+  LED_Pattern_TypeDef blink = {blinkSteps, 3, 0, 10};
+  LED_PlayPattern(LED0, &blink);
+  TEST_CHECK(LED_GetState(LED0) == LED_PATTERN);
+  TEST_CHECK_STR(Timeline(LED0, 10, 10), ".***..****");
+  TEST_CHECK(LED_GetState(LED0) == LED_ON);
+
+  // finished pattern doesn't restore the old state
+  LED_Toggle(LED0);
+  TEST_CHECK(LED_GetState(LED0) == LED_OFF);
+  TEST_CHECK((SIM_LedRead() & 1) == 0);
+
+  // Looped pattern runs until stopped, then the old state returns
+  blink.loop = 1;
+  LED_ChangeState(LED1, LED_ON);
+  LED_PlayPattern(LED1, &blink);
+  TEST_CHECK_STR(Timeline(LED1, 10, 14), "****..****..**");
+  TEST_CHECK(LED_GetState(LED1) == LED_PATTERN);
+  LED_StopPattern();
+  TEST_CHECK(LED_GetState(LED1) == LED_ON);
+  TEST_CHECK_STR(Timeline(LED1, 10, 2), "**");
+
+  // PWM one-shot ends dimmed - below half is the off state
+  LED_Pattern_TypeDef dim = {dimSteps, 2, 0, 20};
+  LED_PlayPattern(LED2, &dim);
+  TEST_CHECK_STR(Timeline(LED2, 20, 5), ".*333");
+  TEST_CHECK(LED_GetState(LED2) == LED_OFF);
+
+  // Next pattern after a finished one
+  blink.loop = 0;
+  LED_PlayPattern(LED0, &blink);
+  TEST_CHECK(LED_GetState(LED0) == LED_PATTERN);
+  TEST_CHECK(LED_GetState(LED2) == LED_OFF);
+  TEST_CHECK_STR(Timeline(LED0, 10, 7), ".***..*");
+
+  // Ticks longer than the 16 bit step timer (6.5 s)
+  LED_Pattern_TypeDef slow = {longSteps, 2, 0, 10000};
+  LED_ChangeState(LED0, LED_OFF);
+  LED_PlayPattern(LED0, &slow);
+  TEST_CHECK_STR(Timeline(LED0, 10000, 4), ".*..");
+  SIM_Advance(SIM_MS(9990));
+  TEST_CHECK((SIM_LedRead() & 1) == 0);
+  LED_PlayPattern(LED0, &slow);
+  SIM_Advance(SIM_MS(9999));
+  TEST_CHECK((SIM_LedRead() & 1) == 0);
+  SIM_Advance(SIM_MS(2));
+  TEST_CHECK((SIM_LedRead() & 1) == 1);
+
+  slow.tickMs = 65535; // longest tick
+  LED_PlayPattern(LED0, &slow);
+  TEST_CHECK_STR(Timeline(LED0, 65535, 3), ".*.");
+
+  return TEST_Done();
+}
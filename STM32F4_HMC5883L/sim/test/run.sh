@@ -0,0 +1,97 @@
+#!/bin/sh
+#
+# Runner of the scripted simulator tests.
+#
+# A scripted test is a simulator script (see src/sim.c) run
+# in virtual time. Comment lines of the script hold the checks
+# of the output (stdout and stderr together):
+#
+#   # args: -H 90 -r 0      extra simulator options
+#   # expect: REGEX         some line has to match (grep -E)
+#   # reject: REGEX         no line may match
+#
+# Any other test is a unit test program, which passes when
+# it exits with zero. Its output (e.g. benchmark results) is
+# shown also when it passes.
+#
+# Usage:
+#   run.sh SIM TEST...
+#
+# Copyright (c) 2014 Michal Ksiezopolski.
+# All rights reserved. This program and the
+# accompanying materials are made available
+# under the terms of the GNU Public License
+# v3.0 which accompanies this distribution,
+# and is available at
+# http://www.gnu.org/licenses/gpl.html
+#
+
+SIM=$1
+shift
+
+failed=0
+out=$(mktemp)
+trap 'rm -f "$out"' EXIT
+
+# report NAME OK - print the result, keep the output of a failed test
+report() {
+  if [ "$2" -eq 1 ]; then
+    echo "$1: PASS"
+  else
+    log=$(dirname "$SIM")/$1.log
+    cp "$out" "$log"
+    echo "$1: FAIL (output in $log)"
+    failed=$((failed + 1))
+  fi
+}
+
+for test in "$@"; do
+
+  name=$(basename "$test" .scr)
+  ok=1
+
+  case $test in
+    *.scr) ;;
+    *)
+      if ! timeout 60 "$test" </dev/null >"$out" 2>&1; then
+        ok=0
+      fi
+      [ $ok -eq 1 ] && sed "s/^/$name: /" "$out"
+      report "$name" $ok
+      continue
+      ;;
+  esac
+
+  args=$(sed -n 's/^# args: *//p' "$test")
+
+  # shellcheck disable=SC2086 # args are split on purpose
+  if ! timeout 60 "$SIM" -V -q $args -f "$test" </dev/null >"$out" 2>&1; then
+    echo "$name: simulator failed"
+    ok=0
+  fi
+
+  while IFS= read -r pattern; do
+    if ! grep -Eq -- "$pattern" "$out"; then
+      echo "$name: missing: $pattern"
+      ok=0
+    fi
+  done <<LIST
+$(sed -n 's/^# expect: *//p' "$test")
+LIST
+
+  while IFS= read -r pattern; do
+    if [ -n "$pattern" ] && grep -Eq -- "$pattern" "$out"; then
+      echo "$name: unexpected: $(grep -E -m 1 -- "$pattern" "$out")"
+      ok=0
+    fi
+  done <<LIST
+$(sed -n 's/^# reject: *//p' "$test")
+LIST
+
+  report "$name" $ok
+done
+
+if [ $failed -ne 0 ]; then
+  echo "$failed test(s) failed"
+  exit 1
+fi
@@ -0,0 +1,158 @@
+/**
+ * @file:   test.h
+ * @brief:  Checks for the simulator unit tests.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Unit tests are host programs linked with the
+ * application and the simulated HAL, with the simulator
+ * main renamed (no firmware main loop runs). A test drives
+ * the modules and the virtual clock directly and returns
+ * TEST_Done() from its main:
+ *
+ * @code
+ * int main(void) {
+ *   TEST_Start();
+ *   SIM_Advance(SIM_MS(10));
+ *   TEST_CHECK(LED_GetState(LED0) == LED_OFF);
+ *   return TEST_Done();
+ * }
+ * @endcode
+ *
+ * TEST_Random gives the same numbers in every run, unless
+ * the TEST_SEED environment variable sets another seed. A
+ * failed test prints its seed.
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <sim.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup  TEST TEST
+ * @brief     Checks for the simulator unit tests
+ */
+
+/**
+ * @addtogroup TEST
+ * @{
+ */
+
+/**
+ * @brief Check a condition.
+ */
+#define TEST_CHECK(cond) \
+  TEST_Check((cond) != 0, #cond, __FILE__, __LINE__)
+
+/**
+ * @brief Check that a string has the expected value.
+ */
+#define TEST_CHECK_STR(str, expected) \
+  TEST_CheckStr((str), (expected), #str, __FILE__, __LINE__)
+
+static unsigned testFailed; ///< Number of failed checks
+static uint32_t testSeed;   ///< Seed of TEST_Random
+static uint32_t testRandom; ///< State of TEST_Random
+
+/**
+ * @brief Report a failed check.
+ */
+static inline void TEST_Check(int ok, const char* what,
+    const char* file, int line) {
+
+  if (!ok) {
+    printf("%s:%d: check failed: %s\n", file, line, what);
+    testFailed++;
+  }
+}
+/**
+ * @brief Report a string with wrong value.
+ */
+static inline void TEST_CheckStr(const char* str, const char* expected,
+    const char* what, const char* file, int line) {
+
+  if (strcmp(str, expected) != 0) {
+    printf("%s:%d: %s is \"%s\", expected \"%s\"\n",
+        file, line, what, str, expected);
+    testFailed++;
+  }
+}
+/**
+ * @brief Set up the simulator for a test.
+ * @details Virtual time moved only by SIM_Advance, no rendering
+ * of the models.
+ */
+static inline void TEST_Start(void) {
+
+  simOptions.virtualTime = 1;
+  simOptions.manualTime = 1;
+  simOptions.quiet = 1;
+
+  const char* seed = getenv("TEST_SEED");
+  testSeed = seed ? strtoul(seed, NULL, 0) : 1;
+  testRandom = testSeed;
+}
+/**
+ * @brief Pseudo random numbers (repeatable, see TEST_SEED).
+ * @details Linear congruential generator with the high bits
+ * folded into the low ones, which alone have short periods.
+ * @return 32 random bits
+ */
+static inline uint32_t TEST_Random(void) {
+
+  testRandom = testRandom * 1664525 + 1013904223;
+  return testRandom ^ (testRandom >> 16);
+}
+/**
+ * @brief Get the number of instructions executed by the display.
+ */
+static inline uint32_t TEST_LcdInstructions(void) {
+
+  uint32_t instructions, violations;
+
+  SIM_LcdStats(&instructions, &violations);
+  return instructions;
+}
+/**
+ * @brief Get the number of writes which broke the display timing.
+ */
+static inline uint32_t TEST_LcdViolations(void) {
+
+  uint32_t instructions, violations;
+
+  SIM_LcdStats(&instructions, &violations);
+  return violations;
+}
+/**
+ * @brief Finish a test.
+ * @return Exit code (nonzero if any check failed)
+ */
+static inline int TEST_Done(void) {
+
+  if (testFailed) {
+    printf("%u check(s) failed (TEST_SEED=%lu)\n", testFailed,
+        (unsigned long)testSeed);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @}
+ */
+
+#endif /* TEST_H_ */
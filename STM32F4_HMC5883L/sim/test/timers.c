@@ -0,0 +1,163 @@
+/**
+ * @file:   timers.c
+ * @brief:  Long run test of the system time and soft timers.
+ * @date:   19 paź 2026
+ * @author: Michal Ksiezopolski
+ *
+ * @details Hours of operation are simulated with the SysTick
+ * model. Soft timers are updated at random intervals like from
+ * a busy main loop - callbacks may come late by up to one
+ * interval, but the lateness must not add up over the periods
+ * (timer periods are longer than the intervals, shorter ones
+ * skip periods).
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include "test.h"
+#include <timers.h>
+
+#define HOURS         4     ///< Simulated time
+#define MAX_INTERVAL  15    ///< Longest interval between updates (ms)
+
+/**
+ * @brief Calls of a periodic timer.
+ */
+typedef struct {
+  uint32_t period;    ///< Timer period (ms)
+  uint32_t start;     ///< Time of the start (ms)
+  uint32_t calls;     ///< Number of calls
+  uint32_t maxLate;   ///< Longest delay after the due time (ms)
+  uint32_t early;     ///< Calls before the due time
+} Periodic_TypeDef;
+
+static uint32_t oneShotCalls; ///< Calls of the one shot timer
+static int8_t watchdog;       ///< Timer restarted by another one
+static uint32_t watchdogCalls;  ///< Calls of the watchdog timer
+static uint32_t watchdogTime;   ///< Time of the last watchdog call (ms)
+
+/**
+ * @brief Callback of the periodic timers.
+ */
+static void PeriodicCallback(int8_t id, void* context) {
+
+  Periodic_TypeDef* timer = context;
+  uint32_t due = timer->start + (timer->calls + 1) * timer->period;
+  uint32_t now = TIMER_GetTime();
+
+  timer->calls++;
+  if (now < due) {
+    timer->early++;
+  } else if (now - due > timer->maxLate) {
+    timer->maxLate = now - due;
+  }
+}
+/**
+ * @brief Callback of the one shot timer.
+ */
+static void OneShotCallback(int8_t id, void* context) {
+  oneShotCalls++;
+}
+/**
+ * @brief Callback restarting the watchdog timer.
+ */
+static void RestartCallback(int8_t id, void* context) {
+  TIMER_StartSoftTimer(watchdog);
+}
+/**
+ * @brief Callback of the watchdog timer.
+ */
+static void WatchdogCallback(int8_t id, void* context) {
+  watchdogCalls++;
+  watchdogTime = TIMER_GetTime();
+}
+
+int main(void) {
+
+  static Periodic_TypeDef timers[] = {
+      {.period = 1000}, {.period = 333}, {.period = MAX_INTERVAL + 1},
+  };
+  uint8_t count = sizeof(timers) / sizeof(timers[0]);
+  uint8_t i;
+
+  TEST_Start();
+
+  TIMER_Init(1000);
+  TIMER_SoftTimersUpdate();
+
+  for (i = 0; i < count; i++) {
+    int8_t id = TIMER_CreateSoftTimer(timers[i].period, TIMER_PERIODIC,
+        PeriodicCallback, &timers[i]);
+    TEST_CHECK(id >= 0);
+    timers[i].start = TIMER_GetTime();
+    TIMER_StartSoftTimer(id);
+  }
+
+  int8_t oneShot = TIMER_CreateSoftTimer(5000, TIMER_ONE_SHOT,
+      OneShotCallback, NULL);
+  TIMER_StartSoftTimer(oneShot);
+
+  uint64_t end = SIM_MS(HOURS * 3600000ULL);
+  uint32_t updates = 0;
+
+  while (SIM_Now() < end) {
+    SIM_Advance(SIM_MS(1 + TEST_Random() % MAX_INTERVAL));
+    TIMER_SoftTimersUpdate();
+    updates++;
+  }
+
+  // system time follows the SysTick exactly
+  TEST_CHECK(TIMER_GetTime() == SIM_Now() / SIM_MS(1));
+
+  for (i = 0; i < count; i++) {
+
+    uint32_t elapsed = TIMER_GetTime() - timers[i].start;
+
+    if (timers[i].calls + 1 < elapsed / timers[i].period ||
+        timers[i].calls > elapsed / timers[i].period) {
+      printf("%lu ms timer: %lu calls in %lu ms\n", (unsigned long)timers[i].period,
+          (unsigned long)timers[i].calls, (unsigned long)elapsed);
+      TEST_CHECK(0);
+    }
+    TEST_CHECK(timers[i].early == 0);
+    TEST_CHECK(timers[i].maxLate < MAX_INTERVAL); // one update interval
+  }
+  TEST_CHECK(oneShotCalls == 1);
+
+  // A callback restarts a later timer which expired in the same
+  // update - the restarted timer isn't called and counts from 0
+  int8_t restart = TIMER_CreateSoftTimer(50, TIMER_PERIODIC,
+      RestartCallback, NULL);
+  watchdog = TIMER_CreateSoftTimer(50, TIMER_PERIODIC,
+      WatchdogCallback, NULL);
+  TIMER_StartSoftTimer(restart);
+  TIMER_StartSoftTimer(watchdog);
+
+  for (i = 0; i < 100; i++) {
+    SIM_Advance(SIM_MS(10));
+    TIMER_SoftTimersUpdate();
+  }
+  TEST_CHECK(watchdogCalls == 0);
+
+  TIMER_RemoveSoftTimer(restart);
+  uint32_t restarted = TIMER_GetTime();
+
+  for (i = 0; i < 10; i++) {
+    SIM_Advance(SIM_MS(10));
+    TIMER_SoftTimersUpdate();
+  }
+  TEST_CHECK(watchdogCalls == 2);
+  TEST_CHECK(watchdogTime == restarted + 100);
+
+  printf("%u h in %lu updates\n", HOURS, (unsigned long)updates);
+
+  return TEST_Done();
+}
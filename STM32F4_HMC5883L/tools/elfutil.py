@@ -0,0 +1,111 @@
+"""
+Minimal ELF (little endian) reader for the host tools.
+
+Only what the tools need is implemented: section contents
+by name and the symbol table. No external packages needed.
+ELF64 is read too, for the host simulation build.
+
+Copyright (c) 2014 Michal Ksiezopolski.
+All rights reserved. This program and the
+accompanying materials are made available
+under the terms of the GNU Public License
+v3.0 which accompanies this distribution,
+and is available at
+http://www.gnu.org/licenses/gpl.html
+"""
+
+import struct
+
+
+class Section(object):
+    def __init__(self, name, type_, addr, offset, size, link, entsize):
+        self.name = name
+        self.type = type_
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+        self.entsize = entsize
+
+
+class Symbol(object):
+    def __init__(self, name, value, size, type_):
+        self.name = name
+        self.value = value
+        self.size = size
+        self.type = type_
+
+
+STT_FUNC = 2
+SHT_SYMTAB = 2
+
+
+class Elf(object):
+    """ELF little endian file (ARM firmware or host simulation)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF" or self.data[4] not in (1, 2) or self.data[5] != 1:
+            raise ValueError("%s is not a little endian ELF file" % path)
+
+        self.is64 = self.data[4] == 2
+        if self.is64:
+            (shoff,) = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x3a)
+            shdr = "<IIQQQQIIQQ"
+        else:
+            (shoff,) = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2e)
+            shdr = "<IIIIIIIIII"
+
+        raw = []
+        for i in range(shnum):
+            raw.append(struct.unpack_from(shdr, self.data, shoff + i * shentsize))
+
+        strtab = raw[shstrndx]
+        self.sections = []
+        for (name, type_, flags, addr, offset, size, link, info, align, entsize) in raw:
+            self.sections.append(Section(self._str(strtab[4], name), type_, addr,
+                                         offset, size, link, entsize))
+
+    def _str(self, offset, index):
+        start = offset + index
+        end = self.data.index(b"\0", start)
+        return self.data[start:end].decode("ascii", "replace")
+
+    def section(self, name):
+        """Return section with given name or None."""
+        for s in self.sections:
+            if s.name == name:
+                return s
+        return None
+
+    def contents(self, section):
+        """Return bytes of a section."""
+        return self.data[section.offset:section.offset + section.size]
+
+    def symbols(self):
+        """Return list of symbols from .symtab."""
+        result = []
+        for s in self.sections:
+            if s.type != SHT_SYMTAB:
+                continue
+            strtab = self.sections[s.link]
+            for i in range(s.size // s.entsize):
+                if self.is64:
+                    name, info, other, shndx, value, size = struct.unpack_from(
+                        "<IBBHQQ", self.data, s.offset + i * s.entsize)
+                else:
+                    name, value, size, info, other, shndx = struct.unpack_from(
+                        "<IIIBBH", self.data, s.offset + i * s.entsize)
+                result.append(Symbol(self._str(strtab.offset, name), value, size, info & 0x0f))
+        return result
+
+    def functions(self):
+        """Return function symbols sorted by address (Thumb bit cleared)."""
+        funcs = [Symbol(s.name, s.value & ~1, s.size, s.type)
+                 for s in self.symbols() if s.type == STT_FUNC]
+        funcs.sort(key=lambda s: s.value)
+        return funcs
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+Decoder for binary log frames (see app/src/log.c).
+
+Reads the serial stream (a capture file or stdin), prints
+ordinary text as it is and replaces log frames with messages
+formatted from the .logstr section of the firmware ELF file.
+Compass samples recorded over COMM (app/inc/recorder.h) are
+printed and, with --rec, saved to a recording file which can
+be replayed by the firmware or the host simulation. Trace
+events are printed raw, use trace2chrome.py to view them,
+and PC sample counts too, use pcprof.py to map them.
+
+Usage:
+    logdecode.py [--rec FILE] firmware.elf [capture.bin]
+    cat /dev/ttyUSB0 | logdecode.py firmware.elf
+
+Copyright (c) 2014 Michal Ksiezopolski.
+All rights reserved. This program and the
+accompanying materials are made available
+under the terms of the GNU Public License
+v3.0 which accompanies this distribution,
+and is available at
+http://www.gnu.org/licenses/gpl.html
+"""
+
+import re
+import struct
+import sys
+
+from elfutil import Elf
+
+SYNC1 = 0xa5
+SYNC2 = 0x5a
+ID_LOST = 0
+ID_REC = 1
+ID_TRACE = 2
+ID_PCPROF = 3
+
+# printf conversion: flags, width, precision, length, conversion
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l|z|j|t)?([diuxXocp%s])")
+
+
+def load_strings(elf_path):
+    """Return dictionary: string ID (address) -> format string."""
+    elf = Elf(elf_path)
+    section = elf.section(".logstr")
+    if section is None:
+        raise SystemExit("No .logstr section in %s" % elf_path)
+    data = elf.contents(section)
+    strings = {}
+    pos = 0
+    while pos < len(data):
+        end = data.find(b"\0", pos)
+        if end < 0:
+            break
+        if end > pos:
+            strings[section.addr + pos] = data[pos:end].decode("ascii", "replace")
+        # padding between strings is skipped as empty strings
+        pos = end + 1
+    return strings
+
+
+def format_message(fmt, args):
+    """Format printf style string with 32-bit argument words."""
+    args = list(args)
+
+    def convert(match):
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            return "%"
+        if not args:
+            return "<?>"
+        value = args.pop(0)
+        if conv in "di":
+            if value & 0x80000000:
+                value -= 1 << 32
+        elif conv == "p":
+            return "0x%08x" % value
+        elif conv == "s":
+            return "<str@0x%08x>" % value
+        elif conv == "c":
+            value = chr(value & 0xff)
+        spec = "%" + flags + width + (precision or "") + ("d" if conv in "iu" else conv)
+        return spec % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def format_record(record):
+    """Format 8 byte sample recorder record."""
+    if record[:2] == b"RC":
+        return "REC--> Header version %u config %02x %02x %02x" % tuple(record[2:6])
+    dt, x, y, z = struct.unpack("<Hhhh", record)
+    return "REC--> dt %u x %d y %d z %d" % (dt, x, y, z)
+
+
+def frames(stream, out=None):
+    """Split stream into log frames.
+
+    Yields (ID, time, payload) of every frame, text between
+    frames is written to out (dropped if out is None).
+    """
+    buf = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        buf += chunk
+
+        while buf:
+            if buf[0] != SYNC1:
+                # plain text
+                if out:
+                    out.write(chr(buf[0]))
+                del buf[0]
+                continue
+            if len(buf) < 2:
+                break
+            if buf[1] != SYNC2:
+                if out:
+                    out.write(chr(buf[0]))
+                del buf[0]
+                continue
+            if len(buf) < 3:
+                break
+            length = buf[2]
+            if len(buf) < 4 + length:
+                break
+            payload = bytes(buf[3:3 + length])
+            checksum = length
+            for b in payload:
+                checksum ^= b
+            if length < 8 or (length - 8) % 4 or checksum != buf[3 + length]:
+                if out:
+                    out.write(chr(buf[0])) # not a frame
+                del buf[0]
+                continue
+            del buf[:4 + length]
+
+            sid, time = struct.unpack_from("<II", payload)
+            yield sid, time, payload[8:]
+        if out:
+            out.flush()
+
+
+def decode(stream, strings, out, rec=None):
+    """Decode stream, write text to out and recorded samples to rec."""
+    for sid, time, data in frames(stream, out):
+        args = struct.unpack("<%dI" % (len(data) // 4), data)
+        if sid == ID_LOST:
+            text = "LOG--> %u records lost" % args[0]
+        elif sid == ID_REC and len(args) == 2:
+            text = format_record(data)
+            if rec:
+                rec.write(data)
+        elif sid == ID_TRACE and len(args) == 2:
+            text = "TRACE--> %10u info 0x%08x" % args
+        elif sid == ID_PCPROF and len(args) == 4 and args[0] == 0:
+            text = "PCPROF--> Header %u Hz, %u samples, %u dropped" % args[1:]
+        elif sid == ID_PCPROF and len(args) == 2:
+            text = "PCPROF--> 0x%08x %u" % args
+        elif sid in strings:
+            text = format_message(strings[sid], args)
+        else:
+            text = "<unknown log ID 0x%08x> %s" % (sid, " ".join("0x%x" % a for a in args))
+        out.write("[%10u] %s\r\n" % (time, text))
+
+
+def main():
+    argv = sys.argv[1:]
+    rec = None
+    if len(argv) > 1 and argv[0] == "--rec":
+        rec = open(argv[1], "wb")
+        argv = argv[2:]
+    if len(argv) < 1:
+        sys.exit(__doc__)
+    strings = load_strings(argv[0])
+    if len(argv) > 1:
+        stream = open(argv[1], "rb")
+    else:
+        stream = sys.stdin.buffer
+    try:
+        decode(stream, strings, sys.stdout, rec)
+    finally:
+        if rec:
+            rec.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Flat profile from PC sample counts (see app/src/pcprof.c).
+
+Reads the serial stream (a capture file or stdin) with the
+frames sent by :PCPROF, maps the sampled addresses to
+functions with the symbol table of the ELF file and prints
+the functions sorted by the number of samples. With --addr
+the hottest addresses are listed too, e.g. to find the
+loop in a function.
+
+For the host simulation pass build/sim as the ELF file -
+the simulator samples the host program counter.
+
+Usage:
+    pcprof.py [--addr N] firmware.elf [capture.bin]
+
+Copyright (c) 2014 Michal Ksiezopolski.
+All rights reserved. This program and the
+accompanying materials are made available
+under the terms of the GNU Public License
+v3.0 which accompanies this distribution,
+and is available at
+http://www.gnu.org/licenses/gpl.html
+"""
+
+import bisect
+import struct
+import sys
+
+from elfutil import Elf
+from logdecode import ID_PCPROF, frames
+
+
+def load_counts(stream):
+    """Return header (freq, samples, dropped) and counts of the last dump."""
+    header = None
+    counts = {}
+    for sid, time, data in frames(stream):
+        if sid != ID_PCPROF:
+            continue
+        if len(data) == 16:
+            zero, freq, samples, dropped = struct.unpack("<IIII", data)
+            if zero == 0:
+                header = (freq, samples, dropped)
+                counts = {}
+        elif len(data) == 8 and header:
+            pc, count = struct.unpack("<II", data)
+            counts[pc] = counts.get(pc, 0) + count
+    return header, counts
+
+
+class Symbols(object):
+    """Address to function lookup."""
+
+    def __init__(self, elf):
+        self.funcs = elf.functions()
+        self.starts = [f.value for f in self.funcs]
+
+    def lookup(self, addr):
+        """Return (function name, offset) or (None, 0)."""
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i < 0:
+            return None, 0
+        f = self.funcs[i]
+        if f.size:
+            end = f.value + f.size
+        elif i + 1 < len(self.funcs):
+            end = self.starts[i + 1] # assembly without size - up to the next one
+        else:
+            end = f.value
+        if addr >= end:
+            return None, 0
+        return f.name, addr - f.value
+
+
+def main():
+    argv = sys.argv[1:]
+    addrs = 0
+    if len(argv) > 1 and argv[0] == "--addr":
+        addrs = int(argv[1])
+        argv = argv[2:]
+    if len(argv) < 1:
+        sys.exit(__doc__)
+    symbols = Symbols(Elf(argv[0]))
+    if len(argv) > 1:
+        stream = open(argv[1], "rb")
+    else:
+        stream = sys.stdin.buffer
+    header, counts = load_counts(stream)
+    if header is None:
+        sys.exit("No PC sample dump found")
+
+    freq, samples, dropped = header
+    total = sum(counts.values())
+
+    funcs = {}
+    for pc, count in counts.items():
+        name, _ = symbols.lookup(pc)
+        name = name or "<unknown>"
+        funcs[name] = funcs.get(name, 0) + count
+
+    print("%u samples at %u Hz (%.2f s), %u dropped" %
+          (samples, freq, samples / float(freq), dropped))
+    if not total:
+        return
+
+    print("")
+    print("    %   cumul%  samples  function")
+    cumul = 0
+    for name, count in sorted(funcs.items(), key=lambda f: -f[1]):
+        cumul += count
+        print("%5.1f  %6.1f  %8u  %s" % (100.0 * count / total, 100.0 * cumul / total,
+                                         count, name))
+
+    if addrs:
+        print("")
+        print("    %  samples  address     function")
+        for pc, count in sorted(counts.items(), key=lambda c: -c[1])[:addrs]:
+            name, offset = symbols.lookup(pc)
+            where = "%s+0x%x" % (name, offset) if name else "<unknown>"
+            print("%5.1f  %8u  0x%08x  %s" % (100.0 * count / total, count, pc, where))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Converter of event trace dumps (see app/src/trace.c) to the
+Chrome trace event format.
+
+Reads the serial stream (a capture file or stdin) with the
+frames sent by :TRACE and writes JSON, which can be opened
+in chrome://tracing or https://ui.perfetto.dev. Names of the
+events are taken from TRACE_Id_TypeDef in app/inc/trace.h.
+
+Cycle counts are unwrapped and converted to microseconds
+with the core clock from the dump header. The overhead of
+writing an event (also from the header) is not subtracted.
+
+Usage:
+    trace2chrome.py [capture.bin] > trace.json
+    sim -R ... | trace2chrome.py > trace.json
+
+Copyright (c) 2014 Michal Ksiezopolski.
+All rights reserved. This program and the
+accompanying materials are made available
+under the terms of the GNU Public License
+v3.0 which accompanies this distribution,
+and is available at
+http://www.gnu.org/licenses/gpl.html
+"""
+
+import json
+import os
+import re
+import struct
+import sys
+
+from logdecode import ID_TRACE, frames
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      "..", "app", "inc", "trace.h")
+
+TYPE_BEGIN = 0
+TYPE_END = 1
+TYPE_INSTANT = 2
+TYPE_HEADER = 3
+
+# operations spanning several interrupts don't nest in the
+# CPU track - they get their own track
+TRACKS = {"I2C": 2}
+TRACK_NAMES = {1: "CPU", 2: "I2C bus"}
+
+
+def load_names(path):
+    """Return list of operation names from TRACE_Id_TypeDef."""
+    with open(path) as f:
+        text = f.read()
+    match = re.search(r"typedef enum \{([^}]*)\} TRACE_Id_TypeDef;", text)
+    if match is None:
+        raise SystemExit("No TRACE_Id_TypeDef in %s" % path)
+    return re.findall(r"^\s*TRACE_(\w+),", match.group(1), re.M)
+
+
+def load_dumps(stream):
+    """Return list of dumps: (clock, overhead, [(cycles, info), ...])."""
+    dumps = []
+    for sid, time, data in frames(stream):
+        if sid != ID_TRACE or len(data) != 8:
+            continue
+        cycles, info = struct.unpack("<II", data)
+        if info >> 24 == TYPE_HEADER:
+            dumps.append((cycles, info & 0xffff, []))
+        elif dumps:
+            dumps[-1][2].append((cycles, info))
+    return dumps
+
+
+def convert(dumps, names):
+    """Return list of Chrome trace events."""
+    events = []
+    for track, name in TRACK_NAMES.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": track,
+                       "args": {"name": name}})
+
+    offset = 0.0
+    for clock, _, raw in dumps:
+        if not raw:
+            continue
+        mhz = clock / 1e6
+
+        # unwrap the 32-bit counter - events in the ring are
+        # only roughly ordered, so deltas are signed
+        base = raw[0][0]
+        last = 0
+        stamped = []
+        for cycles, info in raw:
+            delta = (cycles - base) & 0xffffffff
+            if delta & 0x80000000:
+                delta -= 1 << 32
+            last += delta
+            base = cycles
+            stamped.append((last, info))
+        stamped.sort(key=lambda e: e[0])
+
+        start = stamped[0][0]
+        open_ = {}
+        for cycles, info in stamped:
+            type_ = info >> 24
+            op = (info >> 16) & 0xff
+            arg = info & 0xffff
+            name = names[op] if op < len(names) else "ID%u" % op
+            track = TRACKS.get(name, 1)
+            event = {"name": name, "pid": 1, "tid": track,
+                     "ts": offset + (cycles - start) / mhz, "args": {"arg": arg}}
+            if type_ == TYPE_BEGIN:
+                open_[op] = open_.get(op, 0) + 1
+                event["ph"] = "B"
+            elif type_ == TYPE_END:
+                if not open_.get(op):
+                    continue # begin overwritten in the ring
+                open_[op] -= 1
+                event["ph"] = "E"
+            elif type_ == TYPE_INSTANT:
+                event["ph"] = "i"
+                event["s"] = "t"
+            else:
+                continue
+            events.append(event)
+
+        # next dump after this one on the time line
+        offset += (stamped[-1][0] - start) / mhz + 1000.0
+    return events
+
+
+def main():
+    argv = sys.argv[1:]
+    if argv and argv[0].startswith("-"):
+        sys.exit(__doc__)
+    if argv:
+        stream = open(argv[0], "rb")
+    else:
+        stream = sys.stdin.buffer
+    names = load_names(HEADER)
+    dumps = load_dumps(stream)
+    if not dumps:
+        sys.exit("No trace dump found")
+    clock, overhead = dumps[-1][:2]
+    json.dump({"traceEvents": convert(dumps, names), "displayTimeUnit": "ns",
+               "otherData": {"clock": clock, "overhead cycles": overhead}},
+              sys.stdout, indent=0)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()